@@ -0,0 +1,178 @@
+/*
+ Project Name ------  FRS
+ Task --------------  Escalator Node Firmware with Esp32
+ Engineer ----------- Muhammad Usman
+ File --------------- Config Sync Source File
+ Company -----------  Machadev Pvt Limited
+ */
+
+// Import Libraries
+#include "config_sync.h"
+#include "protocol.h"
+#include <string.h>
+
+ConfigStore::ConfigStore() : selfId(0), onChange(nullptr) {
+    memset(versions, 0, sizeof(versions));
+    memset(values, 0, sizeof(values));
+}
+
+// Sets the node ID stamped on local writes.
+void ConfigStore::begin(uint8_t id, ChangeFn changeFn) {
+    selfId = id;
+    onChange = changeFn;
+}
+
+// Writes a field locally and bumps its version.
+bool ConfigStore::set(ConfigField field, const char* value) {
+    if (field >= CFG_FIELD_COUNT) {
+        return false;
+    }
+    if (value == nullptr) value = "";
+    size_t len = strnlen(value, CONFIG_VALUE_MAX - 1);
+    if (versions[field].counter != 0 && strncmp(values[field], value, len) == 0 &&
+        values[field][len] == '\0') {
+        return false; // unchanged, keep the version so no sync traffic is caused
+    }
+    store(field, value, len);
+    versions[field].counter++;
+    versions[field].writer = selfId;
+    return true;
+}
+
+// Restores a field and its version from persistent storage.
+void ConfigStore::restore(ConfigField field, const char* value, size_t len, FieldVersion version) {
+    if (field >= CFG_FIELD_COUNT) {
+        return;
+    }
+    if (len > CONFIG_VALUE_MAX - 1) len = CONFIG_VALUE_MAX - 1;
+    store(field, value, len);
+    versions[field] = version;
+}
+
+// Copies a value into its slot and terminates it.
+void ConfigStore::store(ConfigField field, const char* value, size_t len) {
+    memcpy(values[field], value, len);
+    values[field][len] = '\0';
+}
+
+// Returns an FNV-1a hash over all field versions.
+uint32_t ConfigStore::digest() const {
+    uint32_t hash = 2166136261UL;
+    for (uint8_t i = 0; i < CFG_FIELD_COUNT; i++) {
+        uint8_t bytes[3] = { (uint8_t)versions[i].counter, (uint8_t)(versions[i].counter >> 8),
+                             versions[i].writer };
+        for (uint8_t b : bytes) {
+            hash ^= b;
+            hash *= 16777619UL;
+        }
+    }
+    return hash;
+}
+
+// Encodes the version vector.
+size_t ConfigStore::encodeVector(uint8_t* out, size_t cap) const {
+    if (cap < CONFIG_VECTOR_LEN) {
+        return 0;
+    }
+    out[0] = MSG_SYNC_VECTOR;
+    out[1] = CFG_FIELD_COUNT;
+    uint8_t* p = out + 2;
+    for (uint8_t i = 0; i < CFG_FIELD_COUNT; i++) {
+        *p++ = (uint8_t)versions[i].counter;
+        *p++ = (uint8_t)(versions[i].counter >> 8);
+        *p++ = versions[i].writer;
+    }
+    return CONFIG_VECTOR_LEN;
+}
+
+// Reads one entry of a peer's vector; fields the peer does not know are version 0.
+FieldVersion ConfigStore::vectorEntry(const uint8_t* vector, size_t len, uint8_t field) {
+    FieldVersion v = {0, 0};
+    if (len >= 2 && field < vector[1] && len >= 2 + 3 * (size_t)(field + 1)) {
+        const uint8_t* p = vector + 2 + 3 * field;
+        v.counter = (uint16_t)(p[0] | (p[1] << 8));
+        v.writer = p[2];
+    }
+    return v;
+}
+
+// Returns true if the vector holds any field newer than ours.
+bool ConfigStore::peerHasNewer(const uint8_t* vector, size_t len) const {
+    for (uint8_t i = 0; i < CFG_FIELD_COUNT; i++) {
+        if (newer(vectorEntry(vector, len, i), versions[i])) {
+            return true;
+        }
+    }
+    return false;
+}
+
+// Encodes the fields that are newer here than in a peer's vector.
+size_t ConfigStore::encodeDelta(const uint8_t* vector, size_t len, uint8_t* out, size_t cap) const {
+    if (cap < 2) {
+        return 0;
+    }
+    size_t used = 2;
+    uint8_t count = 0;
+    for (uint8_t i = 0; i < CFG_FIELD_COUNT; i++) {
+        if (!newer(versions[i], vectorEntry(vector, len, i))) {
+            continue;
+        }
+        size_t valueLen = strlen(values[i]);
+        if (used + 5 + valueLen > cap) {
+            break; // the rest goes out in the next round
+        }
+        uint8_t* p = out + used;
+        p[0] = i;
+        p[1] = (uint8_t)versions[i].counter;
+        p[2] = (uint8_t)(versions[i].counter >> 8);
+        p[3] = versions[i].writer;
+        p[4] = (uint8_t)valueLen;
+        memcpy(p + 5, values[i], valueLen);
+        used += 5 + valueLen;
+        count++;
+    }
+    if (count == 0) {
+        return 0;
+    }
+    out[0] = MSG_SYNC_DELTA;
+    out[1] = count;
+    return used;
+}
+
+// Merges a delta with last-writer-wins.
+int ConfigStore::applyDelta(const uint8_t* delta, size_t len) {
+    if (len < 2 || delta[0] != MSG_SYNC_DELTA) {
+        return -1;
+    }
+    size_t pos = 2;
+    for (uint8_t n = 0; n < delta[1]; n++) {
+        if (pos + 5 > len) {
+            return -1;
+        }
+        size_t valueLen = delta[pos + 4];
+        if (pos + 5 + valueLen > len || valueLen >= CONFIG_VALUE_MAX) {
+            return -1;
+        }
+        pos += 5 + valueLen;
+    }
+
+    // Every entry is in bounds, so nothing is applied from a truncated delta
+    int changed = 0;
+    pos = 2;
+    for (uint8_t n = 0; n < delta[1]; n++) {
+        const uint8_t* p = delta + pos;
+        uint8_t field = p[0];
+        FieldVersion incoming = { (uint16_t)(p[1] | (p[2] << 8)), p[3] };
+        size_t valueLen = p[4];
+        pos += 5 + valueLen;
+
+        if (field >= CFG_FIELD_COUNT || !newer(incoming, versions[field])) {
+            continue; // unknown field from newer firmware, or ours already wins
+        }
+        store((ConfigField)field, (const char*)(p + 5), valueLen);
+        versions[field] = incoming;
+        changed++;
+        if (onChange) onChange((ConfigField)field);
+    }
+    return changed;
+}
@@ -0,0 +1,157 @@
+/*
+ Project Name ------  FRS
+ Task --------------  Escalator Node Firmware with Esp32
+ Engineer ----------- Muhammad Usman
+ File --------------- Config Sync Header File
+ Company -----------  Machadev Pvt Limited
+ */
+
+// config_sync.h
+#ifndef CONFIG_SYNC_H
+#define CONFIG_SYNC_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+/*
+ Every portal field carries a version (counter, writer node ID). A local
+ edit bumps the counter; when two nodes disagree the higher counter wins,
+ ties going to the higher writer ID (last-writer-wins).
+
+ Sync rounds:
+   1. Each node's presence beacon carries the digest (hash of all
+      versions); a bare MSG_SYNC_DIGEST frame is still understood.
+   2. A neighbour with a different digest sends its version vector.
+   3. The receiver answers with a delta holding only the fields it has
+      newer, and sends its own vector back if the peer has newer ones.
+*/
+
+enum ConfigField : uint8_t {
+    // Company details (P7)
+    CFG_COMPANY_NAME,
+    CFG_COMPANY_ADDRESS,
+    CFG_KEY_PERSON,
+    CFG_CONTACT_DETAILS,
+    CFG_ALT_PERSON_1,
+    CFG_ALT_CONTACT_1,
+    CFG_ALT_PERSON_2,
+    CFG_ALT_CONTACT_2,
+    CFG_ALT_PERSON_3,
+    CFG_ALT_CONTACT_3,
+    CFG_ALT_PERSON_4,
+    CFG_ALT_CONTACT_4,
+    CFG_FIRE_DEPARTMENT,
+    CFG_FIRE_DEPARTMENT_CONTACT,
+    // Unit details (P8)
+    CFG_UNIT_LOCATION,
+    CFG_UNIT_NUMBER,
+    CFG_UNIT_DATE,
+    CFG_UNIT_INSTALLER,
+    CFG_UNIT_CONTACT,
+    CFG_UNIT_IP_ADDRESS,
+    // Manufacturer details (P9)
+    CFG_MFR_NAME,
+    CFG_MFR_CONTACT,
+    CFG_MFR_EMAIL,
+    CFG_MFR_DATE,
+    CFG_MFR_SERIAL,
+    // Access point credentials (P11)
+    CFG_AP_SSID,
+    CFG_AP_PASSWORD,
+
+    CFG_FIELD_COUNT
+};
+
+constexpr size_t CONFIG_VALUE_MAX = 96;   // including the terminating NUL
+constexpr size_t CONFIG_VECTOR_LEN = 2 + 3 * CFG_FIELD_COUNT;
+
+struct FieldVersion {
+    uint16_t counter;   // 0 means the field was never written
+    uint8_t writer;
+};
+
+class ConfigStore {
+public:
+    // Called for every field changed by a merged delta.
+    typedef void (*ChangeFn)(ConfigField field);
+
+    ConfigStore();
+
+    /**
+     * @brief Sets the node ID stamped on local writes.
+     */
+    void begin(uint8_t selfId, ChangeFn onChange = nullptr);
+
+    /**
+     * @brief Writes a field locally and bumps its version.
+     *
+     * Values longer than CONFIG_VALUE_MAX - 1 are truncated; nullptr is
+     * stored as an empty string.
+     *
+     * @return true if the value changed, false if it was already equal.
+     */
+    bool set(ConfigField field, const char* value);
+
+    const char* get(ConfigField field) const { return values[field]; }
+    FieldVersion version(ConfigField field) const { return versions[field]; }
+
+    /**
+     * @brief Restores a field and its version from persistent storage.
+     *
+     * Unlike set(), the version is taken as given and onChange is not called.
+     */
+    void restore(ConfigField field, const char* value, size_t len, FieldVersion version);
+
+    /**
+     * @brief Returns a hash over all field versions.
+     *
+     * Two stores with the same digest hold the same values.
+     */
+    uint32_t digest() const;
+
+    /**
+     * @brief Encodes [MSG_SYNC_VECTOR][count][counter lo, hi, writer]...
+     *
+     * @return The number of bytes written, or 0 if cap is too small.
+     */
+    size_t encodeVector(uint8_t* out, size_t cap) const;
+
+    /**
+     * @brief Returns true if the vector holds any field newer than ours.
+     */
+    bool peerHasNewer(const uint8_t* vector, size_t len) const;
+
+    /**
+     * @brief Encodes the fields that are newer here than in a peer's vector.
+     *
+     * Format: [MSG_SYNC_DELTA][count] then per field
+     * [id][counter lo, hi][writer][len][value bytes]. Fields that do not
+     * fit in cap are left for the next sync round.
+     *
+     * @return The number of bytes written, or 0 if there is nothing to send.
+     */
+    size_t encodeDelta(const uint8_t* vector, size_t len, uint8_t* out, size_t cap) const;
+
+    /**
+     * @brief Merges a delta with last-writer-wins.
+     *
+     * The whole delta is checked first, so a malformed one changes nothing.
+     *
+     * @return The number of fields that changed, or -1 if the delta is malformed.
+     */
+    int applyDelta(const uint8_t* delta, size_t len);
+
+private:
+    static bool newer(FieldVersion a, FieldVersion b) {
+        return a.counter > b.counter || (a.counter == b.counter && a.writer > b.writer);
+    }
+    static FieldVersion vectorEntry(const uint8_t* vector, size_t len, uint8_t field);
+    void store(ConfigField field, const char* value, size_t len);
+
+    uint8_t selfId;
+    ChangeFn onChange;
+    FieldVersion versions[CFG_FIELD_COUNT];
+    char values[CFG_FIELD_COUNT][CONFIG_VALUE_MAX];
+};
+
+#endif // CONFIG_SYNC_H
@@ -10,21 +10,79 @@
 #ifndef CONSTANTS_H
 #define CONSTANTS_H
 #include <Arduino.h>
+#include "protocol.h"
+#include "relay_groups.h"
+
+/*
+ Node role and site parameters are fixed at compile time; each env in
+ platformio.ini builds the image of one role and node through these
+ build flags:
+
+   -D FRS_ROLE_CONTROLLER   controller image; the escalator is the default
+   -D FRS_NODE_ID=n         mesh address, 1 .. 254
+   -D FRS_MAX_NODES=n       size of the node table
+
+ Code that only one role runs sits under #if FRS_ESCALATOR and is left
+ out of the other image. The host builds take their address from
+ hostRadioAddress() at run time, so FRS_NODE_ID does not matter there.
+*/
+
+#if defined(FRS_ROLE_CONTROLLER)
+#define FRS_ESCALATOR 0
+#else
+#define FRS_ESCALATOR 1
+#endif
+
+#ifndef FRS_NODE_ID
+#define FRS_NODE_ID 7
+#endif
+
+#ifndef FRS_MAX_NODES
+#define FRS_MAX_NODES 32
+#endif
 
 extern TaskHandle_t xHandleLoRa;
 
 // Baud Rates
-extern const int Baud_RATE_SERIAL;
-extern const int Baud_RATE_LORA;
+constexpr int Baud_RATE_SERIAL = 115200;
+constexpr int Baud_RATE_LORA = 9600;
 
 //  LoRa Pins
-extern const int MOPIN;
-extern const int M1PIN;
-extern const int AUXPIN;
-extern const int NODEID;
-extern const int RLYPIN;
-extern const int MAX_NODES; // not currently used
+constexpr int MOPIN = 18;
+constexpr int M1PIN = 19;
+constexpr int AUXPIN = 5;
+constexpr int LORA_RXPIN = 16;  // UART2, the pins Serial2 used
+constexpr int LORA_TXPIN = 17;
+
+constexpr uint8_t NODEID = FRS_NODE_ID;
+constexpr NodeRole NODE_ROLE = FRS_ESCALATOR ? ROLE_ESCALATOR : ROLE_CONTROLLER;
+constexpr uint16_t MAX_NODES = FRS_MAX_NODES;  // other nodes this node keeps track of
+constexpr const char* AP_SSID = FRS_ESCALATOR ? "FRS-Escalator" : "FRS-FyreBox";  // until the wizard stores one
+constexpr const char* AP_PASSWORD = "FRS12345678";
+constexpr size_t AP_SSID_MAX = 32;          // 802.11 limit
+constexpr size_t AP_PASSWORD_MIN = 8;       // WPA2-PSK passphrase
+constexpr size_t AP_PASSWORD_MAX = 63;
+
+static_assert(((RELAY_RESERVED_PINS >> MOPIN) & (RELAY_RESERVED_PINS >> M1PIN) & (RELAY_RESERVED_PINS >> AUXPIN) &
+               (RELAY_RESERVED_PINS >> LORA_RXPIN) & (RELAY_RESERVED_PINS >> LORA_TXPIN) & 1) != 0,
+              "the E32 pins must be in RELAY_RESERVED_PINS");
+static_assert(FRS_NODE_ID >= 1 && FRS_NODE_ID <= 254, "FRS_NODE_ID must be a unicast mesh address");
+static_assert(FRS_MAX_NODES >= 1 && FRS_MAX_NODES <= 256, "one entry per mesh address at most");
+
+#if FRS_ESCALATOR
+constexpr int RLYPIN = 21;
+
+// Relay groups on this node: { site group, GPIO mask }. Add a row per
+// escalator of a bank; group 0 is the single relay on RLYPIN.
+constexpr RelayGroup RELAY_GROUPS[] = {
+    { 0, 1u << RLYPIN },
+};
+constexpr uint8_t RELAY_GROUP_COUNT = sizeof(RELAY_GROUPS) / sizeof(RELAY_GROUPS[0]);
+static_assert(RELAY_GROUP_COUNT <= RELAY_GROUP_MAX, "RelayBank holds RELAY_GROUP_MAX groups");
+static_assert(relayGroupsValid(RELAY_GROUPS, RELAY_GROUP_COUNT),
+              "a relay group has no pins, a reserved or nonexistent pin, or a bad site group");
 
 extern bool activateRelayonce;
+#endif
 
 #endif // CONSTANTS_H
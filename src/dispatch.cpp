@@ -0,0 +1,72 @@
+/*
+ Project Name ------  FRS
+ Task --------------  Escalator Node Firmware with Esp32
+ Engineer ----------- Muhammad Usman
+ File --------------- Message Dispatch Source File
+ Company -----------  Machadev Pvt Limited
+ */
+
+// Import Libraries
+#include "dispatch.h"
+#include <string.h>
+
+// Text messages of the original protocol, sent with their terminating NUL.
+struct TextMessage {
+    const char* text;
+    uint8_t type;
+};
+
+static const TextMessage kTextMessages[] = {
+    { "Active", MSG_ACTIVE },
+    { "Inactive", MSG_INACTIVE },
+    { "Node Present", MSG_PRESENCE },
+    { "Actived", MSG_ACTIVATED },
+    { "Deactived", MSG_DEACTIVATED },
+};
+
+MessageDispatcher::MessageDispatcher(const MessageHandler* table, NodeRole role)
+    : table(table), role(role) {
+    memset(&counters, 0, sizeof(counters));
+}
+
+// Looks up a text frame; the NUL terminator is optional.
+uint8_t MessageDispatcher::textType(const uint8_t* frame, uint8_t len) {
+    if (len > 0 && frame[len - 1] == '\0') {
+        len--;
+    }
+    for (const TextMessage& msg : kTextMessages) {
+        if (strlen(msg.text) == len && memcmp(msg.text, frame, len) == 0) {
+            return msg.type;
+        }
+    }
+    return 0;
+}
+
+// Validates the frame against its table entry and runs the handler.
+bool MessageDispatcher::dispatch(const FrameRef& frame) {
+    const uint8_t* msg = frame->data;
+    uint8_t len = frame->len;
+    uint8_t legacy[1];
+    if (!isBinaryFrame(msg, len)) {
+        legacy[0] = textType(msg, len);
+        if (legacy[0] == 0) {
+            counters.unknownText++;
+            return false;
+        }
+        msg = legacy;
+        len = sizeof(legacy);
+    }
+
+    const MessageHandler& entry = table[msg[0]];
+    if (entry.fn == nullptr || (entry.roles & role) == 0) {
+        counters.unhandled++;
+        return false;
+    }
+    if (len < entry.minLen || len > entry.maxLen) {
+        counters.badLength++;
+        return false;
+    }
+    counters.dispatched++;
+    entry.fn(frame, msg, len);
+    return true;
+}
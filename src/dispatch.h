@@ -0,0 +1,83 @@
+/*
+ Project Name ------  FRS
+ Task --------------  Escalator Node Firmware with Esp32
+ Engineer ----------- Muhammad Usman
+ File --------------- Message Dispatch Header File
+ Company -----------  Machadev Pvt Limited
+ */
+
+// dispatch.h
+#ifndef DISPATCH_H
+#define DISPATCH_H
+
+#include <stdint.h>
+#include "frame_pool.h"
+#include "protocol.h"
+
+/*
+ Received frames are dispatched through a const table indexed by the
+ message type byte, so the cost per frame is one lookup no matter how
+ many message types exist. Each entry carries the roles it is registered
+ for and the frame length it accepts; a frame is checked against both
+ before its handler runs.
+
+ The printable text messages of the original protocol ("Active",
+ "Node Present", ...) are mapped to their message type first and then
+ take the same path, as a one-byte frame.
+
+ Handlers get the pooled frame itself (frame_pool.h), with its sender
+ and receive time, and may keep a reference to it beyond the call.
+*/
+
+// Handles one frame; msg[0] is the message type. msg is frame->data unless a text frame was mapped.
+typedef void (*MessageHandlerFn)(const FrameRef& frame, const uint8_t* msg, uint8_t len);
+
+struct MessageHandler {
+    MessageHandlerFn fn;
+    uint8_t minLen;     // including the type byte
+    uint8_t maxLen;
+    uint8_t roles;      // NodeRole bits this handler is registered for
+};
+
+struct DispatchStats {
+    uint32_t dispatched;
+    uint32_t unhandled;    // no handler for this type and role
+    uint32_t badLength;
+    uint32_t unknownText;  // printable frame that is not a known text message
+};
+
+class MessageDispatcher {
+public:
+    /**
+     * @brief Creates a dispatcher over a handler table.
+     *
+     * @param table MSG_BINARY_LIMIT entries indexed by message type; unused
+     *              types have a null fn.
+     * @param role The role of this node.
+     */
+    MessageDispatcher(const MessageHandler* table, NodeRole role);
+
+    /**
+     * @brief Runs the handler for one received frame.
+     *
+     * @param frame The received frame, binary or legacy text.
+     * @return True if a handler ran.
+     */
+    bool dispatch(const FrameRef& frame);
+
+    /**
+     * @brief Maps a legacy text frame to its message type.
+     *
+     * @return The message type, or 0 if the text is not a known message.
+     */
+    static uint8_t textType(const uint8_t* frame, uint8_t len);
+
+    const DispatchStats& stats() const { return counters; }
+
+private:
+    const MessageHandler* table;
+    NodeRole role;
+    DispatchStats counters;
+};
+
+#endif // DISPATCH_H
@@ -0,0 +1,80 @@
+/*
+ Project Name ------  FRS
+ Task --------------  Escalator Node Firmware with Esp32
+ Engineer ----------- Muhammad Usman
+ File --------------- Fountain Code Source File
+ Company -----------  Machadev Pvt Limited
+ */
+
+// Import Libraries
+#include "fountain.h"
+#include <string.h>
+
+static_assert(FOUNTAIN_GEN_SYMBOLS == 32, "coefficient masks are 32 bits");
+
+static inline void xorSymbol(uint8_t* dst, const uint8_t* src) {
+    for (uint8_t i = 0; i < FOUNTAIN_SYMBOL_LEN; i++) {
+        dst[i] ^= src[i];
+    }
+}
+
+// xorshift32 over a mix of the three inputs; the sender and every receiver get the same mask.
+uint32_t fountainCoefficients(uint16_t imageId, uint16_t generation, uint16_t seed) {
+    if (seed < FOUNTAIN_GEN_SYMBOLS) {
+        return 1UL << seed;
+    }
+    uint32_t x = ((uint32_t)imageId << 16 | generation) * 0x9E3779B1UL ^ (uint32_t)seed * 0x85EBCA77UL;
+    for (uint8_t i = 0; i < 3; i++) {
+        x ^= x << 13;
+        x ^= x >> 17;
+        x ^= x << 5;
+    }
+    return x != 0 ? x : 1;
+}
+
+void fountainEncode(const uint8_t* source, uint32_t coefficients, uint8_t* symbol) {
+    memset(symbol, 0, FOUNTAIN_SYMBOL_LEN);
+    while (coefficients != 0) {
+        uint8_t bit = (uint8_t)__builtin_ctz(coefficients);
+        xorSymbol(symbol, source + (size_t)bit * FOUNTAIN_SYMBOL_LEN);
+        coefficients &= coefficients - 1;
+    }
+}
+
+void FountainDecoder::reset(uint16_t generation) {
+    pivots = 0;
+    count = 0;
+    gen = generation;
+}
+
+bool FountainDecoder::add(uint32_t coefficients, const uint8_t* symbol) {
+    uint8_t data[FOUNTAIN_SYMBOL_LEN];
+    memcpy(data, symbol, sizeof(data));
+    while (coefficients != 0) {
+        uint8_t bit = (uint8_t)__builtin_ctz(coefficients);
+        if ((pivots & (1UL << bit)) == 0) {
+            coeffs[bit] = coefficients;
+            memcpy(rows[bit], data, sizeof(data));
+            pivots |= 1UL << bit;
+            count++;
+            return true;
+        }
+        coefficients ^= coeffs[bit];  // clears bit, only touches higher ones
+        xorSymbol(data, rows[bit]);
+    }
+    return false;
+}
+
+// Rows are upper triangular; solving from the top bit down leaves each row with its pivot only.
+void FountainDecoder::solve(uint8_t* source) {
+    for (int8_t bit = FOUNTAIN_GEN_SYMBOLS - 1; bit >= 0; bit--) {
+        uint32_t higher = coeffs[bit] & ~(1UL << bit);
+        while (higher != 0) {
+            uint8_t h = (uint8_t)__builtin_ctz(higher);
+            xorSymbol(rows[bit], rows[h]);
+            higher &= higher - 1;
+        }
+        coeffs[bit] = 1UL << bit;
+        memcpy(source + (size_t)bit * FOUNTAIN_SYMBOL_LEN, rows[bit], FOUNTAIN_SYMBOL_LEN);
+    }
+}
@@ -0,0 +1,85 @@
+/*
+ Project Name ------  FRS
+ Task --------------  Escalator Node Firmware with Esp32
+ Engineer ----------- Muhammad Usman
+ File --------------- Fountain Code Header File
+ Company -----------  Machadev Pvt Limited
+ */
+
+// fountain.h
+#ifndef FOUNTAIN_H
+#define FOUNTAIN_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+/*
+ Random linear fountain code over GF(2), applied per generation.
+
+ An image is cut into generations of FOUNTAIN_GEN_SYMBOLS symbols of
+ FOUNTAIN_SYMBOL_LEN bytes. A coded symbol is the XOR of the source
+ symbols picked by a 32-bit coefficient mask. The mask is derived from
+ (image, generation, seed), so a frame only carries the 16-bit seed.
+ Seeds below FOUNTAIN_GEN_SYMBOLS pick one source symbol each; these
+ systematic symbols cost nothing to decode. Higher seeds give random
+ combinations. A receiver needs any FOUNTAIN_GEN_SYMBOLS linearly
+ independent symbols of a generation, whichever ones it happens to catch,
+ so one repair symbol fills a different gap at every node.
+*/
+
+constexpr uint8_t FOUNTAIN_SYMBOL_LEN = 32;
+constexpr uint8_t FOUNTAIN_GEN_SYMBOLS = 32;  // one bit each in the coefficient mask
+constexpr size_t FOUNTAIN_GEN_BYTES = (size_t)FOUNTAIN_SYMBOL_LEN * FOUNTAIN_GEN_SYMBOLS;
+
+/**
+ * @brief Coefficient mask of a coded symbol; never zero.
+ */
+uint32_t fountainCoefficients(uint16_t imageId, uint16_t generation, uint16_t seed);
+
+/**
+ * @brief Builds one coded symbol of a generation.
+ *
+ * @param source FOUNTAIN_GEN_BYTES of the generation, zero padded at the end of the image.
+ */
+void fountainEncode(const uint8_t* source, uint32_t coefficients, uint8_t* symbol);
+
+/**
+ * @brief Online Gaussian elimination for one generation.
+ *
+ * Each received symbol is reduced against the rows held so far as it
+ * arrives, so the work is spread over the reception and solve() only
+ * back-substitutes.
+ */
+class FountainDecoder {
+public:
+    FountainDecoder() { reset(0); }
+
+    void reset(uint16_t generation);
+
+    /**
+     * @brief Adds a received symbol.
+     *
+     * @return True if the symbol raised the rank.
+     */
+    bool add(uint32_t coefficients, const uint8_t* symbol);
+
+    uint8_t rank() const { return count; }
+    bool complete() const { return count == FOUNTAIN_GEN_SYMBOLS; }
+    uint16_t generation() const { return gen; }
+
+    /**
+     * @brief Recovers the source symbols once complete().
+     *
+     * @param source Receives FOUNTAIN_GEN_BYTES.
+     */
+    void solve(uint8_t* source);
+
+private:
+    uint32_t coeffs[FOUNTAIN_GEN_SYMBOLS];   // row b has its lowest set bit at b
+    uint8_t rows[FOUNTAIN_GEN_SYMBOLS][FOUNTAIN_SYMBOL_LEN];
+    uint32_t pivots;
+    uint8_t count;
+    uint16_t gen;
+};
+
+#endif // FOUNTAIN_H
@@ -0,0 +1,101 @@
+/*
+ Project Name ------  FRS
+ Task --------------  Escalator Node Firmware with Esp32
+ Engineer ----------- Muhammad Usman
+ File --------------- Frame Pool Source File
+ Company -----------  Machadev Pvt Limited
+ */
+
+// Import Libraries
+#include "frame_pool.h"
+
+static_assert(FRAME_POOL_SIZE <= 32, "the free mask has 32 bits");
+
+FramePool::FramePool()
+    : freeMask(FRAME_POOL_SIZE == 32 ? 0xFFFFFFFFu : (1u << FRAME_POOL_SIZE) - 1),
+      acquiredCount(0), exhaustedCount(0), highWater(0) {
+    for (FrameBuffer& frame : buffers) {
+        frame.len = 0;
+        frame.refs.store(0);
+    }
+}
+
+FrameBuffer* FramePool::acquire() {
+    FrameBuffer* frame = tryAcquire();
+    if (frame == nullptr) {
+        exhaustedCount++;
+    }
+    return frame;
+}
+
+// Claims the lowest free bit with a compare-and-swap, so no lock is needed.
+FrameBuffer* FramePool::tryAcquire() {
+    uint32_t mask = freeMask.load();
+    for (;;) {
+        if (mask == 0) {
+            return nullptr;
+        }
+        uint32_t bit = mask & (~mask + 1);
+        if (freeMask.compare_exchange_weak(mask, mask & ~bit)) {
+            uint8_t index = (uint8_t)__builtin_ctz(bit);
+            FrameBuffer* frame = &buffers[index];
+            frame->refs.store(1);
+            frame->len = 0;
+            acquiredCount++;
+
+            uint8_t inUse = (uint8_t)(FRAME_POOL_SIZE - __builtin_popcount(mask & ~bit));
+            uint8_t high = highWater.load();
+            while (inUse > high && !highWater.compare_exchange_weak(high, inUse)) {
+            }
+            return frame;
+        }
+    }
+}
+
+void FramePool::retain(FrameBuffer* frame) {
+    frame->refs.fetch_add(1);
+}
+
+void FramePool::release(FrameBuffer* frame) {
+    if (frame->refs.fetch_sub(1) == 1) {
+        freeMask.fetch_or(1u << (frame - buffers));
+    }
+}
+
+FramePoolStats FramePool::stats() const {
+    FramePoolStats s;
+    s.acquired = acquiredCount.load();
+    s.exhausted = exhaustedCount.load();
+    s.inUse = (uint8_t)(FRAME_POOL_SIZE - __builtin_popcount(freeMask.load()));
+    s.highWater = highWater.load();
+    return s;
+}
+
+// A logged frame that a snapshot or a handler still holds frees nothing, so
+// dropping goes on, oldest first, until a buffer comes free.
+FrameRef FrameLog::acquire() {
+    FrameBuffer* buffer = pool.tryAcquire();
+    for (uint8_t i = 0; i < FRAME_LOG_LEN && buffer == nullptr; i++) {
+        FrameRef& oldest = entries[(next + i) % FRAME_LOG_LEN];
+        if (oldest) {
+            oldest.reset();
+            evictedCount++;
+            buffer = pool.tryAcquire();
+        }
+    }
+    if (buffer == nullptr) {
+        buffer = pool.acquire();   // counts the miss, unless another task released one meanwhile
+    }
+    return buffer ? FrameRef(pool, buffer) : FrameRef();
+}
+
+void FrameLog::add(const FrameRef& frame) {
+    entries[next] = frame;
+    next = (next + 1) % FRAME_LOG_LEN;
+}
+
+void FrameLog::copy(FrameRef (&out)[FRAME_LOG_LEN]) const {
+    for (uint8_t i = 0; i < FRAME_LOG_LEN; i++) {
+        out[i] = entries[(next + i) % FRAME_LOG_LEN];
+    }
+}
@@ -0,0 +1,154 @@
+/*
+ Project Name ------  FRS
+ Task --------------  Escalator Node Firmware with Esp32
+ Engineer ----------- Muhammad Usman
+ File --------------- Frame Pool Header File
+ Company -----------  Machadev Pvt Limited
+ */
+
+// frame_pool.h
+#ifndef FRAME_POOL_H
+#define FRAME_POOL_H
+
+#include <atomic>
+#include <stdint.h>
+#include "protocol.h"
+
+/*
+ Received frames live in a fixed pool of reference-counted buffers. The
+ radio fills a buffer once; the dispatcher, the handlers, the serial
+ logger and the /frames web stream all read the same bytes through a
+ FrameRef, and the buffer goes back to the pool when the last reference
+ is dropped. Both the LoRa task and loop() touch frames, so the free
+ list and the reference counts are atomics.
+
+ The pool holds the frame log and one frame being received. A second
+ receiving task, a /frames snapshot or a frame a handler keeps take
+ their buffers from the log, which drops its oldest frames for them and
+ counts each one. Only when the log has nothing left to give is the
+ pool exhausted; the receiver then leaves the frame in the E32 and
+ tries again after FRAME_POOL_BACKOFF_MS.
+*/
+
+constexpr uint8_t FRAME_LOG_LEN = 6;      // recent frames kept for /frames
+constexpr uint8_t FRAME_POOL_SIZE = FRAME_LOG_LEN + 1;   // at most 32, one bit each in the free mask
+constexpr uint8_t FRAME_POOL_BACKOFF_MS = 20;  // wait when the pool is empty; the E32 keeps the frame
+
+struct FrameBuffer {
+    uint8_t data[MESH_FRAME_MAX_LEN];
+    uint8_t len;
+    uint8_t from;
+    uint32_t seq;               // receive order, for the log
+    unsigned long receivedAt;   // millis()
+    std::atomic<uint8_t> refs;
+};
+
+struct FramePoolStats {
+    uint32_t acquired;
+    uint32_t exhausted;   // acquire() calls that found no free buffer
+    uint8_t inUse;
+    uint8_t highWater;
+};
+
+class FramePool {
+public:
+    FramePool();
+
+    /**
+     * @brief Takes a free buffer with one reference.
+     *
+     * @return The buffer, or nullptr if every buffer is referenced; counted as exhausted.
+     */
+    FrameBuffer* acquire();
+
+    // Same, but a miss is not counted; for callers that can still free a buffer.
+    FrameBuffer* tryAcquire();
+
+    // Adds a reference to a buffer from this pool.
+    void retain(FrameBuffer* frame);
+
+    // Drops a reference; the last one returns the buffer to the pool.
+    void release(FrameBuffer* frame);
+
+    FramePoolStats stats() const;
+
+private:
+    FrameBuffer buffers[FRAME_POOL_SIZE];
+    std::atomic<uint32_t> freeMask;
+    std::atomic<uint32_t> acquiredCount;
+    std::atomic<uint32_t> exhaustedCount;
+    std::atomic<uint8_t> highWater;
+};
+
+/**
+ * @brief Counted handle to a pooled frame.
+ *
+ * Copying adds a reference, destruction drops one. An empty FrameRef
+ * holds nothing.
+ */
+class FrameRef {
+public:
+    FrameRef() : pool(nullptr), frame(nullptr) {}
+    // Adopts the reference returned by FramePool::acquire().
+    FrameRef(FramePool& pool, FrameBuffer* frame) : pool(&pool), frame(frame) {}
+    FrameRef(const FrameRef& other) : pool(other.pool), frame(other.frame) {
+        if (frame) pool->retain(frame);
+    }
+    FrameRef& operator=(const FrameRef& other) {
+        if (other.frame) other.pool->retain(other.frame);
+        reset();
+        pool = other.pool;
+        frame = other.frame;
+        return *this;
+    }
+    ~FrameRef() { reset(); }
+
+    void reset() {
+        if (frame) pool->release(frame);
+        frame = nullptr;
+    }
+
+    FrameBuffer* get() const { return frame; }
+    FrameBuffer* operator->() const { return frame; }
+    explicit operator bool() const { return frame != nullptr; }
+
+private:
+    FramePool* pool;
+    FrameBuffer* frame;
+};
+
+/**
+ * @brief The most recent frames, kept for /frames.
+ *
+ * Not thread safe; the caller holds a lock around every call.
+ */
+class FrameLog {
+public:
+    explicit FrameLog(FramePool& pool) : pool(pool), next(0), evictedCount(0) {}
+
+    /**
+     * @brief Takes a receive buffer, dropping the oldest logged frames
+     *        until one comes free if the pool is empty.
+     *
+     * @return An empty FrameRef when the log holds no buffer that would
+     *         free one; the caller backs off.
+     */
+    FrameRef acquire();
+
+    // Keeps a reference to a frame in place of the oldest.
+    void add(const FrameRef& frame);
+
+    // Copies the references out, oldest first; slots never filled or dropped are empty.
+    void copy(FrameRef (&out)[FRAME_LOG_LEN]) const;
+
+    // Logged frames dropped to free a buffer.
+    uint32_t evicted() const { return evictedCount; }
+
+private:
+    FramePool& pool;
+    FrameRef entries[FRAME_LOG_LEN];
+    uint8_t next;           // the oldest entry, overwritten next
+    uint32_t evictedCount;
+};
+
+#endif // FRAME_POOL_H
@@ -9,12 +9,171 @@
 // Import Libraries
 #include "functions.h"
 #include "constants.h"
+#include "transport.h"
+#include "dispatch.h"
+#include "frame_pool.h"
+#if FRS_ESCALATOR
+#include "fw_update.h"
+#endif
+#include "time_sync.h"
+#include "tdma.h"
+#include "config_sync.h"
+#include "site_store.h"
+#include "journal.h"
+#include "profiler.h"
+#include "uart_link.h"
+#include "radio_trace.h"
+#include "power.h"
 #include <EEPROM.h>
 
-RH_E32 driver(&Serial2, MOPIN, M1PIN, AUXPIN); //M0, M1, AUX
+// UART2 on the ESP-IDF driver; keeps receiving into its ring while the tasks are busy
+UartLink loraLink(UART_NUM_2);
+RH_E32 driver(&loraLink, MOPIN, M1PIN, AUXPIN); //M0, M1, AUX
 RHMesh mesh(driver, NODEID); // Node ID 2 for this example
 
-std::vector<NodeStatus> nodeStatuses;
+// E32 wake-up mode and light sleep on backup power; idle unless FRS_WAKE_LATENCY_MS is set
+LowPower lowPower(loraLink, MOPIN, M1PIN, AUXPIN);
+
+NodeTable<MAX_NODES> nodeStatuses;
+
+static uint8_t meshSend(const uint8_t* frame, uint8_t len, uint8_t dest);
+static bool sendTransportFrame(const uint8_t* frame, uint8_t len);
+static void onPayloadReceived(uint8_t from, const uint8_t* data, size_t len);
+static void onPayloadSent(uint8_t dest, bool ok);
+static uint32_t untilAnnounceSlot(uint32_t now);
+static bool transferSlotOpen();
+static uint32_t untilTransferSlot(uint32_t now);
+
+// Fragments payloads larger than one E32 frame (site, unit and manufacturer records)
+// in the TDMA transfer slots. The ACK may have to wait for the transfer slots of the next group.
+static constexpr unsigned long TRANSPORT_ACK_TIMEOUT_MS = XFER_ACK_TIMEOUT + TDMA_CONTENTION_EVERY * TDMA_SLOT_MS;
+FragmentTransport transport(sendTransportFrame, onPayloadReceived, onPayloadSent, millis, transferSlotOpen);
+// The portal starts payloads from loop(); LoRatask receives and sends them.
+// Recursive: a delivered payload can start a send from inside onFrame().
+static SemaphoreHandle_t transportMutex;
+
+// Versioned portal fields, kept consistent across the mesh by delta sync
+ConfigStore siteConfig;
+SemaphoreHandle_t configMutex;  // the portal writes from loop(), sync runs in LoRatask
+
+// Version vectors that arrived while the transport was busy, under transportMutex
+static constexpr uint8_t SYNC_PULLS_MAX = 4;
+struct SyncPull {
+    uint8_t from;
+    uint8_t vector[CONFIG_VECTOR_LEN];
+    size_t len;
+};
+static SyncPull syncPulls[SYNC_PULLS_MAX];
+static uint8_t syncPullCount = 0;
+
+// Packed copy of siteConfig in the "siterec" flash partition
+SiteStore siteStore;
+
+// Audit trail in the "journal" flash partition; appended from loop() and LoRatask, read by /journal
+EventJournal journal;
+static SemaphoreHandle_t journalMutex;
+static constexpr uint16_t JOURNAL_PAGE_DEFAULT = 100;
+static constexpr uint16_t JOURNAL_PAGE_MAX = 500;
+
+// JSON keys used by the portal pages, indexed by ConfigField
+static const char* const kFieldKeys[CFG_FIELD_COUNT] = {
+    "company-name", "company-address", "key-person", "contact-details",
+    "alt-person-1", "alt-contact-details-1", "alt-person-2", "alt-contact-details-2",
+    "alt-person-3", "alt-contact-details-3", "alt-person-4", "alt-contact-details-4",
+    "local-fire-department", "local-fire-department-contact-details",
+    "location", "unitNumber", "date", "installer", "contact", "ipAddress",
+    "name", "contact", "email", "date", "serial",
+    "ssid", "password",
+};
+
+// Wizard section names used by the portal, indexed by SiteRecord
+static const char* const kRecordKeys[REC_COUNT] = { "company", "unit", "manufacturer", "ap" };
+
+static void onConfigChanged(ConfigField field);
+static void journalEvent(JournalEvent event, uint8_t node, uint8_t detail);
+static void onSyncDigest(const FrameRef& frame, const uint8_t* msg, uint8_t len);
+static void handleSyncDigest(uint8_t from, uint32_t digest);
+static void handleSyncVector(uint8_t from, const uint8_t* data, size_t len);
+static void answerQueuedPull();
+static void handleSyncDelta(uint8_t from, const uint8_t* data, size_t len);
+static void onTransportFrame(const FrameRef& frame, const uint8_t* msg, uint8_t len);
+static FrameRef acquireRxFrame();
+static void logFrame(const FrameRef& frame);
+static void onPresence(const FrameRef& frame, const uint8_t* msg, uint8_t len);
+#if FRS_ESCALATOR
+static uint32_t untilReportSlot(uint32_t now);
+static void sendStateReport();
+static void onActive(const FrameRef& frame, const uint8_t* msg, uint8_t len);
+static void onInactive(const FrameRef& frame, const uint8_t* msg, uint8_t len);
+static void onGroupSwitch(const FrameRef& frame, const uint8_t* msg, uint8_t len);
+static void onFirmwareAnnounce(const FrameRef& frame, const uint8_t* msg, uint8_t len);
+static void onFirmwareChunk(const FrameRef& frame, const uint8_t* msg, uint8_t len);
+static void onFirmwareQuery(const FrameRef& frame, const uint8_t* msg, uint8_t len);
+static void logFirmwareEvent(FirmwareEvent event);
+
+// Rows of escalator handlers; the controller image leaves them, and the handlers, out.
+#define ESCALATOR_HANDLER(fn, minLen, maxLen) { fn, minLen, maxLen, ROLE_ESCALATOR }
+#else
+#define ESCALATOR_HANDLER(fn, minLen, maxLen) { nullptr, 0, 0, 0 }
+#endif
+
+// Handlers for received frames, indexed by MessageType
+static const MessageHandler kMessageHandlers[MSG_BINARY_LIMIT] = {
+    /* 0x00 */            { nullptr, 0, 0, 0 },
+    /* MSG_XFER_DATA */   { onTransportFrame, XFER_DATA_HEADER_LEN + 1, MESH_FRAME_MAX_LEN, ROLE_ANY },
+    /* MSG_XFER_ACK */    { onTransportFrame, XFER_ACK_LEN, XFER_ACK_LEN, ROLE_ANY },
+    /* MSG_SYNC_DIGEST */ { onSyncDigest, 5, 5, ROLE_ANY },
+    /* MSG_SYNC_VECTOR */ { nullptr, 0, 0, 0 },  // payloads, delivered by the transport
+    /* MSG_SYNC_DELTA */  { nullptr, 0, 0, 0 },
+    /* MSG_ACTIVE */      ESCALATOR_HANDLER(onActive, 1, MESH_FRAME_MAX_LEN),
+    /* MSG_INACTIVE */    ESCALATOR_HANDLER(onInactive, 1, MESH_FRAME_MAX_LEN),
+    /* MSG_PRESENCE */    { onPresence, 1, MESH_FRAME_MAX_LEN, ROLE_ANY },
+    /* MSG_ACTIVATED */   { nullptr, 0, 0, 0 },  // for the controller, which has no handler for it yet
+    /* MSG_DEACTIVATED */ { nullptr, 0, 0, 0 },
+    /* MSG_GROUP_SWITCH */ ESCALATOR_HANDLER(onGroupSwitch, GROUP_SWITCH_HEADER_LEN + 1, GROUP_SWITCH_MAX_LEN),
+    /* MSG_FW_ANNOUNCE */ ESCALATOR_HANDLER(onFirmwareAnnounce, FW_ANNOUNCE_LEN, FW_ANNOUNCE_LEN),
+    /* MSG_FW_CHUNK */    ESCALATOR_HANDLER(onFirmwareChunk, FW_CHUNK_LEN, FW_CHUNK_LEN),
+    /* MSG_FW_STATUS */   { nullptr, 0, 0, 0 },  // for the controller
+    /* MSG_FW_QUERY */    ESCALATOR_HANDLER(onFirmwareQuery, FW_QUERY_LEN, FW_QUERY_LEN),
+};
+static_assert(MSG_FW_QUERY == 0x0F, "kMessageHandlers rows must follow MessageType");
+
+MessageDispatcher dispatcher(kMessageHandlers, NODE_ROLE);
+
+#if FRS_ESCALATOR
+// Relays of this node, switched per group
+RelayBank relays;
+#endif
+
+// Network time from the presence beacons, and the beacon slot it schedules
+TimeSync timeSync;
+TdmaSchedule tdma;
+static constexpr uint8_t BEACON_LEN = 1 + TIME_SYNC_LEN + 4;  // [MSG_PRESENCE][sync][config digest u32]
+
+#if FRS_ESCALATOR
+// Relay state change waiting for the contention slot: MSG_ACTIVATED, MSG_DEACTIVATED or 0.
+// Only the latest one is reported; the relays switched when it was queued.
+static std::atomic<uint8_t> pendingReport(0);
+
+// Firmware image being received over the air; status replies go out as broadcasts
+FirmwareReceiver firmware(sendTransportFrame);
+static SemaphoreHandle_t firmwareMutex;  // fed and polled by LoRatask, its stats printed from loop()
+#endif
+
+// LoRatask is the only task that touches the E32: it receives, dispatches and
+// sends every frame. Payloads started from loop() wait in the transport for it.
+static TaskHandle_t radioOwner = nullptr;
+
+// Receive buffers, shared by the dispatcher, the serial log and /frames
+FramePool framePool;
+static FrameLog frameLog(framePool);  // most recent frames, the oldest is overwritten
+static SemaphoreHandle_t frameLogMutex;
+static std::atomic<uint32_t> rxSequence(0);
+
+// Every frame sent and received, for tools/replay; dumped by GET /trace
+RadioTrace radioTrace;
+static SemaphoreHandle_t traceMutex;
+static constexpr size_t TRACE_CHUNK = 512;   // bytes copied out per mutex hold
 
 // Create a web server object that listens for HTTP requests on port 80
 extern WebServer server;
@@ -32,22 +191,101 @@ const __FlashStringHelper* getErrorString(uint8_t status) {
 }
 
 // For LoRa Mesh
-void LoRatask(void* parameter){
+void LoRatask(void* /*parameter*/){
     Serial.println("LoRatask Started");
+    radioOwner = xTaskGetCurrentTaskHandle();
     for (;;) {
         static unsigned long lastBroadcastTime = 0;
         static unsigned long lastCheckTime = 0;
         static unsigned long lastStatusPrintTime = 0;
         unsigned long currentMillis = millis();
-
-        if (currentMillis - lastBroadcastTime > 30000) {  // Every 30 seconds
-            broadcastPresence();
-            lastBroadcastTime = currentMillis;
+        profilerIteration(PROF_LORA_TASK);
+
+        // Beacon in our own slot once the clock is good enough, else every superframe (30 seconds)
+        uint16_t listenMs = 2000;
+        uint32_t beaconDue;
+        timeSync.poll(currentMillis);
+        if (timeSync.synced(currentMillis, TDMA_MAX_GUARD_MS)) {
+            uint32_t wait = tdma.untilBeacon(timeSync.networkTime(currentMillis), timeSync.errorBound(currentMillis));
+            if (wait == 0 && currentMillis - lastBroadcastTime > TDMA_SLOT_MS) {
+                broadcastPresence();
+                lastBroadcastTime = currentMillis;
+            } else if (wait > 0 && wait < listenMs) {
+                listenMs = (uint16_t)wait;   // wake up for the slot
+            }
+            beaconDue = wait > 0 ? wait : TDMA_SLOT_MS;   // sent in this window, look again after it
+        } else {
+            // Up to a group later at random, so listening neighbours woken by the same frame drift apart
+            static uint32_t listenPeriod = TDMA_SUPERFRAME_MS;
+            if (currentMillis - lastBroadcastTime > listenPeriod) {
+                profilerLateness(PROF_LORA_TASK, lastBroadcastTime + listenPeriod);
+                broadcastPresence();
+                lastBroadcastTime = currentMillis;
+                listenPeriod = TDMA_SUPERFRAME_MS + esp_random() % (TDMA_CONTENTION_EVERY * TDMA_SLOT_MS);
+            }
+            beaconDue = listenPeriod + 1 - (currentMillis - lastBroadcastTime);
+            listenMs = beaconDue < listenMs ? (uint16_t)beaconDue : listenMs;
+        }
+        if (timeSync.announcePending()) {
+            uint32_t wait = untilAnnounceSlot(currentMillis);
+            if (wait == 0) {
+                broadcastPresence();   // the old tree hears the new root before our own slot comes round
+                timeSync.clearAnnounce();
+            } else {
+                listenMs = wait < listenMs ? (uint16_t)wait : listenMs;
+                beaconDue = wait < beaconDue ? wait : beaconDue;
+            }
+        }
+#if FRS_ESCALATOR
+        if (pendingReport != 0) {
+            uint32_t wait = untilReportSlot(currentMillis);
+            if (wait == 0) {
+                sendStateReport();
+            } else {
+                listenMs = wait < listenMs ? (uint16_t)wait : listenMs;   // wake up for the contention slot
+                beaconDue = wait < beaconDue ? wait : beaconDue;
+            }
+        }
+#endif
+
+        // Fragments and ACKs held back by the transport go out in the next transfer slots
+        xSemaphoreTakeRecursive(transportMutex, portMAX_DELAY);
+        bool held = transport.waiting();
+        bool transferring = held || transport.busy();
+        xSemaphoreGiveRecursive(transportMutex);
+        if (held) {
+            uint32_t wait = untilTransferSlot(currentMillis);
+            listenMs = wait < listenMs ? (uint16_t)wait : listenMs;
         }
 
-        listenForNodes();
+        // On backup power, sleep until the beacon or the activity check is due; the E32 wakes us for frames
+        if (lowPower.sleepEnabled() && !lowPower.holding(millis()) && !transferring) {
+            uint32_t checkDue = currentMillis - lastCheckTime > 10000 ? 0 : 10001 - (currentMillis - lastCheckTime);
+            uint32_t sleepMs = beaconDue < checkDue ? beaconDue : checkDue;
+            if (sleepMs > 0 && lowPower.sleep(sleepMs)) {
+                listenForNodes(WAKE_HOLD_MS);   // the frame that woke us is waiting in the UART ring
+            }
+        } else {
+            listenForNodes(listenMs);
+        }
+        xSemaphoreTakeRecursive(transportMutex, portMAX_DELAY);
+        transport.poll(millis());  // retransmit fragments whose ACK timed out
+        xSemaphoreGiveRecursive(transportMutex);
+#if FRS_ESCALATOR
+        xSemaphoreTake(firmwareMutex, portMAX_DELAY);
+        FirmwareEvent event = firmware.poll(millis());   // hash a slice of flash, send a due status reply
+        bool restart = firmware.restartDue(millis());
+        xSemaphoreGive(firmwareMutex);
+        logFirmwareEvent(event);
+
+        if (restart) {
+            Serial.println("Restarting into the new firmware");
+            ESP.restart();
+        }
+#endif
 
         if (currentMillis - lastCheckTime > 10000) {  // Every 10 seconds
+            profilerLateness(PROF_LORA_TASK, lastCheckTime + 10000);
             checkNodeActivity();
             lastCheckTime = currentMillis;
         }
@@ -55,6 +293,7 @@ void LoRatask(void* parameter){
         if (currentMillis - lastStatusPrintTime > 60000) {  // Every 60 seconds
             // printNodeStatuses();  // Print the statuses of all nodes
             printNetworkStats(); 
+            profilerReport(Serial);
             lastStatusPrintTime = currentMillis;
         }
     }
@@ -63,113 +302,579 @@ void LoRatask(void* parameter){
     vTaskSuspend(xHandleLoRa); // Suspend the task
 }
 
+// A received frame is ready for LoRatask from the moment the E32 stops sending it.
+static void stampFrameEnd() {
+    profilerWake(PROF_LORA_TASK);
+}
+
+// Opens the UART to the E32; must run before initializeMESH().
+bool initializeLoRaLink() {
+    loraLink.onFrameEnd(stampFrameEnd);
+    return loraLink.begin(Baud_RATE_LORA, LORA_RXPIN, LORA_TXPIN);
+}
+
+// Puts the E32 into wake-up mode when the site has a latency budget; call after initializeMESH().
+bool initializeLowPower() {
+    return lowPower.begin(WAKE_PERIOD_MS);
+}
+
+// Lets a node built for backup power sleep; Wi-Fi must be off by now.
+void startLowPowerSleep() {
+    lowPower.enableSleep();
+}
+
 // Initializes the MESH network.
 bool initializeMESH() {
+    if (frameLogMutex == nullptr) {
+        frameLogMutex = xSemaphoreCreateMutex();
+        traceMutex = xSemaphoreCreateMutex();
+        transportMutex = xSemaphoreCreateRecursiveMutex();
+#if FRS_ESCALATOR
+        firmwareMutex = xSemaphoreCreateMutex();
+#endif
+    }
 if (!mesh.init()) {
         // Serial.println("Mesh initialization failed");
         return false;
     }
+    transport.begin(mesh.thisAddress(), TRANSPORT_ACK_TIMEOUT_MS, (uint8_t)esp_random());
+#if FRS_ESCALATOR
+    firmware.begin(mesh.thisAddress());
+#endif
+    timeSync.begin(mesh.thisAddress(), millis());
+    tdma.begin(mesh.thisAddress());
+    return true;
+}
+
+// Sets up the relay groups from RELAY_GROUPS, all off; the controller has none.
+bool initializeRelays() {
+#if FRS_ESCALATOR
+    if (!relays.begin(RELAY_GROUPS, RELAY_GROUP_COUNT)) {
+        Serial.println("Invalid relay group configuration, some groups are disabled");
+        return false;
+    }
+#endif
+    return true;
+}
+
+// Loads the site config from flash.
+bool initializeSiteStore() {
+    configMutex = xSemaphoreCreateMutex();
+    siteConfig.begin(mesh.thisAddress(), onConfigChanged);
+    if (!siteStore.begin()) {
+        Serial.println("Site record partition not found");
+        return false;
+    }
+    if (siteStore.load(siteConfig)) {
+        Serial.println("Site records loaded from flash");
+    }
+    return true;
+}
+
+// Opens the event journal and records the boot.
+bool initializeJournal() {
+    journalMutex = xSemaphoreCreateMutex();
+    if (!journal.begin()) {
+        Serial.println("Journal partition not found");
+        return false;
+    }
+    journalEvent(JOURNAL_BOOT, mesh.thisAddress(), 0);
     return true;
 }
 
-// Broadcasts the presence of the current node to other nodes in the network.
+// Appends an event stamped with network time and uptime.
+static void journalEvent(JournalEvent event, uint8_t node, uint8_t detail) {
+    unsigned long now = millis();
+    xSemaphoreTake(journalMutex, portMAX_DELAY);
+    bool ok = journal.append(event, node, detail, timeSync.networkTime(now), now);
+    xSemaphoreGive(journalMutex);
+    if (!ok) {
+        Serial.println("Failed to write event to the journal");
+    }
+}
+
+// Writes the current site config to flash.
+void persistSiteConfig() {
+    xSemaphoreTake(configMutex, portMAX_DELAY);
+    bool ok = siteStore.save(siteConfig);
+    xSemaphoreGive(configMutex);
+    if (!ok) {
+        Serial.println("Failed to write site records to flash");
+    }
+}
+
+// True if the wizard's access point fields make a WPA2 access point.
+static bool validAccessPoint(const char* ssid, const char* password) {
+    size_t ssidLen = strlen(ssid);
+    size_t passwordLen = strlen(password);
+    return ssidLen > 0 && ssidLen <= AP_SSID_MAX && passwordLen >= AP_PASSWORD_MIN && passwordLen <= AP_PASSWORD_MAX;
+}
+
+// Copies a value into a CONFIG_VALUE_MAX buffer, truncated like ConfigStore::set() does.
+static void copyConfigValue(char* out, const char* value) {
+    size_t len = strnlen(value, CONFIG_VALUE_MAX - 1);
+    memcpy(out, value, len);
+    out[len] = '\0';
+}
+
+// Copies the access point credentials stored by the wizard, or the built-in ones.
+void accessPointCredentials(char* ssid, char* password) {
+    xSemaphoreTake(configMutex, portMAX_DELAY);
+    copyConfigValue(ssid, siteConfig.get(CFG_AP_SSID));
+    copyConfigValue(password, siteConfig.get(CFG_AP_PASSWORD));
+    xSemaphoreGive(configMutex);
+
+    if (!validAccessPoint(ssid, password)) {
+        if (ssid[0] != '\0' || password[0] != '\0') {
+            Serial.println("Stored access point credentials are not valid, using the defaults");
+        }
+        copyConfigValue(ssid, AP_SSID);
+        copyConfigValue(password, AP_PASSWORD);
+    }
+}
+
+// Sends one frame through the mesh and records it in the trace with its result.
+static uint8_t meshSend(const uint8_t* frame, uint8_t len, uint8_t dest) {
+    uint32_t startedAt = millis();
+    uint8_t status = mesh.sendtoWait((uint8_t*)frame, len, dest);
+    uint32_t took = millis() - startedAt;
+    xSemaphoreTake(traceMutex, portMAX_DELAY);
+    radioTrace.record(TRACE_TX, startedAt, took > 0xFFFF ? 0xFFFF : (uint16_t)took, dest, status, frame, len);
+    xSemaphoreGive(traceMutex);
+    return status;
+}
+
+// Puts one transport frame on the air. Fragments go out link-layer broadcast
+// so RHReliableDatagram does not wait for a hop ACK per frame; the transport
+// acknowledges whole windows end to end instead.
+static bool sendTransportFrame(const uint8_t* frame, uint8_t len) {
+    uint8_t status = meshSend(frame, len, RH_BROADCAST_ADDRESS);
+    if (status != RH_ROUTER_ERROR_NONE) {
+        Serial.print("Failed to send transport frame, error: ");
+        Serial.println(getErrorString(status));
+        journalEvent(JOURNAL_SEND_FAILED, frame[0], status);
+        return false;
+    }
+    return true;
+}
+
+// Called by the transport once a large payload has been reassembled.
+static void onPayloadReceived(uint8_t from, const uint8_t* data, size_t len) {
+    Serial.print("Received payload of ");
+    Serial.print(len);
+    Serial.print(" bytes from node ");
+    Serial.println(from);
+
+    switch (data[0]) {
+      case MSG_SYNC_VECTOR: handleSyncVector(from, data, len); break;
+      case MSG_SYNC_DELTA: handleSyncDelta(from, data, len); break;
+      default: break;
+    }
+}
+
+// Called by the transport when an outbound payload is acknowledged or abandoned.
+static void onPayloadSent(uint8_t dest, bool ok) {
+    Serial.print("Payload to node ");
+    Serial.print(dest);
+    Serial.println(ok ? " delivered" : " failed after retries");
+    answerQueuedPull();
+}
+
+// Milliseconds until the next transfer slots; 0 inside them or without a schedule.
+static uint32_t untilTransferSlot(uint32_t now) {
+    if (!timeSync.synced(now, TDMA_MAX_GUARD_MS)) {
+        return 0;   // no schedule yet, send straight away
+    }
+    return TdmaSchedule::untilTransfer(timeSync.networkTime(now), timeSync.errorBound(now));
+}
+
+// Lets the transport put a frame on the air only from LoRatask and inside the transfer slots.
+static bool transferSlotOpen() {
+    return xTaskGetCurrentTaskHandle() == radioOwner && untilTransferSlot(millis()) == 0;
+}
+
+// Sends a payload of up to XFER_MAX_PAYLOAD bytes to a neighbouring node.
+bool sendPayload(uint8_t dest, const uint8_t* data, size_t len) {
+    xSemaphoreTakeRecursive(transportMutex, portMAX_DELAY);
+    bool started = transport.send(dest, data, len, millis());
+    xSemaphoreGiveRecursive(transportMutex);
+    return started;
+}
+
+// Broadcasts the presence beacon: network time for the neighbours plus our config digest.
 void broadcastPresence() {
-  const char* presenceMsg = "Node Present";
-  uint8_t status = mesh.sendtoWait((uint8_t*)presenceMsg, strlen(presenceMsg) + 1, RH_BROADCAST_ADDRESS);
+  xSemaphoreTake(configMutex, portMAX_DELAY);
+  uint32_t digest = siteConfig.digest();
+  xSemaphoreGive(configMutex);
+
+  uint8_t beacon[BEACON_LEN];
+  beacon[0] = MSG_PRESENCE;
+  beacon[1 + TIME_SYNC_LEN] = (uint8_t)digest;
+  beacon[2 + TIME_SYNC_LEN] = (uint8_t)(digest >> 8);
+  beacon[3 + TIME_SYNC_LEN] = (uint8_t)(digest >> 16);
+  beacon[4 + TIME_SYNC_LEN] = (uint8_t)(digest >> 24);
+  timeSync.fill(beacon + 1, millis());  // last, so the timestamp is taken as the send starts
+  uint8_t status = meshSend(beacon, sizeof(beacon), RH_BROADCAST_ADDRESS);
   if (status == RH_ROUTER_ERROR_NONE) {
       Serial.println("Presence message sent successfully");
   } else {
       Serial.print("Failed to send presence message, error: ");
       Serial.println(status);
       Serial.println((const __FlashStringHelper*)getErrorString(status));
+      journalEvent(JOURNAL_SEND_FAILED, MSG_PRESENCE, status);
   }
 }
 
-// Broadcasts active message 
+// Writes a config field from the portal; other nodes pick it up on the next sync round.
+void updateConfigField(ConfigField field, const char* value) {
+    xSemaphoreTake(configMutex, portMAX_DELAY);
+    siteConfig.set(field, value);
+    xSemaphoreGive(configMutex);
+}
+
+// Config digest as carried in beacons and MSG_SYNC_DIGEST, little endian.
+static uint32_t readDigest(const uint8_t* p) {
+    return (uint32_t)p[0] | ((uint32_t)p[1] << 8) | ((uint32_t)p[2] << 16) | ((uint32_t)p[3] << 24);
+}
+
+static void onSyncDigest(const FrameRef& frame, const uint8_t* msg, uint8_t /*len*/) {
+    handleSyncDigest(frame->from, readDigest(msg + 1));
+}
+
+// A neighbour with a different digest gets our version vector so it can send what we miss.
+static void handleSyncDigest(uint8_t from, uint32_t digest) {
+    xSemaphoreTakeRecursive(transportMutex, portMAX_DELAY);
+    bool serving = syncPullCount > 0;
+    xSemaphoreGiveRecursive(transportMutex);
+    if (serving) {
+        return;   // peers waiting for our fields come before asking for theirs
+    }
+
+    uint8_t vector[CONFIG_VECTOR_LEN];
+    xSemaphoreTake(configMutex, portMAX_DELAY);
+    bool differs = digest != siteConfig.digest();
+    size_t vectorLen = differs ? siteConfig.encodeVector(vector, sizeof(vector)) : 0;
+    xSemaphoreGive(configMutex);
+
+    // A busy transport just means we catch up on the next round.
+    if (vectorLen > 0 && sendPayload(from, vector, vectorLen)) {
+        Serial.print("Config differs from node ");
+        Serial.print(from);
+        Serial.println(", sent version vector");
+    }
+}
+
+// Queues a version vector that found the transport busy; a later one from the same peer replaces it.
+static void queuePull(uint8_t from, const uint8_t* data, size_t len) {
+    if (len > CONFIG_VECTOR_LEN) {
+        return;
+    }
+    xSemaphoreTakeRecursive(transportMutex, portMAX_DELAY);
+    uint8_t i = 0;
+    while (i < syncPullCount && syncPulls[i].from != from) i++;
+    if (i < SYNC_PULLS_MAX) {
+        syncPulls[i].from = from;
+        memcpy(syncPulls[i].vector, data, len);
+        syncPulls[i].len = len;
+        syncPullCount = i < syncPullCount ? syncPullCount : (uint8_t)(i + 1);
+    }
+    xSemaphoreGiveRecursive(transportMutex);
+}
+
+// Answers the oldest queued version vector once the transport is free.
+static void answerQueuedPull() {
+    SyncPull pull;
+    xSemaphoreTakeRecursive(transportMutex, portMAX_DELAY);
+    bool due = syncPullCount > 0 && !transport.busy();
+    if (due) {
+        pull = syncPulls[0];
+        memmove(syncPulls, syncPulls + 1, (syncPullCount - 1) * sizeof(SyncPull));
+        syncPullCount--;
+    }
+    xSemaphoreGiveRecursive(transportMutex);
+    if (due) {
+        handleSyncVector(pull.from, pull.vector, pull.len);
+    }
+}
+
+// Answers a version vector with the fields we hold newer versions of.
+static void handleSyncVector(uint8_t from, const uint8_t* data, size_t len) {
+    static uint8_t delta[XFER_MAX_PAYLOAD];  // static: too large for the LoRatask stack
+    uint8_t vector[CONFIG_VECTOR_LEN];
+    size_t vectorLen = 0;
+
+    xSemaphoreTake(configMutex, portMAX_DELAY);
+    size_t deltaLen = siteConfig.encodeDelta(data, len, delta, sizeof(delta));
+    if (deltaLen == 0 && siteConfig.peerHasNewer(data, len)) {
+        vectorLen = siteConfig.encodeVector(vector, sizeof(vector));
+    }
+    xSemaphoreGive(configMutex);
+
+    if (deltaLen > 0 && !sendPayload(from, delta, deltaLen)) {
+        queuePull(from, data, len);   // answered when the current transfer ends
+    }
+    else if (vectorLen > 0) {
+        sendPayload(from, vector, vectorLen); // ask the peer for its newer fields
+    }
+}
+
+// Merges changed fields sent by a neighbour.
+static void handleSyncDelta(uint8_t from, const uint8_t* data, size_t len) {
+    xSemaphoreTake(configMutex, portMAX_DELAY);
+    int changed = siteConfig.applyDelta(data, len);
+    xSemaphoreGive(configMutex);
+
+    if (changed < 0) {
+        Serial.print("Malformed config delta from node ");
+        Serial.println(from);
+        return;
+    }
+    Serial.print("Merged ");
+    Serial.print(changed);
+    Serial.print(" config fields from node ");
+    Serial.println(from);
+    if (changed > 0) {
+        persistSiteConfig();
+    }
+}
+
+// Called for each field a merged delta changed.
+static void onConfigChanged(ConfigField field) {
+    Serial.print("Config field ");
+    Serial.print(field);
+    Serial.println(" updated over the mesh");
+}
+
+// Milliseconds until the contention slot that announces a new root, drawn from the next
+// TIME_SYNC_ANNOUNCE_GROUPS; 0 inside it or without a schedule.
+static uint32_t untilAnnounceSlot(uint32_t now) {
+    static bool drawn = false;
+    static uint32_t notBefore = 0;
+    if (!timeSync.synced(now, TDMA_MAX_GUARD_MS)) {
+        return 0;
+    }
+    if (!drawn) {
+        notBefore = now + esp_random() % (TIME_SYNC_ANNOUNCE_GROUPS * TDMA_CONTENTION_EVERY * TDMA_SLOT_MS);
+        drawn = true;
+    }
+    uint32_t delay = (int32_t)(notBefore - now) > 0 ? notBefore - now : 0;
+    uint32_t wait = delay + TdmaSchedule::untilContention(timeSync.networkTime(now + delay), timeSync.errorBound(now));
+    drawn = wait > 0;   // drawn afresh for the next root change
+    return wait;
+}
+
+#if FRS_ESCALATOR
+// Switches the relays on and queues the active message
 void activeState() {
   if(activateRelayonce) {
       activateRelayonce = false;
-      digitalWrite(RLYPIN, HIGH); // turn on the relay
+      relays.setAll(true); // turn on the relays
     }
-
-  const char* activeMsg = "Actived";
-  uint8_t status = mesh.sendtoWait((uint8_t*)activeMsg, strlen(activeMsg) + 1, RH_BROADCAST_ADDRESS);
-  if (status == RH_ROUTER_ERROR_NONE) {
-      Serial.println("Active message sent successfully");
-  } else {
-      Serial.print("Failed to send active message, error: ");
-      Serial.println(status);
-      Serial.println((const __FlashStringHelper*)getErrorString(status));
-  }
+  pendingReport = MSG_ACTIVATED;
 }
 
-// Broadcasts inactive message 
+// Switches the relays off and queues the inactive message
 void inactiveState() {
-  digitalWrite(RLYPIN, LOW); // turn off the relay
+  relays.setAll(false); // turn off the relays
+  pendingReport = MSG_DEACTIVATED;
+}
+
+// Milliseconds until the next contention slot, which no beacon uses; 0 inside it or without a schedule.
+static uint32_t untilReportSlot(uint32_t now) {
+    if (!timeSync.synced(now, TDMA_MAX_GUARD_MS)) {
+        return 0;   // no schedule yet, send straight away
+    }
+    return TdmaSchedule::untilContention(timeSync.networkTime(now), timeSync.errorBound(now));
+}
 
-  const char* inactiveMsg = "Deactived";
-  uint8_t status = mesh.sendtoWait((uint8_t*)inactiveMsg, strlen(inactiveMsg) + 1, RH_BROADCAST_ADDRESS);
+// Broadcasts the queued active or inactive message; LoRatask calls it in a contention slot.
+static void sendStateReport() {
+  uint8_t type = pendingReport.exchange(0);
+  if (type == 0) {
+      return;
+  }
+  const char* msg = type == MSG_ACTIVATED ? "Actived" : "Deactived";
+  uint8_t status = meshSend((const uint8_t*)msg, strlen(msg) + 1, RH_BROADCAST_ADDRESS);
   if (status == RH_ROUTER_ERROR_NONE) {
-      Serial.println("Inactive message sent successfully");
+      Serial.println(type == MSG_ACTIVATED ? "Active message sent successfully" : "Inactive message sent successfully");
   } else {
-      Serial.print("Failed to send inactive message, error: ");
+      Serial.print(type == MSG_ACTIVATED ? "Failed to send active message, error: " : "Failed to send inactive message, error: ");
       Serial.println(status);
       Serial.println((const __FlashStringHelper*)getErrorString(status));
+      journalEvent(JOURNAL_SEND_FAILED, type, status);
   }
 }
+#endif
 
 // Listens for incoming messages from other nodes.
-void listenForNodes() {
-    uint8_t buf[RH_MESH_MAX_MESSAGE_LEN];
-    uint8_t len = sizeof(buf);
+void listenForNodes(uint16_t timeoutMs) {
+    FrameRef frame = acquireRxFrame();
+    if (!frame) {
+        vTaskDelay(pdMS_TO_TICKS(FRAME_POOL_BACKOFF_MS));  // backpressure: leave the frame in the E32
+        return;
+    }
+
+    uint8_t len = sizeof(frame->data);
     uint8_t from;
+    if (mesh.recvfromAckTimeout(frame->data, &len, timeoutMs, &from)) {
+        profilerRun(PROF_LORA_TASK);
+        frame->len = len;
+        frame->from = from;
+        frame->receivedAt = millis();
+        frame->seq = ++rxSequence;
+
+        xSemaphoreTake(traceMutex, portMAX_DELAY);
+        radioTrace.record(TRACE_RX, frame->receivedAt, 0, from, 0, frame->data, len);
+        xSemaphoreGive(traceMutex);
+        logFrame(frame);
+        lowPower.onActivity(frame->receivedAt);
+        dispatcher.dispatch(frame);
+    } else {
+        profilerClearWake(PROF_LORA_TASK);   // any frame that ended was routing, or for another node
+    }
+}
 
-    if (mesh.recvfromAckTimeout(buf, &len, 2000, &from)) {
+// Takes a receive buffer; when the pool is empty the log gives up its oldest frames.
+static FrameRef acquireRxFrame() {
+    xSemaphoreTake(frameLogMutex, portMAX_DELAY);
+    FrameRef frame = frameLog.acquire();
+    xSemaphoreGive(frameLogMutex);
+    return frame;
+}
+
+// Prints a text frame and keeps a reference to every frame for /frames.
+static void logFrame(const FrameRef& frame) {
+    if (!isBinaryFrame(frame->data, frame->len)) {
         Serial.print("Received message from node ");
-        Serial.print(from);
+        Serial.print(frame->from);
         Serial.print(": ");
-        Serial.println((char*)buf);
+        Serial.write(frame->data, strnlen((const char*)frame->data, frame->len));
+        Serial.println();
+    }
+    xSemaphoreTake(frameLogMutex, portMAX_DELAY);
+    frameLog.add(frame);
+    xSemaphoreGive(frameLogMutex);
+}
 
-        if((char*)buf == "Active") {
-          activeState(); // Broadcast active message
-          activateRelayonce = true;
-        }
-        else if((char*)buf == "Inactive") {
-          inactiveState(); // Broadcast inactive message
-        }
-        else if((char*)buf == "Node Present") {
-          updateNodeStatus(from); // Update node information
-        }
+static void onTransportFrame(const FrameRef& frame, const uint8_t* msg, uint8_t len) {
+    xSemaphoreTakeRecursive(transportMutex, portMAX_DELAY);
+    transport.onFrame(frame->from, msg, len, millis());
+    xSemaphoreGiveRecursive(transportMutex);
+}
+
+#if FRS_ESCALATOR
+// Arms activeState() to switch the relay on, then announces it.
+static void onActive(const FrameRef& frame, const uint8_t* /*msg*/, uint8_t /*len*/) {
+    journalEvent(JOURNAL_ACTIVATED, frame->from, 0);
+    activateRelayonce = true;
+    activeState();
+}
+
+static void onInactive(const FrameRef& frame, const uint8_t* /*msg*/, uint8_t /*len*/) {
+    journalEvent(JOURNAL_DEACTIVATED, frame->from, 0);
+    inactiveState();
+}
+#endif
+
+// Legacy "Node Present" arrives as a bare MSG_PRESENCE; beacons also carry time and the config digest.
+static void onPresence(const FrameRef& frame, const uint8_t* msg, uint8_t len) {
+    if (len >= BEACON_LEN) {
+        timeSync.onBeacon(frame->from, msg + 1, frame->receivedAt);
+        handleSyncDigest(frame->from, readDigest(msg + 1 + TIME_SYNC_LEN));
+    }
+    updateNodeStatus(frame->from);
+}
+
+#if FRS_ESCALATOR
+static void onGroupSwitch(const FrameRef& frame, const uint8_t* msg, uint8_t len) {
+    uint8_t selected = relays.applyFrame(msg, len);
+    if (selected > 0) {
+        journalEvent(msg[1] ? JOURNAL_ACTIVATED : JOURNAL_DEACTIVATED, frame->from, selected);
+        Serial.print("Relay groups switched ");
+        Serial.print(msg[1] ? "on" : "off");
+        Serial.print(" by node ");
+        Serial.print(frame->from);
+        Serial.print(": ");
+        Serial.println(selected);
     }
 }
 
+// Prints what a firmware receiver call reported.
+static void logFirmwareEvent(FirmwareEvent event) {
+    if (event == FW_EVENT_STARTED) {
+        Serial.print("Receiving firmware image ");
+        Serial.println(firmware.imageId());
+    } else if (event == FW_EVENT_CURRENT) {
+        Serial.print("Firmware image ");
+        Serial.print(firmware.imageId());
+        Serial.println(" is already running");
+    } else if (event == FW_EVENT_VERIFIED) {
+        Serial.print("Firmware image ");
+        Serial.print(firmware.imageId());
+        Serial.println(" verified, restarting once the controller confirms");
+    } else if (event == FW_EVENT_BAD_HASH) {
+        Serial.println("Firmware image hash mismatch, waiting for the next announce");
+    } else if (event == FW_EVENT_FLASH_ERROR) {
+        Serial.println("Firmware image does not fit the OTA partition or failed to write");
+    }
+}
+
+static void onFirmwareAnnounce(const FrameRef& /*frame*/, const uint8_t* msg, uint8_t len) {
+    xSemaphoreTake(firmwareMutex, portMAX_DELAY);
+    FirmwareEvent event = firmware.onAnnounce(msg, len);
+    xSemaphoreGive(firmwareMutex);
+    logFirmwareEvent(event);
+}
+
+static void onFirmwareChunk(const FrameRef& /*frame*/, const uint8_t* msg, uint8_t len) {
+    xSemaphoreTake(firmwareMutex, portMAX_DELAY);
+    FirmwareEvent event = firmware.onChunk(msg, len, millis());
+    xSemaphoreGive(firmwareMutex);
+    logFirmwareEvent(event);
+}
+
+static void onFirmwareQuery(const FrameRef& /*frame*/, const uint8_t* msg, uint8_t len) {
+    xSemaphoreTake(firmwareMutex, portMAX_DELAY);
+    firmware.onQuery(msg, len, millis());
+    xSemaphoreGive(firmwareMutex);
+}
+#endif
+
 // Updates the status of a node given its ID.
 void updateNodeStatus(uint8_t nodeId) {
     bool nodeFound = false;
     unsigned long currentTime = millis();
+    uint32_t networkTime = timeSync.networkTime(currentTime);
     for (auto& status : nodeStatuses) {
         if (status.nodeId == nodeId) {
+            if (!status.isActive) {
+                journalEvent(JOURNAL_NODE_BACK, nodeId, 0);
+            }
             status.lastSeen = currentTime;
+            status.lastSeenNetwork = networkTime;
             status.isActive = true;
             nodeFound = true;
             break;
         }
     }
-    if (!nodeFound) {
-        nodeStatuses.push_back({nodeId, currentTime, true});
+    if (!nodeFound && !nodeStatuses.push_back({nodeId, currentTime, networkTime, true})) {
+        Serial.print("Node table full, not tracking node ");
+        Serial.println(nodeId);
     }
 }
 
 // Checks the activity of all nodes in the network.
 void checkNodeActivity() {
     unsigned long currentTime = millis();
-    const unsigned long timeout = 60000; // 1 minute timeout to consider a node as dead
+    // Two beacon periods, a still-listening node's longest included: one lost beacon is not a death
+    const unsigned long timeout = 2 * (TDMA_SUPERFRAME_MS + TDMA_CONTENTION_EVERY * TDMA_SLOT_MS);
     for (auto& status : nodeStatuses) {
         if (status.isActive && (currentTime - status.lastSeen > timeout)) {
             status.isActive = false;
             Serial.print("Node ");
             Serial.print(status.nodeId);
             Serial.println(" is now considered dead.");
+            journalEvent(JOURNAL_NODE_DEAD, status.nodeId, 0);
         }
     }
 }
@@ -189,13 +894,15 @@ void printNodeStatuses() {
         Serial.print("Node ");
         Serial.print(status.nodeId);
         Serial.print(": ");
-        Serial.println(status.isActive ? "Active" : "Dead");
+        Serial.print(status.isActive ? "Active" : "Dead");
+        Serial.print(", last seen at network time ");
+        Serial.println(status.lastSeenNetwork);
     }
 }
 
 // Prints statistical information about the network.
 void printNetworkStats() {
-    int totalNodes = nodeStatuses.size();  // Total number of nodes is the size of the vector
+    int totalNodes = nodeStatuses.size();  // Total number of nodes is the size of the table
     int activeNodes = 0;
     int deadNodes = 0;
 
@@ -215,6 +922,105 @@ void printNetworkStats() {
     Serial.println(activeNodes);
     Serial.print("Dead Nodes: ");
     Serial.println(deadNodes);
+
+    xSemaphoreTakeRecursive(transportMutex, portMAX_DELAY);
+    TransportStats xfer = transport.stats();
+    xSemaphoreGiveRecursive(transportMutex);
+    Serial.print("Payloads Sent/Failed/Received: ");
+    Serial.print(xfer.transfersSent);
+    Serial.print("/");
+    Serial.print(xfer.transfersFailed);
+    Serial.print("/");
+    Serial.println(xfer.transfersReceived);
+    Serial.print("Fragment Retransmits: ");
+    Serial.println(xfer.retransmits);
+
+    const DispatchStats& rx = dispatcher.stats();
+    const UartLinkStats uart = loraLink.stats();
+    Serial.print("UART Bytes/Frames/Overflows/Frame Errors: ");
+    Serial.print(uart.rxBytes);
+    Serial.print("/");
+    Serial.print(uart.frames);
+    Serial.print("/");
+    Serial.print(uart.fifoOverflows + uart.ringOverflows);
+    Serial.print("/");
+    Serial.println(uart.frameErrors + uart.parityErrors);
+
+    if (lowPower.period() > 0) {
+        const PowerStats& power = lowPower.stats();
+        Serial.print("Sleeps/Radio Wakes/Timer Wakes/Slept s: ");
+        Serial.print(power.sleeps);
+        Serial.print("/");
+        Serial.print(power.radioWakes);
+        Serial.print("/");
+        Serial.print(power.timerWakes);
+        Serial.print("/");
+        Serial.println(power.sleptMs / 1000);
+    }
+
+    Serial.print("Frames Dispatched/Unhandled/Bad Length/Unknown Text: ");
+    Serial.print(rx.dispatched);
+    Serial.print("/");
+    Serial.print(rx.unhandled);
+    Serial.print("/");
+    Serial.print(rx.badLength);
+    Serial.print("/");
+    Serial.println(rx.unknownText);
+
+    FramePoolStats pool = framePool.stats();
+    xSemaphoreTake(frameLogMutex, portMAX_DELAY);
+    uint32_t evicted = frameLog.evicted();
+    xSemaphoreGive(frameLogMutex);
+    Serial.print("Frame Buffers In Use/Peak/Exhausted/Evicted: ");
+    Serial.print(pool.inUse);
+    Serial.print("/");
+    Serial.print(pool.highWater);
+    Serial.print("/");
+    Serial.print(pool.exhausted);
+    Serial.print("/");
+    Serial.println(evicted);
+
+    unsigned long now = millis();
+    const TimeSyncStats& sync = timeSync.stats();
+    Serial.print("Time Root/Hops/Error Bound ms/Beacon Slot: ");
+    Serial.print(timeSync.root());
+    Serial.print("/");
+    Serial.print(timeSync.hops());
+    Serial.print("/");
+    Serial.print(timeSync.errorBound(now));
+    Serial.print("/");
+    Serial.println(timeSync.synced(now, TDMA_MAX_GUARD_MS) ? tdma.slot() : 0);
+    Serial.print("Time Beacons/Adjustments/Steps/Root Timeouts/Stale: ");
+    Serial.print(sync.beacons);
+    Serial.print("/");
+    Serial.print(sync.adjustments);
+    Serial.print("/");
+    Serial.print(sync.steps);
+    Serial.print("/");
+    Serial.print(sync.rootTimeouts);
+    Serial.print("/");
+    Serial.println(sync.stale);
+
+#if FRS_ESCALATOR
+    xSemaphoreTake(firmwareMutex, portMAX_DELAY);
+    FirmwareState fwState = firmware.state();
+    FirmwareStats fw = firmware.stats();
+    xSemaphoreGive(firmwareMutex);
+    if (fwState != FW_IDLE) {
+        Serial.print("Firmware Generations Done/Total: ");
+        Serial.print(fw.generationsDone);
+        Serial.print("/");
+        Serial.println(fw.generationsTotal);
+        Serial.print("Firmware Chunks Received/Innovative/Redundant/Evictions: ");
+        Serial.print(fw.chunks);
+        Serial.print("/");
+        Serial.print(fw.innovative);
+        Serial.print("/");
+        Serial.print(fw.redundant);
+        Serial.print("/");
+        Serial.println(fw.evictions);
+    }
+#endif
 }
 
 
@@ -233,7 +1039,7 @@ void handleFileRead(String path) {
 
   if (SPIFFS.exists(path)) {
     File file = SPIFFS.open(path, "r");
-    size_t sent = server.streamFile(file, contentType);
+    server.streamFile(file, contentType);
     file.close();
     return;
   }
@@ -241,475 +1047,387 @@ void handleFileRead(String path) {
 }
 
 void handleRoot() {
-  handleFileRead("/P0.html");
-}
-
-void handleSettingsOptionPost() {
-  if (server.method() == HTTP_POST) {
-    String postBody = server.arg("plain");
-    DynamicJsonDocument doc(1024);
-    deserializeJson(doc, postBody);
-    
-    const char* selectedOption = doc["selectedOption"];
-    
-    Serial.print("selectedOption: ");
-    Serial.println(selectedOption);
-
-    if (strcmp(selectedOption, "DeviceConfiguartion") == 0) {
-      Serial.println("Redirecting to /P1.html");
-      DynamicJsonDocument responseDoc(1024);
-      responseDoc["status"] = "redirect";
-      responseDoc["url"] = "/P1.html";
-      String response;
-      serializeJson(responseDoc, response);
-      server.send(200, "application/json", response);
-      return;
-    }
+  handleFileRead("/portal.html");
+}
 
-    else if (strcmp(selectedOption, "ChangeDeviceLocalWiFiCredentials") == 0) {
-      Serial.println("Redirecting to /P11.html");
-      DynamicJsonDocument responseDoc(1024);
-      responseDoc["status"] = "redirect";
-      responseDoc["url"] = "/P11.html";
-      String response;
-      serializeJson(responseDoc, response);
-      server.send(200, "application/json", response);
-      return;
+void handleProfileGet() {
+  DynamicJsonDocument doc(4096);
+  profilerSnapshot(doc);
+
+  const UartLinkStats uart = loraLink.stats();
+  JsonObject link = doc.createNestedObject("uart");
+  link["rxBytes"] = uart.rxBytes;
+  link["frames"] = uart.frames;
+  link["fifoOverflows"] = uart.fifoOverflows;
+  link["ringOverflows"] = uart.ringOverflows;
+  link["frameErrors"] = uart.frameErrors;
+  link["parityErrors"] = uart.parityErrors;
+  link["breaks"] = uart.breaks;
+  link["ringPeak"] = uart.ringPeak;
+  link["ringSize"] = UART_LINK_RX_RING;
+
+  const PowerStats& stats = lowPower.stats();
+  JsonObject power = doc.createNestedObject("power");
+  power["wakeLatencyMs"] = WAKE_LATENCY_MS;
+  power["wakePeriodMs"] = lowPower.period();
+  power["sleeping"] = lowPower.sleepEnabled();
+  power["sleeps"] = stats.sleeps;
+  power["radioWakes"] = stats.radioWakes;
+  power["timerWakes"] = stats.timerWakes;
+  power["sleptMs"] = stats.sleptMs;
+  power["modeTimeouts"] = stats.modeTimeouts;
+
+  String response;
+  serializeJson(doc, response);
+  server.send(200, "application/json", response);
+}
+
+// Sends a JSON string value, escaping quotes, backslashes and control characters.
+static void sendJsonString(const char* value, size_t len) {
+  size_t runStart = 0;
+  for (size_t i = 0; i < len; i++) {
+    char c = value[i];
+    if (c != '"' && c != '\\' && (uint8_t)c >= 0x20) {
+      continue;
     }
-    
-  } else {
-    server.send(405, "text/plain", "Method Not Allowed");
+    if (i > runStart) server.sendContent(value + runStart, i - runStart);
+    char escaped[7];
+    if (c == '"' || c == '\\') {
+      escaped[0] = '\\';
+      escaped[1] = c;
+      escaped[2] = '\0';
+    } else {
+      snprintf(escaped, sizeof(escaped), "\\u%04x", (uint8_t)c);
+    }
+    server.sendContent_P(escaped);
+    runStart = i + 1;
   }
+  if (len > runStart) server.sendContent(value + runStart, len - runStart);
 }
 
-void handleConnectPost() {
-  if (server.method() == HTTP_POST) {
-    String postBody = server.arg("plain");
-    DynamicJsonDocument doc(1024);
-    deserializeJson(doc, postBody);
-    
-    const char* get_data = doc["get_data"];
-    
-    Serial.print("get_data: ");
-    Serial.println(get_data);
-
-    if (strcmp(get_data, "terms accepted") == 0) {
-      Serial.println("Redirecting to /P2.html");
-      DynamicJsonDocument responseDoc(1024);
-      responseDoc["status"] = "redirect";
-      responseDoc["url"] = "/P2.html";
-      String response;
-      serializeJson(responseDoc, response);
-      server.send(200, "application/json", response);
-      return;
+// Sends one stored record as a JSON object, a field at a time from mapped flash.
+// configMutex keeps persistSiteConfig() from erasing the sector while a field is copied.
+static void sendSiteRecord(SiteRecord record) {
+  bool first = true;
+  for (uint8_t i = SITE_RECORD_FIELDS[record].first; i <= SITE_RECORD_FIELDS[record].last; i++) {
+    // Sent unlocked, so a slow client does not hold up sync in LoRatask
+    char value[CONFIG_VALUE_MAX];
+    size_t len = 0;
+    xSemaphoreTake(configMutex, portMAX_DELAY);
+    const char* stored = siteStore.field((ConfigField)i, &len);
+    len = len < sizeof(value) ? len : sizeof(value);
+    if (stored != nullptr) {
+      memcpy(value, stored, len);
     }
-
-    else if (strcmp(get_data, "go to admin login") == 0) {
-      Serial.println("Redirecting to /P3.html");
-      DynamicJsonDocument responseDoc(1024);
-      responseDoc["status"] = "redirect";
-      responseDoc["url"] = "/P3.html";
-      String response;
-      serializeJson(responseDoc, response);
-      server.send(200, "application/json", response);
-      return;
+    xSemaphoreGive(configMutex);
+    if (stored == nullptr) {
+      continue;
     }
+    server.sendContent_P(first ? "{\"" : ",\"");   // _P variants send without building a String
+    server.sendContent_P(kFieldKeys[i]);
+    server.sendContent_P("\":\"");
+    sendJsonString(value, len);
+    server.sendContent_P("\"");
+    first = false;
+  }
+  server.sendContent_P(first ? "{}" : "}");
+}
 
-    else if (strcmp(get_data, "go to client login") == 0) {
-      Serial.println("Redirecting to /P2.html");
-      DynamicJsonDocument responseDoc(1024);
-      responseDoc["status"] = "redirect";
-      responseDoc["url"] = "/P2.html";
-      String response;
-      serializeJson(responseDoc, response);
-      server.send(200, "application/json", response);
-      return;
-    }
-  } else {
+// Streams one stored record as the whole response.
+static void streamSiteRecord(SiteRecord record) {
+  server.setContentLength(CONTENT_LENGTH_UNKNOWN);
+  server.send(200, "application/json", "");
+  sendSiteRecord(record);
+  server.sendContent_P("", 0);  // terminates the chunked response
+}
+
+void handleCompanyDetailsGet() {
+  streamSiteRecord(REC_COMPANY);
+}
+
+void handleUnitDetailsGet() {
+  streamSiteRecord(REC_UNIT);
+}
+
+void handleManufacturerDetailsGet() {
+  streamSiteRecord(REC_MANUFACTURER);
+}
+
+// Tells the portal which wizard step failed and why.
+static void sendWizardError(const char* step, const char* status, const char* reason) {
+  DynamicJsonDocument responseDoc(256);
+  responseDoc["status"] = status;
+  responseDoc["reason"] = reason;
+  responseDoc["step"] = step;
+  String response;
+  serializeJson(responseDoc, response);
+  server.send(200, "application/json", response);
+}
+
+// Login, WiFi and unique key of the wizard in one request. On success the
+// reply names the next step and carries the stored site records for prefill.
+void handleWizardAccessPost() {
+  if (server.method() != HTTP_POST) {
     server.send(405, "text/plain", "Method Not Allowed");
+    return;
   }
+  String postBody = server.arg("plain");
+  DynamicJsonDocument doc(1024);
+  deserializeJson(doc, postBody);
+
+  const char* role = doc["role"] | "client";
+  const char* username = doc["username"] | "";
+  const char* ssid = doc["ssid"] | "";
+  const char* uniqueKey = doc["uniqueKey"] | "";
+  bool rememberMe = doc["rememberMe"] | false;
+
+  Serial.print("Wizard login: ");
+  Serial.print(role);
+  Serial.print(" ");
+  Serial.print(username);
+  Serial.println(rememberMe ? " (remember me)" : "");
+  Serial.print("Wizard WiFi: ");
+  Serial.println(ssid);
+  Serial.print("Wizard unique key: ");
+  Serial.println(uniqueKey);
+
+  // The node holds no accounts or keys to check these against, and its
+  // station joins the network set in main.cpp; the fields are only logged.
+
+  // Stored company details lead to the question whether to take them from the mesh.
+  xSemaphoreTake(configMutex, portMAX_DELAY);
+  bool haveCompany = siteStore.hasRecord(REC_COMPANY);
+  xSemaphoreGive(configMutex);
+  server.setContentLength(CONTENT_LENGTH_UNKNOWN);
+  server.send(200, "application/json", "");
+  server.sendContent_P(haveCompany ? "{\"status\":\"ok\",\"next\":\"autofill\",\"records\":{"
+                                   : "{\"status\":\"ok\",\"next\":\"company\",\"records\":{");
+  for (uint8_t record = REC_COMPANY; record <= REC_MANUFACTURER; record++) {
+    server.sendContent_P(record == REC_COMPANY ? "\"" : ",\"");
+    server.sendContent_P(kRecordKeys[record]);
+    server.sendContent_P("\":");
+    sendSiteRecord((SiteRecord)record);
+  }
+  server.sendContent_P("}}");
+  server.sendContent_P("", 0);  // terminates the chunked response
 }
 
-void handleClientLoginPost() {
-  if (server.method() == HTTP_POST) {
-    String postBody = server.arg("plain");
-    DynamicJsonDocument doc(1024);
-    deserializeJson(doc, postBody);
-    
-    const char* client_username = doc["client_username"];
-    const char* client_password = doc["client_password"];
-    const char* client_rememberMe = doc["client_rememberMe"];
-    
-    Serial.print("client_username: ");
-    Serial.println(client_username);
-    Serial.print("client_password: ");
-    Serial.println(client_password);
-    Serial.print("client_rememberMe: ");
-    Serial.println(client_rememberMe);
-
-    if(false)  // if login failed
-    {
-      Serial.println("Client Login Failed!!!");
-      DynamicJsonDocument responseDoc(1024);
-      responseDoc["status"] = "Login failed!!!";
-      responseDoc["reason"] = "username or password is incorrect";
-      String response;
-      serializeJson(responseDoc, response);
-      server.send(200, "application/json", response);
-      return;
-    }
-    else {
-      Serial.println("Redirecting to /P4.html");
-      DynamicJsonDocument responseDoc(1024);
-      responseDoc["status"] = "redirect";
-      responseDoc["url"] = "/P4.html";
-      String response;
-      serializeJson(responseDoc, response);
-      server.send(200, "application/json", response);
-      return;
-    }
-  } else {
+// Saves whole wizard sections in one request: any of "company", "unit",
+// "manufacturer" and "ap", each an object keyed like the portal inputs.
+// Sections left out keep their stored values; all go to flash in one write.
+void handleWizardSitePost() {
+  if (server.method() != HTTP_POST) {
     server.send(405, "text/plain", "Method Not Allowed");
+    return;
+  }
+  String postBody = server.arg("plain");
+  DynamicJsonDocument doc(JSON_OBJECT_SIZE(REC_COUNT) + REC_COUNT * JSON_OBJECT_SIZE(CFG_FIELD_COUNT) + postBody.length());
+  if (deserializeJson(doc, postBody)) {
+    sendWizardError("", "Invalid request", "body is not JSON");
+    return;
   }
-}
 
-void handleAdminLoginPost() {
-  if (server.method() == HTTP_POST) {
-    String postBody = server.arg("plain");
-    DynamicJsonDocument doc(1024);
-    deserializeJson(doc, postBody);
-    
-    const char* admin_username = doc["admin_username"];
-    const char* admin_password = doc["admin_password"];
-    const char* admin_rememberMe = doc["admin_rememberMe"];
-    
-    Serial.print("admin_username: ");
-    Serial.println(admin_username);
-    Serial.print("admin_password: ");
-    Serial.println(admin_password);
-    Serial.print("admin_rememberMe: ");
-    Serial.println(admin_rememberMe);
-
-    if(false)  // if login failed
-    {
-      Serial.println("Admin Login Failed!!!");
-      DynamicJsonDocument responseDoc(1024);
-      responseDoc["status"] = "Login failed!!!";
-      responseDoc["reason"] = "username or password is incorrect";
-      String response;
-      serializeJson(responseDoc, response);
-      server.send(200, "application/json", response);
+  // The access point fields are checked as a pair, against the stored one if only one is sent.
+  JsonObject ap = doc[kRecordKeys[REC_ACCESS_POINT]];
+  if (!ap.isNull()) {
+    char apSsid[CONFIG_VALUE_MAX];
+    char apPassword[CONFIG_VALUE_MAX];
+    xSemaphoreTake(configMutex, portMAX_DELAY);
+    copyConfigValue(apSsid, ap[kFieldKeys[CFG_AP_SSID]] | siteConfig.get(CFG_AP_SSID));
+    copyConfigValue(apPassword, ap[kFieldKeys[CFG_AP_PASSWORD]] | siteConfig.get(CFG_AP_PASSWORD));
+    xSemaphoreGive(configMutex);
+    if (!validAccessPoint(apSsid, apPassword)) {
+      sendWizardError("ap", "Invalid access point", "ssid must be 1-32 characters, password 8-63");
       return;
     }
-    else {
-      Serial.println("Redirecting to /P4.html");
-      DynamicJsonDocument responseDoc(1024);
-      responseDoc["status"] = "redirect";
-      responseDoc["url"] = "/P4.html";
-      String response;
-      serializeJson(responseDoc, response);
-      server.send(200, "application/json", response);
-      return;
-    }
-  } else {
-    server.send(405, "text/plain", "Method Not Allowed");
   }
-}
 
-void handleWifiConnectPost() {
-  if (server.method() == HTTP_POST) {
-    String postBody = server.arg("plain");
-    DynamicJsonDocument doc(1024);
-    deserializeJson(doc, postBody);
-    
-    const char* wifi_ssid = doc["ssid"];
-    const char* wifi_password = doc["password"];
-    
-    Serial.print("wifi_ssid: ");
-    Serial.println(wifi_ssid);
-    Serial.print("wifi_password: ");
-    Serial.println(wifi_password);
-
-    if(false)  // if Connection failed
-    {
-      Serial.println("WiFi Connection failed!!!");
-      DynamicJsonDocument responseDoc(1024);
-      responseDoc["status"] = "WiFi Connection failed!!!";
-      responseDoc["reason"] = "ssid or password is incorrect";
-      String response;
-      serializeJson(responseDoc, response);
-      server.send(200, "application/json", response);
-      return;
+  uint8_t saved = 0;
+  for (uint8_t record = 0; record < REC_COUNT; record++) {
+    JsonObject section = doc[kRecordKeys[record]];
+    if (section.isNull()) {
+      continue;
     }
-    else {
-      Serial.println("Redirecting to /P5.html");
-      DynamicJsonDocument responseDoc(1024);
-      responseDoc["status"] = "redirect";
-      responseDoc["url"] = "/P5.html";
-      String response;
-      serializeJson(responseDoc, response);
-      server.send(200, "application/json", response);
-      return;
+    for (uint8_t i = SITE_RECORD_FIELDS[record].first; i <= SITE_RECORD_FIELDS[record].last; i++) {
+      const char* value = section[kFieldKeys[i]];
+      if (value != nullptr) {
+        updateConfigField((ConfigField)i, value);
+        saved++;
+      }
     }
-  } else {
-    server.send(405, "text/plain", "Method Not Allowed");
+    Serial.print("Wizard saved ");
+    Serial.println(kRecordKeys[record]);
+  }
+  if (saved > 0) {
+    persistSiteConfig();
   }
+  // setup() reads the access point credentials on the next start.
+
+  char response[40];
+  snprintf(response, sizeof(response), "{\"status\":\"ok\",\"saved\":%u}", saved);
+  server.send(200, "application/json", response);
 }
 
-void handleUniqueKeyPost() {
-  if (server.method() == HTTP_POST) {
-    String postBody = server.arg("plain");
-    DynamicJsonDocument doc(1024);
-    deserializeJson(doc, postBody);
-    
-    const char* uniqueKey = doc["uniqueKey"];
-    
-    Serial.print("uniqueKey: ");
-    Serial.println(uniqueKey);
-
-    if(false)  // if Unique Key is not valid
-    {
-      Serial.println("Invalid Unique Key!!!");
-      DynamicJsonDocument responseDoc(1024);
-      responseDoc["status"] = "Invalid Unique Key!!!";
-      responseDoc["reason"] = "";
-      String response;
-      serializeJson(responseDoc, response);
-      server.send(200, "application/json", response);
-      return;
-    }
-    else if(true) // if company details are already present in the web cloud
-    {
-      Serial.println("Redirecting to /P6.html");
-      DynamicJsonDocument responseDoc(1024);
-      responseDoc["status"] = "redirect";
-      responseDoc["url"] = "/P6.html";
-      String response;
-      serializeJson(responseDoc, response);
-      server.send(200, "application/json", response);
-      return;
+// Streams pool counters and the logged frames, oldest first, straight from the pooled buffers.
+void handleFramesGet() {
+  FrameRef frames[FRAME_LOG_LEN];
+  xSemaphoreTake(frameLogMutex, portMAX_DELAY);
+  frameLog.copy(frames);
+  uint32_t evicted = frameLog.evicted();
+  xSemaphoreGive(frameLogMutex);
+
+  FramePoolStats pool = framePool.stats();
+  char line[80];
+  server.setContentLength(CONTENT_LENGTH_UNKNOWN);
+  server.send(200, "application/json", "");
+  int n = snprintf(line, sizeof(line), "{\"pool\":{\"size\":%u,\"in_use\":%u,\"peak\":%u,",
+                   FRAME_POOL_SIZE, pool.inUse, pool.highWater);
+  server.sendContent(line, n);
+  n = snprintf(line, sizeof(line), "\"acquired\":%lu,\"exhausted\":%lu,\"evicted\":%lu},\"frames\":[",
+               (unsigned long)pool.acquired, (unsigned long)pool.exhausted, (unsigned long)evicted);
+  server.sendContent(line, n);
+
+  static const char kHex[] = "0123456789abcdef";
+  bool first = true;
+  for (const FrameRef& frame : frames) {
+    if (!frame) {
+      continue;
     }
-    else if(false) // if company details are not present in the web cloud
-    {
-      Serial.println("Redirecting to /P7.html");
-      DynamicJsonDocument responseDoc(1024);
-      responseDoc["status"] = "redirect";
-      responseDoc["url"] = "/P7.html";
-      String response;
-      serializeJson(responseDoc, response);
-      server.send(200, "application/json", response);
-      return;
+    n = snprintf(line, sizeof(line), "%s{\"seq\":%lu,\"from\":%u,\"ms\":%lu,\"data\":\"",
+                 first ? "" : ",", (unsigned long)frame->seq, frame->from, frame->receivedAt);
+    server.sendContent(line, n);
+    char hex[2 * MESH_FRAME_MAX_LEN];
+    for (uint8_t i = 0; i < frame->len; i++) {
+      hex[2 * i] = kHex[frame->data[i] >> 4];
+      hex[2 * i + 1] = kHex[frame->data[i] & 0x0F];
     }
-  } else {
-    server.send(405, "text/plain", "Method Not Allowed");
+    server.sendContent(hex, 2 * frame->len);
+    server.sendContent_P("\"}");
+    first = false;
   }
+  server.sendContent_P("]}");
+  server.sendContent_P("", 0);  // terminates the chunked response
 }
 
-void handleFillDataAutoOrNotPost() {
-  if (server.method() == HTTP_POST) {
-    String postBody = server.arg("plain");
-    DynamicJsonDocument doc(1024);
-    deserializeJson(doc, postBody);
-    
-    const char* fillDataOrNot = doc["selectedOption"];
-    
-    Serial.print("fillDataOrNot: ");
-    Serial.println(fillDataOrNot);
-
-    if (strcmp(fillDataOrNot, "yes") == 0)  // if User selected Yes
-    {
-      Serial.println("Redirecting to /P8.html");
-      DynamicJsonDocument responseDoc(1024);
-      responseDoc["status"] = "redirect";
-      responseDoc["url"] = "/P8.html";
-      String response;
-      serializeJson(responseDoc, response);
-      server.send(200, "application/json", response);
-      return;
+// Reads an unsigned query argument, or fallback when it is absent.
+static uint32_t queryArg(const char* name, uint32_t fallback) {
+  return server.hasArg(name) ? (uint32_t)strtoul(server.arg(name).c_str(), nullptr, 10) : fallback;
+}
+
+// Streams one page of the journal: ?from=<seq>&since=<ms>&until=<ms>&limit=<n>.
+// Records go from flash to the socket one at a time; "next" is the from= of the
+// following page, null once the end of the journal is reached.
+void handleJournalGet() {
+  uint32_t seq = queryArg("from", 0);
+  uint32_t since = queryArg("since", 0);
+  uint32_t until = queryArg("until", 0xFFFFFFFF);
+  uint32_t limit = queryArg("limit", JOURNAL_PAGE_DEFAULT);
+  if (limit == 0 || limit > JOURNAL_PAGE_MAX) {
+    limit = JOURNAL_PAGE_MAX;
+  }
+
+  xSemaphoreTake(journalMutex, portMAX_DELAY);
+  uint32_t oldest = journal.oldest();
+  uint32_t end = journal.end();
+  xSemaphoreGive(journalMutex);
+
+  char line[128];
+  server.setContentLength(CONTENT_LENGTH_UNKNOWN);
+  server.send(200, "application/json", "");
+  int n = snprintf(line, sizeof(line), "{\"oldest\":%lu,\"end\":%lu,\"records\":[",
+                   (unsigned long)oldest, (unsigned long)end);
+  server.sendContent(line, n);
+
+  bool more = false;
+  uint32_t sent = 0;
+  while (sent < limit) {
+    JournalRecord record;
+    xSemaphoreTake(journalMutex, portMAX_DELAY);
+    seq = journal.seekTime(seq, since, until);  // also moves past records overwritten meanwhile
+    more = seq != journal.end();
+    bool ok = more && journal.read(seq, &record);
+    xSemaphoreGive(journalMutex);
+    if (!more) {
+      break;
     }
-    if (strcmp(fillDataOrNot, "no") == 0) // if User selected No
-    {
-      Serial.println("Redirecting to /P7.html");
-      DynamicJsonDocument responseDoc(1024);
-      responseDoc["status"] = "redirect";
-      responseDoc["url"] = "/P7.html";
-      String response;
-      serializeJson(responseDoc, response);
-      server.send(200, "application/json", response);
-      return;
+    seq++;
+    if (!ok || record.time < since || record.time > until) {
+      continue;   // torn slot, or outside the range in a sector that overlaps it
     }
-  } else {
-    server.send(405, "text/plain", "Method Not Allowed");
+    n = snprintf(line, sizeof(line), "%s{\"seq\":%lu,\"time\":%lu,\"uptime\":%lu,\"event\":\"%s\",\"node\":%u,\"detail\":%u}",
+                 sent ? "," : "", (unsigned long)record.seq, (unsigned long)record.time,
+                 (unsigned long)record.uptime, journalEventName(record.event), record.node, record.detail);
+    server.sendContent(line, n);
+    sent++;
   }
-}
 
-void handleGetCompanyDetailsPost() {
-  if (server.method() == HTTP_POST) {
-    String postBody = server.arg("plain");
-    DynamicJsonDocument doc(2048);
-    deserializeJson(doc, postBody);
-
-    const char* companyName = doc["company-name"];
-    const char* companyAddress = doc["company-address"];
-    const char* keyPerson = doc["key-person"];
-    const char* contactDetails = doc["contact-details"];
-    const char* altPerson1 = doc["alt-person-1"];
-    const char* altContactDetails1 = doc["alt-contact-details-1"];
-    const char* altPerson2 = doc["alt-person-2"];
-    const char* altContactDetails2 = doc["alt-contact-details-2"];
-    const char* altPerson3 = doc["alt-person-3"];
-    const char* altContactDetails3 = doc["alt-contact-details-3"];
-    const char* altPerson4 = doc["alt-person-4"];
-    const char* altContactDetails4 = doc["alt-contact-details-4"];
-    const char* localFireDepartment = doc["local-fire-department"];
-    const char* localFireDepartmentContactDetails = doc["local-fire-department-contact-details"];
-
-    // Print data to Serial Monitor for debugging
-    Serial.print("Company Name: ");
-    Serial.println(companyName);
-    Serial.print("Company Address: ");
-    Serial.println(companyAddress);
-    Serial.print("Key Responsible Person: ");
-    Serial.println(keyPerson);
-    Serial.print("Contact Details: ");
-    Serial.println(contactDetails);
-    Serial.print("Alt Responsible Person (1): ");
-    Serial.println(altPerson1);
-    Serial.print("Contact Details (1): ");
-    Serial.println(altContactDetails1);
-    Serial.print("Alt Responsible Person (2): ");
-    Serial.println(altPerson2);
-    Serial.print("Contact Details (2): ");
-    Serial.println(altContactDetails2);
-    Serial.print("Alt Responsible Person (3): ");
-    Serial.println(altPerson3);
-    Serial.print("Contact Details (3): ");
-    Serial.println(altContactDetails3);
-    Serial.print("Alt Responsible Person (4): ");
-    Serial.println(altPerson4);
-    Serial.print("Contact Details (4): ");
-    Serial.println(altContactDetails4);
-    Serial.print("Local Fire Department: ");
-    Serial.println(localFireDepartment);
-    Serial.print("Local Fire Department Contact Details: ");
-    Serial.println(localFireDepartmentContactDetails);
-
-    Serial.println("Redirecting to /P8.html");
-    DynamicJsonDocument responseDoc(1024);
-    responseDoc["status"] = "redirect";
-    responseDoc["url"] = "/P8.html";
-    String response;
-    serializeJson(responseDoc, response);
-    server.send(200, "application/json", response);
-    return;
+  if (more) {
+    n = snprintf(line, sizeof(line), "],\"next\":%lu}", (unsigned long)seq);
+    server.sendContent(line, n);
   } else {
-    server.send(405, "text/plain", "Method Not Allowed");
+    server.sendContent_P("],\"next\":null}");
   }
+  server.sendContent_P("", 0);  // terminates the chunked response
 }
 
-void handleGetUnitDetailsPost() {
-  if (server.method() == HTTP_POST) {
-    String postBody = server.arg("plain");
-    DynamicJsonDocument doc(2048);
-    deserializeJson(doc, postBody);
-
-    // Extract data from the JSON document
-    const char* location = doc["location"];
-    const char* unitNumber = doc["unitNumber"];
-    const char* date = doc["date"];
-    const char* installer = doc["installer"];
-    const char* contact = doc["contact"];
-    const char* ipAddress = doc["ipAddress"];
-
-    // Print the extracted data to the Serial for debugging
-    Serial.print("Location: ");
-    Serial.println(location);
-    Serial.print("Unit Number: ");
-    Serial.println(unitNumber);
-    Serial.print("Date: ");
-    Serial.println(date);
-    Serial.print("Installer: ");
-    Serial.println(installer);
-    Serial.print("Contact: ");
-    Serial.println(contact);
-    Serial.print("IP Address: ");
-    Serial.println(ipAddress);
-
-    Serial.println("Redirecting to /P9.html");
-    DynamicJsonDocument responseDoc(1024);
-    responseDoc["status"] = "redirect";
-    responseDoc["url"] = "/P9.html";
-    String response;
-    serializeJson(responseDoc, response);
-    server.send(200, "application/json", response);
-    return;
-  } else {
-    server.send(405, "text/plain", "Method Not Allowed");
+// Streams the radio trace as a binary dump (radio_trace.h), oldest record first.
+// The ring is copied out a chunk at a time, so recording carries on meanwhile.
+void handleTraceGet() {
+  // Paused, the writer cannot overtake the dump; what it misses is reported in the next one.
+  TraceFileHeader header;
+  xSemaphoreTake(traceMutex, portMAX_DELAY);
+  radioTrace.setPaused(true);
+  uint32_t pos = radioTrace.start();
+  header.dropped = radioTrace.dropped();
+  xSemaphoreGive(traceMutex);
+  header.magic = TRACE_MAGIC;
+  header.version = TRACE_VERSION;
+  header.node = mesh.thisAddress();
+  header.role = NODE_ROLE;
+  header.reserved = 0;
+
+  server.setContentLength(CONTENT_LENGTH_UNKNOWN);
+  server.sendHeader("Content-Disposition", "attachment; filename=\"trace.bin\"");
+  server.send(200, "application/octet-stream", "");
+  server.sendContent((const char*)&header, sizeof(header));
+
+  uint8_t chunk[TRACE_CHUNK];
+  for (;;) {
+    xSemaphoreTake(traceMutex, portMAX_DELAY);
+    size_t n = radioTrace.copy(&pos, chunk, sizeof(chunk));
+    xSemaphoreGive(traceMutex);
+    if (n == 0) {
+      break;
+    }
+    server.sendContent((const char*)chunk, n);
   }
+  xSemaphoreTake(traceMutex, portMAX_DELAY);
+  radioTrace.setPaused(false);
+  xSemaphoreGive(traceMutex);
+  server.sendContent_P("", 0);  // terminates the chunked response
 }
 
-void handleGetManufacturerDetailsPost() {
-  if (server.method() == HTTP_POST) {
-    String postBody = server.arg("plain");
-    DynamicJsonDocument doc(2048);
-    deserializeJson(doc, postBody);
-
-    // Extract data from the JSON document
-    const char* manufacturer_name = doc["name"];
-    const char* contact = doc["contact"];
-    const char* email = doc["email"];
-    const char* date_of_manufacture = doc["date"];
-    const char* serial = doc["serial"];
-
-    Serial.print("Manufacturer Name: ");
-    Serial.println(manufacturer_name);
-    Serial.print("Contact: ");
-    Serial.println(contact);
-    Serial.print("Email: ");
-    Serial.println(email);
-    Serial.print("Date of Manufacture: ");
-    Serial.println(date_of_manufacture);
-    Serial.print("Serial: ");
-    Serial.println(serial);
-
-    Serial.println("Redirecting to /P10.html");
-    DynamicJsonDocument responseDoc(1024);
-    responseDoc["status"] = "redirect";
-    responseDoc["url"] = "/P10.html";
-    String response;
-    serializeJson(responseDoc, response);
-    server.send(200, "application/json", response);
+// Switches recording on or off and clears the trace: {"record":true|false,"clear":true}.
+void handleTracePost() {
+  StaticJsonDocument<64> doc;
+  if (deserializeJson(doc, server.arg("plain"))) {
+    server.send(400, "application/json", "{\"status\":\"Invalid request\"}");
     return;
-  } else {
-    server.send(405, "text/plain", "Method Not Allowed");
   }
-}
-
-void handleGetWifiAccessPointPost() {
-  if (server.method() == HTTP_POST) {
-    String postBody = server.arg("plain");
-    DynamicJsonDocument doc(1024);
-    deserializeJson(doc, postBody);
-    
-    const char* wifi_ssid_access_point = doc["ssid"];
-    const char* wifi_password_access_point = doc["password"];
-    
-    Serial.print("wifi_ssid_access_point: ");
-    Serial.println(wifi_ssid_access_point);
-    Serial.print("wifi_password_access_point: ");
-    Serial.println(wifi_password_access_point);
-
-    Serial.println("Redirecting to /P0.html");
-    DynamicJsonDocument responseDoc(1024);
-    responseDoc["status"] = "redirect";
-    responseDoc["url"] = "/P0.html";
-    String response;
-    serializeJson(responseDoc, response);
-    server.send(200, "application/json", response);
-
-    //Change Wifi access point credentials here and save them in EEPROM and then restart
-
-  } else {
-    server.send(405, "text/plain", "Method Not Allowed");
+  xSemaphoreTake(traceMutex, portMAX_DELAY);
+  if (doc.containsKey("record")) {
+    radioTrace.setEnabled(doc["record"].as<bool>());
+  }
+  if (doc["clear"] | false) {
+    radioTrace.clear();
   }
+  bool recording = radioTrace.isEnabled();
+  uint32_t bytes = radioTrace.end() - radioTrace.start();
+  uint32_t dropped = radioTrace.dropped();
+  xSemaphoreGive(traceMutex);
+
+  char response[80];
+  snprintf(response, sizeof(response), "{\"status\":\"ok\",\"record\":%s,\"bytes\":%lu,\"dropped\":%lu}",
+           recording ? "true" : "false", (unsigned long)bytes, (unsigned long)dropped);
+  server.send(200, "application/json", response);
 }
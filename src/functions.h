@@ -15,19 +15,58 @@
 // For LoRa Mesh networking
 #include <RH_E32.h>
 #include <RHMesh.h>
-#include <vector>
 
 #include <WiFi.h>
 #include <WebServer.h>
 #include <SPIFFS.h>
 #include <ArduinoJson.h>
 
+#include "config_sync.h"
+#include "constants.h"
+
 struct NodeStatus {
     uint8_t nodeId;
-    unsigned long lastSeen;
+    unsigned long lastSeen;      // local millis(), for timeouts
+    uint32_t lastSeenNetwork;    // network time, comparable across nodes
     bool isActive;
 };
 
+/**
+ * @brief Statically allocated table of the nodes heard so far.
+ *
+ * Capacity is a build parameter (MAX_NODES), so the table needs no heap
+ * and its size shows up in the image's static RAM.
+ */
+template <uint16_t Capacity>
+class NodeTable {
+public:
+    NodeTable() : count(0) {}
+
+    NodeStatus* begin() { return entries; }
+    NodeStatus* end() { return entries + count; }
+    const NodeStatus* begin() const { return entries; }
+    const NodeStatus* end() const { return entries + count; }
+    size_t size() const { return count; }
+    bool full() const { return count == Capacity; }
+
+    // Appends a node; false if the table is full.
+    bool push_back(const NodeStatus& status) {
+        if (full()) {
+            return false;
+        }
+        entries[count++] = status;
+        return true;
+    }
+    void pop_back() { if (count > 0) count--; }
+    void clear() { count = 0; }
+
+private:
+    NodeStatus entries[Capacity];
+    uint16_t count;
+};
+
+extern NodeTable<MAX_NODES> nodeStatuses;
+
 /**
  * @brief Converts a status code to a human-readable error string.
  *
@@ -39,6 +78,15 @@ const __FlashStringHelper* getErrorString(uint8_t status);
 // For LoRa Mesh
 void LoRatask(void* parameter);
 
+/**
+ * @brief Installs the UART driver for the E32 on LORA_RXPIN/LORA_TXPIN.
+ *
+ * Call once from setup() before initializeMESH().
+ *
+ * @return false if the driver could not be installed.
+ */
+bool initializeLoRaLink();
+
 /**
  * @brief Initializes the MESH network.
  *
@@ -46,24 +94,111 @@ void LoRatask(void* parameter);
  */
 bool initializeMESH();
 
+/**
+ * @brief Writes the wake-up period for FRS_WAKE_LATENCY_MS to the E32 and selects wake-up mode.
+ *
+ * Call once from setup() after initializeMESH(); does nothing without a latency budget.
+ *
+ * @return false if the E32 did not take the parameters.
+ */
+bool initializeLowPower();
+
+/**
+ * @brief Lets LoRatask put the E32 and the ESP32 to sleep between its windows.
+ *
+ * Call once Wi-Fi is off; light sleep would drop the access point.
+ */
+void startLowPowerSleep();
+
+/**
+ * @brief Loads the versioned site config from the "siterec" flash partition.
+ *
+ * Call once from setup() before the mesh and web server start.
+ *
+ * @return true if the partition was found and mapped.
+ */
+bool initializeSiteStore();
+
+/**
+ * @brief Opens the event journal in the "journal" flash partition and records the boot.
+ *
+ * Call once from setup() after initializeSiteStore().
+ *
+ * @return true if the partition was found and mapped.
+ */
+bool initializeJournal();
+
+/**
+ * @brief Configures the relay groups listed in RELAY_GROUPS and switches them off.
+ *
+ * @return False if a group was rejected.
+ */
+bool initializeRelays();
+
+/**
+ * @brief Writes the current site config to flash as a new packed image.
+ */
+void persistSiteConfig();
+
+/**
+ * @brief Returns the credentials for the portal access point.
+ *
+ * These are the SSID and password stored by the wizard; without them, or
+ * if they are not valid WPA2 credentials, AP_SSID and AP_PASSWORD.
+ *
+ * @param ssid Receives the SSID, CONFIG_VALUE_MAX bytes.
+ * @param password Receives the password, CONFIG_VALUE_MAX bytes.
+ */
+void accessPointCredentials(char* ssid, char* password);
+
 /**
  * @brief Broadcasts the presence of the current node to other nodes in the network.
+ *
+ * The beacon carries this node's network time and config digest; once the
+ * clock is synced LoRatask sends it in the node's TDMA slot.
  */
 void broadcastPresence();
 
-// Broadcasts active message 
+/**
+ * @brief Sends a payload larger than one mesh frame to a neighbouring node.
+ *
+ * The payload is fragmented and sent with a sliding window; missing
+ * fragments are retransmitted from the receiver's ACK bitmap.
+ *
+ * @param dest The ID of the destination node.
+ * @param data The payload to send (copied before returning).
+ * @param len The payload length, at most XFER_MAX_PAYLOAD bytes.
+ * @return true if the transfer was started, false if one is already running.
+ */
+bool sendPayload(uint8_t dest, const uint8_t* data, size_t len);
+
+/**
+ * @brief Writes a portal field into the versioned site config.
+ *
+ * The new version reaches the other nodes on the next sync round.
+ *
+ * @param field The field to write.
+ * @param value The new value; nullptr is stored as an empty string.
+ */
+void updateConfigField(ConfigField field, const char* value);
+
+#if FRS_ESCALATOR
+// Switches the relays on; LoRatask broadcasts the active message in the next contention slot
 void activeState();
 
-// Broadcasts inactive message 
+// Switches the relays off; LoRatask broadcasts the inactive message in the next contention slot
 void inactiveState();
+#endif
 
 /**
  * @brief Listens for incoming messages from other nodes.
  *
  * This function handle communication with other nodes, including receiving
- * and responding to messages.
+ * and responding to messages. Only LoRatask calls it: the task owns the radio.
+ *
+ * @param timeoutMs How long to wait for a frame.
  */
-void listenForNodes();
+void listenForNodes(uint16_t timeoutMs = 2000);
 
 /**
  * @brief Updates the status of a node given its ID.
@@ -105,17 +240,35 @@ void printNetworkStats();
 
 void handleFileRead(String path);
 void handleRoot();
-void handleSettingsOptionPost();
-void handleConnectPost();
-void handleClientLoginPost();
-void handleAdminLoginPost();
-void handleWifiConnectPost();
-void handleUniqueKeyPost();
-void handleFillDataAutoOrNotPost();
-void handleGetCompanyDetailsPost();
-void handleGetUnitDetailsPost();
-void handleGetManufacturerDetailsPost();
-void handleGetWifiAccessPointPost();
+void handleProfileGet();
+
+/**
+ * @brief Handles the login, WiFi and unique key steps of the portal wizard in one request.
+ *
+ * The node has nothing to check these fields against, so they are only
+ * logged. Replies with the next step and the stored site records for prefill.
+ */
+void handleWizardAccessPost();
+
+/**
+ * @brief Saves any of the company, unit, manufacturer and access point sections in one request.
+ *
+ * Rejects access point credentials that are not valid WPA2 ones, before anything is saved.
+ */
+void handleWizardSitePost();
+
+// Portal prefill, streamed from the site record store
+void handleCompanyDetailsGet();
+void handleUnitDetailsGet();
+void handleManufacturerDetailsGet();
+void handleFramesGet();
+
+// Event journal, one page per request, streamed from flash
+void handleJournalGet();
+
+// Radio trace for tools/replay: GET dumps it, POST {"record","clear"} controls it
+void handleTraceGet();
+void handleTracePost();
 
 
 #endif // FUNCTIONS_H
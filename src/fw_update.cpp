@@ -0,0 +1,295 @@
+/*
+ Project Name ------  FRS
+ Task --------------  Escalator Node Firmware with Esp32
+ Engineer ----------- Muhammad Usman
+ File --------------- Firmware Broadcast Receiver Source File
+ Company -----------  Machadev Pvt Limited
+ */
+
+// Import Libraries
+#include "fw_update.h"
+#include <esp_ota_ops.h>
+#include <mbedtls/sha256.h>
+#include <string.h>
+
+static_assert(FW_CHUNK_LEN <= MESH_FRAME_MAX_LEN, "a chunk must fit one mesh frame");
+static_assert(FW_STATUS_MAX_LEN <= MESH_FRAME_MAX_LEN, "a status must fit one mesh frame");
+
+static uint16_t readU16(const uint8_t* p) {
+    return (uint16_t)(p[0] | (p[1] << 8));
+}
+
+static uint32_t readU32(const uint8_t* p) {
+    return (uint32_t)p[0] | ((uint32_t)p[1] << 8) | ((uint32_t)p[2] << 16) | ((uint32_t)p[3] << 24);
+}
+
+FirmwareReceiver::FirmwareReceiver(SendFrameFn sendFrame)
+    : sendFrame(sendFrame), selfId(0), fwState(FW_IDLE), image(0), imageSize(0), target(nullptr),
+      hashing(nullptr), hashOffset(0), acknowledged(false), statusPending(false), statusDue(0), readyAt(0) {
+    mbedtls_sha256_init(&hashCtx);
+    memset(imageHash, 0, sizeof(imageHash));
+    memset(done, 0, sizeof(done));
+    memset(erased, 0, sizeof(erased));
+    memset(&counters, 0, sizeof(counters));
+    for (DecoderSlot& slot : slots) {
+        slot.inUse = false;
+    }
+}
+
+void FirmwareReceiver::begin(uint8_t id) {
+    selfId = id;
+}
+
+// Starts receiving the announced image into the next OTA partition.
+FirmwareEvent FirmwareReceiver::startSession() {
+    target = esp_ota_get_next_update_partition(nullptr);
+    uint32_t generations = (imageSize + FOUNTAIN_GEN_BYTES - 1) / FOUNTAIN_GEN_BYTES;
+    if (target == nullptr || imageSize == 0 || imageSize > target->size || generations > FW_MAX_GENERATIONS) {
+        fwState = FW_FAILED;
+        return FW_EVENT_FLASH_ERROR;
+    }
+    memset(done, 0, sizeof(done));
+    memset(erased, 0, sizeof(erased));
+    memset(&counters, 0, sizeof(counters));
+    acknowledged = false;
+    statusPending = false;
+    counters.generationsTotal = (uint16_t)generations;
+    for (DecoderSlot& slot : slots) {
+        slot.inUse = false;
+    }
+    fwState = FW_RECEIVING;
+    return FW_EVENT_STARTED;
+}
+
+FirmwareEvent FirmwareReceiver::onAnnounce(const uint8_t* frame, uint8_t len) {
+    if (len < FW_ANNOUNCE_LEN) {
+        return FW_EVENT_NONE;
+    }
+    uint16_t id = readU16(frame + 1);
+    if (fwState == FW_READY || (fwState != FW_IDLE && fwState != FW_FAILED && id == image)) {
+        return FW_EVENT_NONE;   // a verified image waits for the restart, or this one is under way
+    }
+    image = id;
+    imageSize = readU32(frame + 3);
+    memcpy(imageHash, frame + 7, sizeof(imageHash));
+
+    // An image that does not fit the running partition cannot be the one running.
+    const esp_partition_t* running = esp_ota_get_running_partition();
+    if (running == nullptr || imageSize == 0 || imageSize > running->size) {
+        return startSession();
+    }
+    fwState = FW_CHECKING;
+    startHash(running);
+    return FW_EVENT_NONE;
+}
+
+void FirmwareReceiver::onQuery(const uint8_t* frame, uint8_t len, unsigned long now) {
+    if (len < FW_QUERY_LEN || readU16(frame + 1) != image ||
+        (fwState != FW_RECEIVING && fwState != FW_READY && fwState != FW_CURRENT)) {
+        return;
+    }
+    uint8_t round = frame[3];
+    uint8_t slots = frame[4];
+    const uint8_t* doneMap = frame + 5;
+    if (doneMap[selfId / 8] & (1u << (selfId % 8))) {
+        acknowledged = true;
+        return;
+    }
+    if (slots == 0) {
+        return;
+    }
+    // A fresh slot every round, so two nodes that collided once are unlikely to again.
+    uint32_t mix = (uint32_t)selfId * 0x9E3779B1u ^ (uint32_t)round * 0x85EBCA6Bu;
+    mix ^= mix >> 15;
+    mix *= 0x2C1B3C6Du;
+    mix ^= mix >> 13;
+    statusPending = true;
+    statusDue = now + (unsigned long)(mix % slots) * FW_STATUS_SLOT_MS;
+}
+
+// The slot already decoding this generation, else a free one. Otherwise the
+// slot with the least progress is dropped, so nearly complete generations
+// only need a few repair symbols in the next pass.
+FirmwareReceiver::DecoderSlot* FirmwareReceiver::slotFor(uint16_t generation, unsigned long now) {
+    DecoderSlot* victim = &slots[0];
+    for (DecoderSlot& slot : slots) {
+        if (slot.inUse && slot.decoder.generation() == generation) {
+            slot.lastUse = now;
+            return &slot;
+        }
+    }
+    for (DecoderSlot& slot : slots) {
+        if (!slot.inUse) {
+            victim = &slot;
+            break;
+        }
+        if (slot.decoder.rank() < victim->decoder.rank() ||
+            (slot.decoder.rank() == victim->decoder.rank() && slot.lastUse < victim->lastUse)) {
+            victim = &slot;
+        }
+    }
+    if (victim->inUse) {
+        counters.evictions++;
+    }
+    victim->inUse = true;
+    victim->lastUse = now;
+    victim->decoder.reset(generation);
+    return victim;
+}
+
+FirmwareEvent FirmwareReceiver::onChunk(const uint8_t* frame, uint8_t len, unsigned long now) {
+    if (fwState != FW_RECEIVING || len < FW_CHUNK_LEN || readU16(frame + 1) != image) {
+        return FW_EVENT_NONE;
+    }
+    uint16_t generation = readU16(frame + 3);
+    if (generation >= counters.generationsTotal) {
+        return FW_EVENT_NONE;
+    }
+    counters.chunks++;
+    if (isDone(generation)) {
+        counters.redundant++;
+        return FW_EVENT_NONE;
+    }
+
+    DecoderSlot* slot = slotFor(generation, now);
+    uint32_t coefficients = fountainCoefficients(image, generation, readU16(frame + 5));
+    if (slot->decoder.add(coefficients, frame + FW_CHUNK_HEADER_LEN)) {
+        counters.innovative++;
+    }
+    if (!slot->decoder.complete()) {
+        return FW_EVENT_NONE;
+    }
+    FirmwareEvent event = storeGeneration(*slot);
+    if (event == FW_EVENT_NONE && counters.generationsDone == counters.generationsTotal) {
+        fwState = FW_VERIFYING;   // poll() reads the image back
+        startHash(target);
+    }
+    return event;
+}
+
+// Writes a decoded generation; its 4 KB sector is erased the first time it is touched.
+FirmwareEvent FirmwareReceiver::storeGeneration(DecoderSlot& slot) {
+    uint16_t generation = slot.decoder.generation();
+    slot.decoder.solve(generationBuf);
+    slot.inUse = false;
+
+    uint32_t offset = (uint32_t)generation * FOUNTAIN_GEN_BYTES;
+    uint32_t sector = offset / 4096;
+    if ((erased[sector / 8] & (1u << (sector % 8))) == 0) {
+        if (esp_partition_erase_range(target, sector * 4096, 4096) != ESP_OK) {
+            fwState = FW_FAILED;
+            return FW_EVENT_FLASH_ERROR;
+        }
+        erased[sector / 8] |= (uint8_t)(1u << (sector % 8));
+    }
+    size_t length = imageSize - offset < FOUNTAIN_GEN_BYTES ? imageSize - offset : FOUNTAIN_GEN_BYTES;
+    if (esp_partition_write(target, offset, generationBuf, length) != ESP_OK) {
+        fwState = FW_FAILED;
+        return FW_EVENT_FLASH_ERROR;
+    }
+    done[generation / 8] |= (uint8_t)(1u << (generation % 8));
+    counters.generationsDone++;
+    return FW_EVENT_NONE;
+}
+
+// Starts hashing the first imageSize bytes of a partition; poll() does the reading.
+void FirmwareReceiver::startHash(const esp_partition_t* partition) {
+    mbedtls_sha256_free(&hashCtx);   // a check cut short by a new announce leaves it open
+    mbedtls_sha256_init(&hashCtx);
+    mbedtls_sha256_starts(&hashCtx, 0);
+    hashing = partition;
+    hashOffset = 0;
+}
+
+// Hashes the next FW_HASH_STEP bytes. At the end, a checked running image either
+// matches or starts the session; a received image becomes the boot partition on a match.
+FirmwareEvent FirmwareReceiver::hashStep(unsigned long now) {
+    uint32_t end = imageSize - hashOffset > FW_HASH_STEP ? hashOffset + FW_HASH_STEP : imageSize;
+    while (hashOffset < end) {
+        size_t length = end - hashOffset < sizeof(generationBuf) ? end - hashOffset : sizeof(generationBuf);
+        esp_partition_read(hashing, hashOffset, generationBuf, length);
+        mbedtls_sha256_update(&hashCtx, generationBuf, length);
+        hashOffset += length;
+    }
+    if (hashOffset < imageSize) {
+        return FW_EVENT_NONE;
+    }
+    uint8_t digest[32];
+    mbedtls_sha256_finish(&hashCtx, digest);
+    mbedtls_sha256_free(&hashCtx);
+    mbedtls_sha256_init(&hashCtx);
+    bool match = memcmp(digest, imageHash, sizeof(digest)) == 0;
+
+    if (fwState == FW_CHECKING) {
+        if (!match) {
+            return startSession();
+        }
+        memset(&counters, 0, sizeof(counters));
+        counters.generationsTotal = (uint16_t)((imageSize + FOUNTAIN_GEN_BYTES - 1) / FOUNTAIN_GEN_BYTES);
+        counters.generationsDone = counters.generationsTotal;   // the status reply reports nothing missing
+        acknowledged = false;
+        fwState = FW_CURRENT;
+        return FW_EVENT_CURRENT;
+    }
+    if (!match) {
+        fwState = FW_FAILED;
+        return FW_EVENT_BAD_HASH;
+    }
+    if (esp_ota_set_boot_partition(target) != ESP_OK) {
+        fwState = FW_FAILED;
+        return FW_EVENT_FLASH_ERROR;
+    }
+    fwState = FW_READY;
+    readyAt = now;
+    return FW_EVENT_VERIFIED;
+}
+
+FirmwareEvent FirmwareReceiver::poll(unsigned long now) {
+    FirmwareEvent event = FW_EVENT_NONE;
+    if (fwState == FW_CHECKING || fwState == FW_VERIFYING) {
+        event = hashStep(now);
+    }
+    if (statusPending && (long)(now - statusDue) >= 0) {
+        statusPending = false;
+        if (fwState == FW_RECEIVING || fwState == FW_READY || fwState == FW_CURRENT) {
+            sendStatus();
+        }
+    }
+    return event;
+}
+
+bool FirmwareReceiver::restartDue(unsigned long now) const {
+    return fwState == FW_READY && (acknowledged || now - readyAt >= FW_RESTART_DELAY_MS);
+}
+
+// Lists the first generations still missing with the symbols each needs.
+void FirmwareReceiver::sendStatus() {
+    uint8_t frame[FW_STATUS_MAX_LEN];
+    uint16_t missing = (uint16_t)(counters.generationsTotal - counters.generationsDone);
+    uint8_t n = 0;
+    for (uint16_t g = 0; g < counters.generationsTotal && n < FW_STATUS_MAX_ENTRIES; g++) {
+        if (isDone(g)) {
+            continue;
+        }
+        uint8_t deficit = FOUNTAIN_GEN_SYMBOLS;
+        for (const DecoderSlot& slot : slots) {
+            if (slot.inUse && slot.decoder.generation() == g) {
+                deficit = (uint8_t)(FOUNTAIN_GEN_SYMBOLS - slot.decoder.rank());
+            }
+        }
+        uint8_t* entry = frame + FW_STATUS_HEADER_LEN + 3 * n;
+        entry[0] = (uint8_t)g;
+        entry[1] = (uint8_t)(g >> 8);
+        entry[2] = deficit;
+        n++;
+    }
+    frame[0] = MSG_FW_STATUS;
+    frame[1] = (uint8_t)image;
+    frame[2] = (uint8_t)(image >> 8);
+    frame[3] = (uint8_t)missing;
+    frame[4] = (uint8_t)(missing >> 8);
+    frame[5] = n;
+    if (sendFrame(frame, (uint8_t)(FW_STATUS_HEADER_LEN + 3 * n))) {
+        counters.statusSent++;
+    }
+}
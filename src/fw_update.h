@@ -0,0 +1,170 @@
+/*
+ Project Name ------  FRS
+ Task --------------  Escalator Node Firmware with Esp32
+ Engineer ----------- Muhammad Usman
+ File --------------- Firmware Broadcast Receiver Header File
+ Company -----------  Machadev Pvt Limited
+ */
+
+// fw_update.h
+#ifndef FW_UPDATE_H
+#define FW_UPDATE_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include <esp_partition.h>
+#include <mbedtls/sha256.h>
+#include "fountain.h"
+#include "protocol.h"
+
+/*
+ Firmware images are broadcast once to every node as fountain-coded
+ symbols (see fountain.h); there are no per-node retransmissions.
+
+   ANNOUNCE: [MSG_FW_ANNOUNCE][imageId u16][size u32][sha256 x32]
+   CHUNK:    [MSG_FW_CHUNK][imageId u16][generation u16][seed u16][symbol x32]
+   QUERY:    [MSG_FW_QUERY][imageId u16][round][slots][done bitmap x32]
+   STATUS:   [MSG_FW_STATUS][imageId u16][missing u16][n]([generation u16][deficit])*n
+
+ The controller announces an image, then sends every generation with a
+ few repair symbols. At the end of a pass it announces again and sends a
+ query. Every node whose bit is not yet set in the done bitmap answers
+ in one of `slots` time slots, picked by hashing its ID with the round.
+ The answer lists the generations it still lacks and how many symbols
+ each one needs, or none once it has finished. The next pass only sends
+ fresh repair symbols for the reported generations, so one symbol fills
+ a different gap on every node that needs it. A node restarts into the
+ new image once the controller has marked it done.
+
+ A node first hashes the same number of bytes of the partition it runs
+ from; if they match the announced SHA-256 it already runs the image and
+ only reports itself done. Otherwise it writes each decoded generation
+ into the next OTA partition. With all of them written, it checks the
+ SHA-256 of the image and makes that partition the boot partition. Both
+ hashes are computed FW_HASH_STEP bytes at a time from poll(), so frame
+ dispatch never waits for a whole partition to be read back; chunks that
+ arrive during the first check are dropped and come back in the repairs.
+ All integers are little endian.
+
+ The update is not authenticated. The SHA-256 only detects a corrupted
+ transfer: any radio on the channel that speaks this protocol can
+ announce an image, and the nodes will boot it. Do not rely on this
+ where the channel is not trusted.
+*/
+
+constexpr uint8_t FW_ANNOUNCE_LEN = 39;
+constexpr uint8_t FW_QUERY_LEN = 37;
+constexpr uint8_t FW_CHUNK_HEADER_LEN = 7;
+constexpr uint8_t FW_CHUNK_LEN = FW_CHUNK_HEADER_LEN + FOUNTAIN_SYMBOL_LEN;
+constexpr uint8_t FW_STATUS_HEADER_LEN = 6;
+constexpr uint8_t FW_STATUS_MAX_ENTRIES = 12;
+constexpr uint8_t FW_STATUS_MAX_LEN = FW_STATUS_HEADER_LEN + 3 * FW_STATUS_MAX_ENTRIES;
+constexpr uint16_t FW_MAX_GENERATIONS = 0x140000 / FOUNTAIN_GEN_BYTES;  // one app partition
+constexpr uint8_t FW_DECODER_SLOTS = 8;         // partly received generations kept (about 1.2 KB each)
+constexpr unsigned long FW_STATUS_SLOT_MS = 400;  // one status frame on air at 2.4 kbps, with margin
+constexpr unsigned long FW_RESTART_DELAY_MS = 600000;  // reboot anyway if the controller never marks this node done
+constexpr uint32_t FW_HASH_STEP = 32768;        // bytes read back and hashed per poll()
+
+enum FirmwareState : uint8_t {
+    FW_IDLE,
+    FW_CHECKING,  // hashing the running partition against the announced image
+    FW_RECEIVING,
+    FW_VERIFYING, // every generation written, hashing the image back from flash
+    FW_READY,     // verified and set as boot partition, waiting to be marked done
+    FW_CURRENT,   // the announced image is the one running; nothing to receive
+    FW_FAILED,    // hash mismatch or flash error; the next announce starts over
+};
+
+enum FirmwareEvent : uint8_t {
+    FW_EVENT_NONE,
+    FW_EVENT_STARTED,
+    FW_EVENT_CURRENT,
+    FW_EVENT_VERIFIED,
+    FW_EVENT_BAD_HASH,
+    FW_EVENT_FLASH_ERROR,
+};
+
+struct FirmwareStats {
+    uint32_t chunks;
+    uint32_t innovative;   // chunks that raised a decoder's rank
+    uint32_t redundant;    // chunks for generations already written
+    uint32_t evictions;    // partly decoded generations dropped for lack of a slot
+    uint16_t generationsDone;
+    uint16_t generationsTotal;
+    uint16_t statusSent;
+};
+
+class FirmwareReceiver {
+public:
+    // Broadcasts one frame; returns false if the radio refused it.
+    typedef bool (*SendFrameFn)(const uint8_t* frame, uint8_t len);
+
+    explicit FirmwareReceiver(SendFrameFn sendFrame);
+
+    /**
+     * @brief Sets the node ID used to pick this node's status slot.
+     */
+    void begin(uint8_t selfId);
+
+    // Checks a new image against the running one; ignored while a verified image waits for the restart.
+    FirmwareEvent onAnnounce(const uint8_t* frame, uint8_t len);
+
+    // Schedules a status reply unless the controller has marked this node done.
+    void onQuery(const uint8_t* frame, uint8_t len, unsigned long now);
+
+    // Feeds one coded symbol; may complete a generation or the whole image.
+    FirmwareEvent onChunk(const uint8_t* frame, uint8_t len, unsigned long now);
+
+    /**
+     * @brief Advances a running hash check and sends a due status reply;
+     *        call regularly from the LoRa task.
+     *
+     * @return The outcome of a hash check that finished in this call.
+     */
+    FirmwareEvent poll(unsigned long now);
+
+    // True once the new image is the boot partition and the controller knows, or has gone quiet.
+    bool restartDue(unsigned long now) const;
+
+    FirmwareState state() const { return fwState; }
+    uint16_t imageId() const { return image; }
+    const FirmwareStats& stats() const { return counters; }
+
+private:
+    struct DecoderSlot {
+        bool inUse;
+        unsigned long lastUse;
+        FountainDecoder decoder;
+    };
+
+    FirmwareEvent startSession();
+    FirmwareEvent storeGeneration(DecoderSlot& slot);
+    void startHash(const esp_partition_t* partition);
+    FirmwareEvent hashStep(unsigned long now);
+    DecoderSlot* slotFor(uint16_t generation, unsigned long now);
+    void sendStatus();
+
+    bool isDone(uint16_t generation) const { return done[generation / 8] & (1u << (generation % 8)); }
+
+    SendFrameFn sendFrame;
+    uint8_t selfId;
+    FirmwareState fwState;
+    uint16_t image;
+    uint32_t imageSize;
+    uint8_t imageHash[32];
+    const esp_partition_t* target;
+    const esp_partition_t* hashing;   // partition poll() is hashing
+    uint32_t hashOffset;
+    mbedtls_sha256_context hashCtx;
+    bool acknowledged;
+    bool statusPending;
+    unsigned long statusDue;
+    unsigned long readyAt;
+    uint8_t done[(FW_MAX_GENERATIONS + 7) / 8];
+    uint8_t erased[(FW_MAX_GENERATIONS * FOUNTAIN_GEN_BYTES / 4096 + 7) / 8];
+    DecoderSlot slots[FW_DECODER_SLOTS];
+    uint8_t generationBuf[FOUNTAIN_GEN_BYTES];
+    FirmwareStats counters;
+};
+
+#endif // FW_UPDATE_H
@@ -0,0 +1,230 @@
+/*
+ Project Name ------  FRS
+ Task --------------  Escalator Node Firmware with Esp32
+ Engineer ----------- Muhammad Usman
+ File --------------- Event Journal Source File
+ Company -----------  Machadev Pvt Limited
+ */
+
+// Import Libraries
+#include "journal.h"
+#include <esp_rom_crc.h>
+#include <string.h>
+
+// Returns the lower-case name of an event.
+const char* journalEventName(uint8_t event) {
+    switch (event) {
+        case JOURNAL_BOOT: return "boot";
+        case JOURNAL_ACTIVATED: return "activated";
+        case JOURNAL_DEACTIVATED: return "deactivated";
+        case JOURNAL_NODE_DEAD: return "node_dead";
+        case JOURNAL_NODE_BACK: return "node_back";
+        case JOURNAL_SEND_FAILED: return "send_failed";
+        default: return "unknown";
+    }
+}
+
+static uint8_t recordCheck(const JournalRecord& record) {
+    return (uint8_t)esp_rom_crc32_le(0, (const uint8_t*)&record, offsetof(JournalRecord, check));
+}
+
+// True if no byte of the slot has been programmed since the sector was erased.
+static bool slotErased(const JournalRecord* record) {
+    const uint8_t* bytes = (const uint8_t*)record;
+    for (size_t i = 0; i < sizeof(JournalRecord); i++) {
+        if (bytes[i] != 0xFF) {
+            return false;
+        }
+    }
+    return true;
+}
+
+EventJournal::EventJournal()
+    : partition(nullptr), mapHandle(0), mapped(nullptr), sectorCount(0), oldestSector(0), headSector(0),
+      headBase(0), headSlot(0) {
+    memset(minTime, 0xFF, sizeof(minTime));
+    memset(maxTime, 0, sizeof(maxTime));
+}
+
+// Finds and maps the "journal" partition, then rebuilds the ring and its time index from flash.
+bool EventJournal::begin() {
+    partition = esp_partition_find_first(ESP_PARTITION_TYPE_DATA, ESP_PARTITION_SUBTYPE_ANY, "journal");
+    if (partition == nullptr || partition->size < 2 * JOURNAL_SECTOR_SIZE) {
+        return false;
+    }
+    size_t sectors = partition->size / JOURNAL_SECTOR_SIZE;
+    sectorCount = (uint8_t)(sectors < JOURNAL_MAX_SECTORS ? sectors : JOURNAL_MAX_SECTORS);
+    const void* ptr = nullptr;
+    if (esp_partition_mmap(partition, 0, sectorCount * JOURNAL_SECTOR_SIZE, ESP_PARTITION_MMAP_DATA,
+                           &ptr, &mapHandle) != ESP_OK) {
+        return false;
+    }
+    mapped = (const uint8_t*)ptr;
+
+    // The head is the valid sector with the highest base.
+    bool found = false;
+    for (uint8_t sector = 0; sector < sectorCount; sector++) {
+        if (!sectorValid(sector)) {
+            continue;
+        }
+        uint32_t base = sectorHeader(sector)->baseSeq;
+        if (!found || (int32_t)(base - headBase) > 0) {
+            headSector = sector;
+            headBase = base;
+            found = true;
+        }
+    }
+    if (!found) {
+        oldestSector = 0;
+        return startSector(0, 0);
+    }
+
+    // Walk back while the bases run on; anything else is left for reuse.
+    oldestSector = headSector;
+    for (uint8_t i = 1; i < sectorCount; i++) {
+        uint8_t prev = (uint8_t)((oldestSector + sectorCount - 1) % sectorCount);
+        if (!sectorValid(prev) ||
+            sectorHeader(prev)->baseSeq != sectorHeader(oldestSector)->baseSeq - JOURNAL_RECORDS_PER_SECTOR) {
+            break;
+        }
+        oldestSector = prev;
+    }
+
+    // Appends go after the last programmed slot, torn ones included.
+    headSlot = 0;
+    for (uint16_t slot = JOURNAL_RECORDS_PER_SECTOR; slot > 0; slot--) {
+        if (!slotErased(slotRecord(headSector, slot - 1))) {
+            headSlot = slot;
+            break;
+        }
+    }
+
+    for (uint8_t sector = oldestSector; ; sector = (uint8_t)((sector + 1) % sectorCount)) {
+        indexSector(sector, sector == headSector ? headSlot : JOURNAL_RECORDS_PER_SECTOR);
+        if (sector == headSector) {
+            break;
+        }
+    }
+    return true;
+}
+
+const JournalSectorHeader* EventJournal::sectorHeader(uint8_t sector) const {
+    return (const JournalSectorHeader*)(mapped + sector * JOURNAL_SECTOR_SIZE);
+}
+
+// Slot 0 is the first record, right after the header.
+const JournalRecord* EventJournal::slotRecord(uint8_t sector, uint16_t slot) const {
+    return (const JournalRecord*)(mapped + sector * JOURNAL_SECTOR_SIZE + (slot + 1) * sizeof(JournalRecord));
+}
+
+bool EventJournal::sectorValid(uint8_t sector) const {
+    const JournalSectorHeader* header = sectorHeader(sector);
+    return header->magic == JOURNAL_MAGIC && header->layout == JOURNAL_LAYOUT &&
+           esp_rom_crc32_le(0, (const uint8_t*)header, offsetof(JournalSectorHeader, crc)) == header->crc;
+}
+
+// Erases a sector and makes it the head, its first record being baseSeq.
+bool EventJournal::startSector(uint8_t sector, uint32_t baseSeq) {
+    JournalSectorHeader header;
+    header.magic = JOURNAL_MAGIC;
+    header.layout = JOURNAL_LAYOUT;
+    header.reserved = 0;
+    header.baseSeq = baseSeq;
+    header.crc = esp_rom_crc32_le(0, (const uint8_t*)&header, offsetof(JournalSectorHeader, crc));
+
+    size_t base = sector * JOURNAL_SECTOR_SIZE;
+    bool ok = esp_partition_erase_range(partition, base, JOURNAL_SECTOR_SIZE) == ESP_OK &&
+              esp_partition_write(partition, base, &header, sizeof(header)) == ESP_OK;
+    headSector = sector;
+    headBase = baseSeq;
+    headSlot = 0;
+    minTime[sector] = 0xFFFFFFFF;
+    maxTime[sector] = 0;
+    return ok;
+}
+
+// Recomputes the time range of a sector from its first slots.
+void EventJournal::indexSector(uint8_t sector, uint16_t slots) {
+    minTime[sector] = 0xFFFFFFFF;
+    maxTime[sector] = 0;
+    uint32_t base = sectorHeader(sector)->baseSeq;
+    for (uint16_t slot = 0; slot < slots; slot++) {
+        const JournalRecord* record = slotRecord(sector, slot);
+        if (record->seq != base + slot || record->check != recordCheck(*record)) {
+            continue;
+        }
+        if (record->time < minTime[sector]) minTime[sector] = record->time;
+        if (record->time > maxTime[sector]) maxTime[sector] = record->time;
+    }
+}
+
+// Appends one record; erases the oldest sector when the head is full.
+bool EventJournal::append(JournalEvent event, uint8_t node, uint8_t detail, uint32_t time, uint32_t uptime) {
+    if (mapped == nullptr) {
+        return false;
+    }
+    if (headSlot == JOURNAL_RECORDS_PER_SECTOR) {
+        uint8_t next = (uint8_t)((headSector + 1) % sectorCount);
+        if (next == oldestSector) {
+            oldestSector = (uint8_t)((oldestSector + 1) % sectorCount);
+        }
+        if (!startSector(next, headBase + JOURNAL_RECORDS_PER_SECTOR)) {
+            return false;
+        }
+    }
+
+    JournalRecord record;
+    record.seq = headBase + headSlot;
+    record.time = time;
+    record.uptime = uptime;
+    record.event = event;
+    record.node = node;
+    record.detail = detail;
+    record.check = recordCheck(record);
+
+    size_t offset = headSector * JOURNAL_SECTOR_SIZE + (headSlot + 1) * sizeof(JournalRecord);
+    bool ok = esp_partition_write(partition, offset, &record, sizeof(record)) == ESP_OK;
+    headSlot++;   // a failed write still spends its slot
+    if (time < minTime[headSector]) minTime[headSector] = time;
+    if (time > maxTime[headSector]) maxTime[headSector] = time;
+    return ok;
+}
+
+// Base of the oldest sector: the ring's bases step by one sector's worth of records.
+uint32_t EventJournal::oldest() const {
+    if (sectorCount == 0) {
+        return headBase;
+    }
+    uint8_t behind = (uint8_t)((headSector + sectorCount - oldestSector) % sectorCount);
+    return headBase - behind * JOURNAL_RECORDS_PER_SECTOR;
+}
+
+uint8_t EventJournal::sectorOf(uint32_t seq) const {
+    return (uint8_t)((oldestSector + (seq - oldest()) / JOURNAL_RECORDS_PER_SECTOR) % sectorCount);
+}
+
+// Copies one record out of flash.
+bool EventJournal::read(uint32_t seq, JournalRecord* out) const {
+    uint32_t first = oldest();
+    if (mapped == nullptr || seq - first >= end() - first) {
+        return false;
+    }
+    memcpy(out, slotRecord(sectorOf(seq), (uint16_t)((seq - first) % JOURNAL_RECORDS_PER_SECTOR)), sizeof(*out));
+    return out->seq == seq && out->check == recordCheck(*out);
+}
+
+// Skips whole sectors whose time range misses [since, until].
+uint32_t EventJournal::seekTime(uint32_t seq, uint32_t since, uint32_t until) const {
+    uint32_t first = oldest();
+    if ((int32_t)(seq - first) < 0) {
+        seq = first;
+    }
+    while (mapped != nullptr && seq - first < end() - first) {
+        uint8_t sector = sectorOf(seq);
+        if (minTime[sector] <= until && maxTime[sector] >= since) {
+            return seq;
+        }
+        seq = first + ((seq - first) / JOURNAL_RECORDS_PER_SECTOR + 1) * JOURNAL_RECORDS_PER_SECTOR;
+    }
+    return end();
+}
@@ -0,0 +1,144 @@
+/*
+ Project Name ------  FRS
+ Task --------------  Escalator Node Firmware with Esp32
+ Engineer ----------- Muhammad Usman
+ File --------------- Event Journal Header File
+ Company -----------  Machadev Pvt Limited
+ */
+
+// journal.h
+#ifndef JOURNAL_H
+#define JOURNAL_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include <esp_partition.h>
+
+/*
+ The "journal" partition (see partitions.csv) is a ring of 4 KB sectors.
+ Each sector is one JournalSectorHeader followed by
+ JOURNAL_RECORDS_PER_SECTOR JournalRecords, all 16 bytes:
+
+   sector n:  header(baseSeq)  record baseSeq  record baseSeq+1  ...
+
+ Records are only ever appended. Record seq lives in slot seq - baseSeq
+ of its sector, and the sectors of the ring hold consecutive bases, so
+ finding a record by sequence number is arithmetic, not a search. When
+ the head sector is full the oldest sector is erased and reused.
+
+ A record is written with a single flash write and carries a check byte.
+ A write torn by a power cut leaves a slot that fails the check; the
+ sequence number is spent and the next record goes into the next slot.
+
+ time is network time (time_sync.h), so records from different nodes
+ can be lined up. uptime is the node's own millis(). The meaning of node
+ and detail depends on the event:
+
+   JOURNAL_BOOT          this node        0
+   JOURNAL_ACTIVATED     sender           relay groups switched, 0 for the whole node
+   JOURNAL_DEACTIVATED   sender           relay groups switched, 0 for the whole node
+   JOURNAL_NODE_DEAD     the node         0
+   JOURNAL_NODE_BACK     the node         0
+   JOURNAL_SEND_FAILED   message type     RHRouter status
+*/
+
+constexpr uint32_t JOURNAL_MAGIC = 0x4A535246;  // "FRSJ"
+constexpr uint16_t JOURNAL_LAYOUT = 1;
+constexpr size_t JOURNAL_SECTOR_SIZE = 4096;
+constexpr uint8_t JOURNAL_MAX_SECTORS = 16;     // size of the per-sector index
+
+enum JournalEvent : uint8_t {
+    JOURNAL_BOOT = 1,
+    JOURNAL_ACTIVATED,
+    JOURNAL_DEACTIVATED,
+    JOURNAL_NODE_DEAD,
+    JOURNAL_NODE_BACK,
+    JOURNAL_SEND_FAILED,
+};
+
+struct __attribute__((packed)) JournalSectorHeader {
+    uint32_t magic;
+    uint16_t layout;
+    uint16_t reserved;
+    uint32_t baseSeq;      // sequence number of the sector's first record
+    uint32_t crc;          // CRC32 of the fields above
+};
+
+struct __attribute__((packed)) JournalRecord {
+    uint32_t seq;
+    uint32_t time;         // network time, ms
+    uint32_t uptime;       // local millis()
+    uint8_t event;
+    uint8_t node;
+    uint8_t detail;
+    uint8_t check;         // low byte of the CRC32 of the bytes above
+};
+
+static_assert(sizeof(JournalSectorHeader) == sizeof(JournalRecord), "the header takes one record slot");
+
+constexpr uint16_t JOURNAL_RECORDS_PER_SECTOR = JOURNAL_SECTOR_SIZE / sizeof(JournalRecord) - 1;
+
+/**
+ * @brief Returns the lower-case name of an event, "unknown" for other values.
+ */
+const char* journalEventName(uint8_t event);
+
+class EventJournal {
+public:
+    EventJournal();
+
+    /**
+     * @brief Finds and maps the "journal" partition and finds the head.
+     *
+     * An empty or foreign partition is formatted on the way.
+     *
+     * @return false if the partition is missing, too small or cannot be mapped.
+     */
+    bool begin();
+
+    /**
+     * @brief Appends one record; erases the oldest sector when the head is full.
+     *
+     * @return false if the journal is not mapped or the flash write failed.
+     */
+    bool append(JournalEvent event, uint8_t node, uint8_t detail, uint32_t time, uint32_t uptime);
+
+    // Sequence numbers of the stored records are oldest() up to, not including, end().
+    uint32_t oldest() const;
+    uint32_t end() const { return headBase + headSlot; }
+
+    /**
+     * @brief Copies one record out of flash.
+     *
+     * @return false if seq is outside the journal or its slot failed the check.
+     */
+    bool read(uint32_t seq, JournalRecord* out) const;
+
+    /**
+     * @brief Skips from seq past the sectors that hold no record timed within [since, until].
+     *
+     * @return The first sequence number worth reading, end() if none.
+     */
+    uint32_t seekTime(uint32_t seq, uint32_t since, uint32_t until) const;
+
+private:
+    const JournalSectorHeader* sectorHeader(uint8_t sector) const;
+    const JournalRecord* slotRecord(uint8_t sector, uint16_t slot) const;
+    bool sectorValid(uint8_t sector) const;
+    bool startSector(uint8_t sector, uint32_t baseSeq);
+    uint8_t sectorOf(uint32_t seq) const;
+    void indexSector(uint8_t sector, uint16_t slots);
+
+    const esp_partition_t* partition;
+    spi_flash_mmap_handle_t mapHandle;
+    const uint8_t* mapped;
+    uint8_t sectorCount;
+    uint8_t oldestSector;
+    uint8_t headSector;
+    uint32_t headBase;
+    uint16_t headSlot;                       // next free slot of the head sector
+    uint32_t minTime[JOURNAL_MAX_SECTORS];   // time range of each sector's records
+    uint32_t maxTime[JOURNAL_MAX_SECTORS];
+};
+
+#endif // JOURNAL_H
@@ -27,12 +27,9 @@ Tests:
 
 PlatformIO Configuration:
 
-[env:esp32dev]
-platform = espressif32
-board = esp32doit-devkit-v1
-framework = arduino
-monitor_speed = 115200
-lib_deps = mikem/RadioHead@^1.120
+- platformio.ini has one env per role and node, e.g. pio run -e escalator_node7.
+- Role, node ID and table sizes are build flags; see constants.h.
+- Wake-on-radio for nodes on backup power is a build flag too; see power.h.
 
 Escalator Node:
 
@@ -40,6 +37,7 @@ Escalator Node:
 - The relay is active low, with an LED connected in series with the relay.
 - ssid: FRS-Escalator
 - password: FRS12345678
+- The access point step of the portal wizard replaces both; they apply on the next start.
 - This node is activated by FyreBox node (it should send its state back, weather active or not)
 
 FyreBox Node:
@@ -59,6 +57,8 @@ TODO:
 // Import Libraries
 #include "functions.h"
 #include "constants.h"
+#include "profiler.h"
+#include "power.h"
 #include <freertos/FreeRTOS.h>
 #include <freertos/task.h>
 
@@ -77,8 +77,15 @@ void setup() {
   Serial.begin(Baud_RATE_SERIAL);
   Serial.println("Serial is ready.");
 
-  Serial2.begin(Baud_RATE_LORA);
-  Serial.println("Serial2 is ready.");
+  if (initializeLoRaLink()) {
+    Serial.println("LoRa UART is ready.");
+  } else {
+    Serial.println("LoRa UART driver could not be installed");
+  }
+
+  initializeSiteStore();
+  initializeJournal();
+  initializeRelays();
 
   Serial.println("Initializing mesh...");
   while(! initializeMESH()){  // stays in a loop until LoRa found 
@@ -88,7 +95,13 @@ void setup() {
    }
   Serial.println("Mesh initialized successfully.");
 
+  if (!initializeLowPower()) {
+    Serial.println("E32 did not take the wake-up period");
+  }
+
   xTaskCreatePinnedToCore(LoRatask, "LoRatask", 4096, NULL, 1, &xHandleLoRa, 1);
+  profilerRegisterTask(PROF_LORA_TASK, xHandleLoRa);
+  profilerRegisterTask(PROF_LOOP_TASK, xTaskGetCurrentTaskHandle()); // setup() runs in the loop task
 
   // xTaskCreate(dateTimeTask, "DateTimeTask", 2048, NULL, 4, &xHandledatetime);
   // vTaskSuspend(xHandledatetime);
@@ -105,8 +118,13 @@ void setup() {
   // Connect to Wi-Fi network with SSID and password
   WiFi.begin(ssid, password);
 
-  // Start the Access Point
-  WiFi.softAP("FRS-Escalator", "FRS12345678");
+  // Start the Access Point with the credentials stored by the wizard
+  char apSsid[CONFIG_VALUE_MAX];
+  char apPassword[CONFIG_VALUE_MAX];
+  accessPointCredentials(apSsid, apPassword);
+  WiFi.softAP(apSsid, apPassword);
+  Serial.print("AP SSID: ");
+  Serial.println(apSsid);
 
   // Print ESP32 Local IP Address
   Serial.print("AP IP address: ");
@@ -114,31 +132,22 @@ void setup() {
 
   // Define routes
   server.on("/", HTTP_GET, handleRoot);
-//  server.on("/connect", HTTP_GET, handleConnectGet);
-
-  server.on("/settings_option", HTTP_POST, handleSettingsOptionPost);
-  
-  server.on("/connect", HTTP_POST, handleConnectPost);
-
-  server.on("/client_login", HTTP_POST, handleClientLoginPost);
-  server.on("/admin_login", HTTP_POST, handleAdminLoginPost);
-
-  server.on("/connect_wifi", HTTP_POST, handleWifiConnectPost);
-
-  server.on("/connect_with_unique_key", HTTP_POST, handleUniqueKeyPost);
+  server.on("/profile", HTTP_GET, handleProfileGet);
 
-  server.on("/fill_data_auto_or_not", HTTP_POST, handleFillDataAutoOrNotPost);
+  // The wizard in data/portal.html: one request per section
+  server.on("/wizard/access", HTTP_POST, handleWizardAccessPost);
+  server.on("/wizard/site", HTTP_POST, handleWizardSitePost);
 
-  server.on("/send_company_details", HTTP_POST, handleGetCompanyDetailsPost);
+  server.on("/company_details", HTTP_GET, handleCompanyDetailsGet);
+  server.on("/unit_details", HTTP_GET, handleUnitDetailsGet);
+  server.on("/manufacturer_details", HTTP_GET, handleManufacturerDetailsGet);
+  server.on("/frames", HTTP_GET, handleFramesGet);
+  server.on("/journal", HTTP_GET, handleJournalGet);
+  server.on("/trace", HTTP_GET, handleTraceGet);
+  server.on("/trace", HTTP_POST, handleTracePost);
 
-  server.on("/send_unit_details", HTTP_POST, handleGetUnitDetailsPost);
-
-  server.on("/send_manufacturer_details", HTTP_POST, handleGetManufacturerDetailsPost);
-
-  server.on("/wifi_access_point", HTTP_POST, handleGetWifiAccessPointPost);
-
-  // Serve all files from SPIFFS
-  server.serveStatic("/", SPIFFS, "/");
+  // Serve all files from SPIFFS; the portal and its logo are cached by the browser for a day
+  server.serveStatic("/", SPIFFS, "/", "max-age=86400");
 
   // Start server
   server.begin();
@@ -146,23 +155,33 @@ void setup() {
 }
 
 void loop() {
+#if FRS_LOW_POWER
+    // On backup power the portal is up for a while after boot; then Wi-Fi goes off and LoRatask sleeps
+    static bool portalOpen = true;
+    if (portalOpen && millis() > WAKE_PORTAL_MS) {
+        server.stop();
+        WiFi.mode(WIFI_OFF);
+        portalOpen = false;
+        Serial.println("Portal closed, sleeping between radio windows");
+        startLowPowerSleep();
+    }
+    if (!portalOpen) {
+        vTaskDelay(pdMS_TO_TICKS(10000));  // LoRatask does the mesh work alone
+        return;
+    }
+#endif
+    profilerIteration(PROF_LOOP_TASK);
 
     // Handle client requests
     server.handleClient();
 
-    static unsigned long lastBroadcastTime = 0;
     static unsigned long lastCheckTime = 0;
     static unsigned long lastStatusPrintTime = 0;
     unsigned long currentMillis = millis();
 
-    if (currentMillis - lastBroadcastTime > 30000) {  // Every 30 seconds
-        broadcastPresence();
-        lastBroadcastTime = currentMillis;
-    }
-
-    listenForNodes();
-
+    // The radio belongs to LoRatask; loop() only serves the portal and the periodic checks
     if (currentMillis - lastCheckTime > 10000) {  // Every 10 seconds
+        profilerLateness(PROF_LOOP_TASK, lastCheckTime + 10000);
         checkNodeActivity();
         lastCheckTime = currentMillis;
     }
@@ -0,0 +1,116 @@
+/*
+ Project Name ------  FRS
+ Task --------------  Escalator Node Firmware with Esp32
+ Engineer ----------- Muhammad Usman
+ File --------------- Low Power Source File
+ Company -----------  Machadev Pvt Limited
+ */
+
+// Import Libraries
+#include "power.h"
+#include "uart_link.h"
+#include <Arduino.h>
+#include <esp_sleep.h>
+#include <driver/gpio.h>
+#include <string.h>
+
+// E32 command bytes, only accepted in sleep mode
+static constexpr uint8_t E32_CMD_READ_PARAMS = 0xC1;    // sent three times, answered with the six parameter bytes
+static constexpr uint8_t E32_CMD_WRITE_VOLATILE = 0xC2; // followed by five parameter bytes, lost on power-down
+static constexpr uint8_t E32_PARAM_LEN = 6;
+static constexpr uint8_t E32_OPTION_INDEX = 5;
+static constexpr uint8_t E32_OPTION_WAKE_SHIFT = 3;
+static constexpr uint8_t E32_OPTION_WAKE_MASK = 0x07 << E32_OPTION_WAKE_SHIFT;
+static constexpr uint32_t E32_REPLY_TIMEOUT_MS = 100;
+
+LowPower::LowPower(UartLink& link, int m0Pin, int m1Pin, int auxPin)
+    : link(link), m0Pin(m0Pin), m1Pin(m1Pin), auxPin(auxPin), periodMs(0), sleepAllowed(false), holdUntil(0) {
+    memset(&counters, 0, sizeof(counters));
+}
+
+// RH_E32 only sets the mode in init() and its parameter setters, which run before this.
+bool LowPower::begin(uint16_t period) {
+    periodMs = period;
+    sleepAllowed = false;
+    if (periodMs == 0) {
+        return true;
+    }
+    pinMode(auxPin, INPUT);
+    bool ok = writeWakePeriod(periodMs);
+    setMode(E32_WAKE_UP);
+    return ok;
+}
+
+// Sets OPTION bits 5..3, keeping the address, rates and channel RH_E32 wrote.
+bool LowPower::writeWakePeriod(uint16_t period) {
+    setMode(E32_SLEEP);
+    link.discardInput();
+    const uint8_t read[3] = { E32_CMD_READ_PARAMS, E32_CMD_READ_PARAMS, E32_CMD_READ_PARAMS };
+    link.write(read, sizeof(read));
+
+    uint8_t params[E32_PARAM_LEN];
+    if (link.readTimeout(params, sizeof(params), E32_REPLY_TIMEOUT_MS) != sizeof(params)) {
+        return false;
+    }
+    params[0] = E32_CMD_WRITE_VOLATILE;
+    params[E32_OPTION_INDEX] &= (uint8_t)~E32_OPTION_WAKE_MASK;
+    params[E32_OPTION_INDEX] |= (uint8_t)((period / WAKE_STEP_MS - 1) << E32_OPTION_WAKE_SHIFT);
+    link.write(params, sizeof(params));
+
+    uint8_t echo[E32_PARAM_LEN];
+    size_t got = link.readTimeout(echo, sizeof(echo), E32_REPLY_TIMEOUT_MS);
+    return got == sizeof(echo) && memcmp(echo + 1, params + 1, E32_PARAM_LEN - 1) == 0;
+}
+
+void LowPower::setMode(E32Mode mode) {
+    link.flush();   // a mode change aborts bytes still going out
+    digitalWrite(m0Pin, (mode & 1) ? HIGH : LOW);
+    digitalWrite(m1Pin, (mode & 2) ? HIGH : LOW);
+    if (!waitAux()) {
+        counters.modeTimeouts++;
+    }
+    delay(E32_MODE_SETTLE_MS);
+}
+
+// The E32 holds AUX low while it is busy: switching modes or handing a frame over the UART.
+bool LowPower::waitAux() {
+    unsigned long start = millis();
+    while (digitalRead(auxPin) == LOW) {
+        if (millis() - start > E32_AUX_TIMEOUT_MS) {
+            return false;
+        }
+        delay(1);
+    }
+    return true;
+}
+
+// Light sleep keeps RAM and the task states; the UART ring survives it.
+bool LowPower::sleep(uint32_t ms) {
+    if (!sleepAllowed) {
+        return false;
+    }
+    if (digitalRead(auxPin) == LOW) {
+        return true;    // a frame is on its way already
+    }
+    setMode(E32_POWER_SAVING);
+    Serial.flush();
+
+    esp_sleep_enable_timer_wakeup((uint64_t)ms * 1000);
+    gpio_wakeup_enable((gpio_num_t)auxPin, GPIO_INTR_LOW_LEVEL);
+    esp_sleep_enable_gpio_wakeup();
+    unsigned long start = millis();
+    esp_light_sleep_start();
+    bool byRadio = esp_sleep_get_wakeup_cause() == ESP_SLEEP_WAKEUP_GPIO;
+    gpio_wakeup_disable((gpio_num_t)auxPin);
+
+    counters.sleeps++;
+    counters.sleptMs += millis() - start;
+    if (byRadio) {
+        counters.radioWakes++;
+        waitAux();   // the frame is in the UART ring once AUX rises
+    } else {
+        counters.timerWakes++;
+    }
+    setMode(E32_WAKE_UP);   // power saving mode cannot send, not even the ACK
+    return byRadio;
+}
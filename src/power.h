@@ -0,0 +1,145 @@
+/*
+ Project Name ------  FRS
+ Task --------------  Escalator Node Firmware with Esp32
+ Engineer ----------- Muhammad Usman
+ File --------------- Low Power Header File
+ Company -----------  Machadev Pvt Limited
+ */
+
+// power.h
+#ifndef POWER_H
+#define POWER_H
+
+#include <stdint.h>
+
+/*
+ Wake-on-radio mode for nodes on backup power.
+
+ The E32 has four modes, selected by M0 (bit 0) and M1 (bit 1):
+
+   normal       continuous receive, plain preamble
+   wake-up      like normal, but every frame starts with a preamble as
+                long as the wake-up period
+   power saving the receiver sniffs the channel once per wake-up period
+                and sleeps in between; it cannot transmit
+   sleep        configuration only
+
+ FRS_WAKE_LATENCY_MS is the longest time a site may take to switch a
+ node's relays after the controller sends "Active". When it is set, every
+ node transmits in wake-up mode with the longest wake-up period (250 ms
+ steps up to 2000 ms, OPTION bits 5..3) that still fits the budget
+ together with one frame and the wake-up of the ESP32. It must be the
+ same on every node of the site.
+
+ A node built with FRS_LOW_POWER then also sleeps: its E32 sits in power
+ saving mode and the ESP32 in light sleep until its next beacon slot,
+ the next activity check, or until the E32 pulls AUX low, 2-3 ms before
+ it hands a received frame over the UART. UART2 cannot wake the ESP32
+ from light sleep, so these nodes need AUX wired to AUXPIN. Wi-Fi cannot
+ run during light sleep; the portal closes WAKE_PORTAL_MS after boot.
+
+ Without FRS_WAKE_LATENCY_MS the E32 stays in normal mode as before.
+*/
+
+#ifndef FRS_WAKE_LATENCY_MS
+#define FRS_WAKE_LATENCY_MS 0
+#endif
+
+#ifndef FRS_LOW_POWER
+#define FRS_LOW_POWER 0
+#endif
+
+enum E32Mode : uint8_t {
+    E32_NORMAL = 0,
+    E32_WAKE_UP = 1,
+    E32_POWER_SAVING = 2,
+    E32_SLEEP = 3,
+};
+
+constexpr uint16_t WAKE_STEP_MS = 250;        // E32 wake-up periods are 250 .. 2000 ms
+constexpr uint16_t WAKE_MAX_MS = 2000;
+constexpr uint16_t WAKE_FRAME_MS = 400;       // longest mesh frame at 2.4 kbps, UART at both ends
+constexpr uint16_t WAKE_RESUME_MS = 20;       // light sleep exit, AUX and the mode switch
+constexpr uint16_t WAKE_HOLD_MS = 500;        // stay awake this long after a received frame
+constexpr uint16_t E32_MODE_SETTLE_MS = 2;    // after AUX rises on a mode change
+constexpr uint16_t E32_AUX_TIMEOUT_MS = 100;
+constexpr uint32_t WAKE_PORTAL_MS = 600000;   // Wi-Fi stays up this long after boot on a low power node
+
+// Longest wake-up period that keeps one hop within latencyMs; 0 if none does.
+constexpr uint16_t wakePeriodFor(uint16_t latencyMs) {
+    return latencyMs < WAKE_STEP_MS + WAKE_FRAME_MS + WAKE_RESUME_MS ? 0
+         : latencyMs - WAKE_FRAME_MS - WAKE_RESUME_MS >= WAKE_MAX_MS ? WAKE_MAX_MS
+         : (latencyMs - WAKE_FRAME_MS - WAKE_RESUME_MS) / WAKE_STEP_MS * WAKE_STEP_MS;
+}
+
+constexpr uint16_t WAKE_LATENCY_MS = FRS_WAKE_LATENCY_MS;
+constexpr uint16_t WAKE_PERIOD_MS = wakePeriodFor(WAKE_LATENCY_MS);
+
+static_assert(WAKE_LATENCY_MS == 0 || WAKE_PERIOD_MS > 0,
+              "FRS_WAKE_LATENCY_MS is too short for the shortest E32 wake-up period");
+static_assert(!FRS_LOW_POWER || WAKE_PERIOD_MS > 0, "FRS_LOW_POWER needs FRS_WAKE_LATENCY_MS");
+
+struct PowerStats {
+    uint32_t sleeps;
+    uint32_t radioWakes;     // AUX went low: a frame is on its way
+    uint32_t timerWakes;     // beacon slot or activity check
+    uint32_t sleptMs;
+    uint32_t modeTimeouts;   // AUX stayed low after a mode change
+};
+
+class UartLink;
+
+class LowPower {
+public:
+    LowPower(UartLink& link, int m0Pin, int m1Pin, int auxPin);
+
+    /**
+     * @brief Writes the wake-up period to the E32 and leaves it in wake-up mode.
+     *
+     * Call after the radio driver's init(), which resets the parameters.
+     *
+     * @param periodMs One of the E32 wake-up periods, or 0 to stay in normal mode.
+     * @return false if the E32 did not answer the parameter read.
+     */
+    bool begin(uint16_t periodMs);
+
+    // Lets the node sleep from now on; the caller has switched Wi-Fi off.
+    void enableSleep() { sleepAllowed = periodMs > 0; }
+
+    bool sleepEnabled() const { return sleepAllowed; }
+    uint16_t period() const { return periodMs; }
+
+    // A frame came in; keeps the node awake for WAKE_HOLD_MS for the replies that follow.
+    void onActivity(uint32_t now) { holdUntil = now + WAKE_HOLD_MS; }
+
+    // True while the hold after the last frame still runs.
+    bool holding(uint32_t now) const { return (int32_t)(holdUntil - now) > 0; }
+
+    /**
+     * @brief Puts the E32 into power saving mode and the ESP32 into light sleep.
+     *
+     * Returns in wake-up mode when ms have passed or the E32 wakes the node;
+     * a frame that woke it is waiting in the UART ring.
+     *
+     * @return true if the E32 woke the node, or was already handing a frame over.
+     */
+    bool sleep(uint32_t ms);
+
+    const PowerStats& stats() const { return counters; }
+
+private:
+    void setMode(E32Mode mode);
+    bool waitAux();
+    bool writeWakePeriod(uint16_t periodMs);
+
+    UartLink& link;
+    int m0Pin;
+    int m1Pin;
+    int auxPin;
+    uint16_t periodMs;
+    bool sleepAllowed;
+    uint32_t holdUntil;
+    PowerStats counters;
+};
+
+#endif // POWER_H
@@ -0,0 +1,242 @@
+/*
+ Project Name ------  FRS
+ Task --------------  Escalator Node Firmware with Esp32
+ Engineer ----------- Muhammad Usman
+ File --------------- Task Profiler Source File
+ Company -----------  Machadev Pvt Limited
+ */
+
+// Import Libraries
+#include "profiler.h"
+#include <freertos/FreeRTOS.h>
+#include <freertos/task.h>
+#include <freertos/semphr.h>
+#include <atomic>
+
+constexpr UBaseType_t PROF_MAX_TASKS = 24;
+
+struct LoopStats {
+    TaskHandle_t handle;
+    uint32_t iterations;
+    uint32_t lastIterationUs;
+    uint32_t iterationMaxUs;
+    uint64_t iterationTotalUs;
+    uint32_t lateSamples;
+    uint32_t lateMaxMs;
+    uint64_t lateTotalMs;
+    std::atomic<uint32_t> wokeAt;   // micros() | 1 when work became ready, 0 if none is waiting
+    uint32_t wakeSamples;
+    uint32_t wakeMaxUs;
+    uint64_t wakeTotalUs;
+};
+
+// One row of the task table, whichever way it was collected
+struct TaskRow {
+    const char* name;
+    TaskHandle_t handle;
+    UBaseType_t priority;
+    int core;              // -1 if not pinned or unknown
+    uint32_t stackFree;    // bytes never used since the task started
+    float cpuPercent;      // of one core since the previous sample, negative if unavailable
+};
+
+static LoopStats loopStats[PROF_TASK_COUNT];
+static const char* const kLoopNames[PROF_TASK_COUNT] = { "LoRatask", "loopTask" };
+
+#if (configGENERATE_RUN_TIME_STATS == 1)
+// Run-time counters at the previous sample, to turn totals since boot into shares.
+// /profile and the serial report sample from different tasks, so both hold sampleMutex.
+struct RunTimeMark {
+    TaskHandle_t handle;
+    uint32_t runTime;
+};
+
+static SemaphoreHandle_t sampleMutex;
+static RunTimeMark lastRunTime[PROF_MAX_TASKS];
+static UBaseType_t lastRunTimeCount;
+static uint32_t lastTotalRunTime;
+#endif
+
+// Associates an instrumented task with its FreeRTOS handle.
+void profilerRegisterTask(ProfiledTask task, TaskHandle_t handle) {
+#if (configGENERATE_RUN_TIME_STATS == 1)
+    if (sampleMutex == nullptr) {
+        sampleMutex = xSemaphoreCreateMutex();   // setup() registers the tasks before either samples
+    }
+#endif
+    loopStats[task].handle = handle;
+}
+
+// Marks the start of one pass through a task's loop.
+void profilerIteration(ProfiledTask task) {
+    LoopStats& stats = loopStats[task];
+    uint32_t now = micros();
+    if (stats.iterations > 0) {
+        uint32_t elapsed = now - stats.lastIterationUs;
+        stats.iterationTotalUs += elapsed;
+        if (elapsed > stats.iterationMaxUs) stats.iterationMaxUs = elapsed;
+    }
+    stats.lastIterationUs = now;
+    stats.iterations++;
+}
+
+// Records how late a periodic job ran.
+void profilerLateness(ProfiledTask task, unsigned long dueMillis) {
+    LoopStats& stats = loopStats[task];
+    uint32_t late = millis() - dueMillis;
+    stats.lateSamples++;
+    stats.lateTotalMs += late;
+    if (late > stats.lateMaxMs) stats.lateMaxMs = late;
+}
+
+// Stamps the moment work became ready; a stamp already waiting is kept.
+void profilerWake(ProfiledTask task) {
+    uint32_t none = 0;
+    loopStats[task].wokeAt.compare_exchange_strong(none, (uint32_t)micros() | 1);
+}
+
+// Records how long the work waited for the task since profilerWake().
+void profilerRun(ProfiledTask task) {
+    LoopStats& stats = loopStats[task];
+    uint32_t wokeAt = stats.wokeAt.exchange(0);
+    if (wokeAt == 0) return;
+    uint32_t waited = (uint32_t)micros() - wokeAt;
+    stats.wakeSamples++;
+    stats.wakeTotalUs += waited;
+    if (waited > stats.wakeMaxUs) stats.wakeMaxUs = waited;
+}
+
+// Drops a stamp whose work the task did not pick up.
+void profilerClearWake(ProfiledTask task) {
+    loopStats[task].wokeAt.store(0);
+}
+
+#if (configGENERATE_RUN_TIME_STATS == 1)
+// Returns a task's run-time counter at the previous sample; 0 for a task created since.
+static uint32_t previousRunTime(TaskHandle_t handle) {
+    for (UBaseType_t i = 0; i < lastRunTimeCount; i++) {
+        if (lastRunTime[i].handle == handle) return lastRunTime[i].runTime;
+    }
+    return 0;
+}
+#endif
+
+// Collects one row per task. With the trace facility every task in the
+// system is listed; otherwise only the instrumented ones.
+static UBaseType_t collectTasks(TaskRow* rows, UBaseType_t cap) {
+    UBaseType_t count = 0;
+#if (configUSE_TRACE_FACILITY == 1)
+    // uxTaskGetSystemState() fails unless there is room for every task, so size to the live count
+    UBaseType_t total = uxTaskGetNumberOfTasks() + 2;
+    TaskStatus_t* statuses = (TaskStatus_t*)malloc(total * sizeof(TaskStatus_t));
+    if (statuses != nullptr) {
+#if (configGENERATE_RUN_TIME_STATS == 1)
+        xSemaphoreTake(sampleMutex, portMAX_DELAY);
+#endif
+        uint32_t totalRunTime = 0;
+        count = uxTaskGetSystemState(statuses, total, &totalRunTime);
+        if (count > cap) count = cap;
+        for (UBaseType_t i = 0; i < count; i++) {
+            rows[i].name = statuses[i].pcTaskName;
+            rows[i].handle = statuses[i].xHandle;
+            rows[i].priority = statuses[i].uxCurrentPriority;
+#if (configTASKLIST_INCLUDE_COREID == 1)
+            rows[i].core = statuses[i].xCoreID == tskNO_AFFINITY ? -1 : (int)statuses[i].xCoreID;
+#else
+            rows[i].core = -1;
+#endif
+            rows[i].stackFree = statuses[i].usStackHighWaterMark;
+#if (configGENERATE_RUN_TIME_STATS == 1)
+            uint32_t elapsed = totalRunTime - lastTotalRunTime;   // counters wrap; the differences do not
+            uint32_t ran = statuses[i].ulRunTimeCounter - previousRunTime(statuses[i].xHandle);
+            rows[i].cpuPercent = elapsed > 0 ? ran * 100.0f / elapsed : 0.0f;
+#else
+            rows[i].cpuPercent = -1.0f;
+#endif
+        }
+#if (configGENERATE_RUN_TIME_STATS == 1)
+        for (UBaseType_t i = 0; i < count; i++) {
+            lastRunTime[i].handle = statuses[i].xHandle;
+            lastRunTime[i].runTime = statuses[i].ulRunTimeCounter;
+        }
+        lastRunTimeCount = count;
+        lastTotalRunTime = totalRunTime;
+        xSemaphoreGive(sampleMutex);
+#endif
+        free(statuses);
+        return count;
+    }
+#endif
+    for (uint8_t t = 0; t < PROF_TASK_COUNT && count < cap; t++) {
+        TaskHandle_t handle = loopStats[t].handle;
+        if (handle == nullptr) continue;
+        rows[count].name = pcTaskGetTaskName(handle);
+        rows[count].handle = handle;
+        rows[count].priority = uxTaskPriorityGet(handle);
+        rows[count].core = -1;
+        rows[count].stackFree = uxTaskGetStackHighWaterMark(handle);
+        rows[count].cpuPercent = -1.0f;
+        count++;
+    }
+    return count;
+}
+
+// Fills doc with a snapshot of all tasks.
+void profilerSnapshot(JsonDocument& doc) {
+    TaskRow rows[PROF_MAX_TASKS];
+    UBaseType_t count = collectTasks(rows, PROF_MAX_TASKS);
+
+    doc["uptime_ms"] = millis();
+    doc["heap_free"] = ESP.getFreeHeap();
+    doc["heap_min_free"] = ESP.getMinFreeHeap();
+
+    JsonArray tasks = doc.createNestedArray("tasks");
+    for (UBaseType_t i = 0; i < count; i++) {
+        JsonObject task = tasks.createNestedObject();
+        task["name"] = rows[i].name;
+        task["priority"] = rows[i].priority;
+        task["core"] = rows[i].core;
+        task["stack_free"] = rows[i].stackFree;
+        if (rows[i].cpuPercent >= 0) task["cpu_percent"] = rows[i].cpuPercent;
+    }
+
+    JsonArray loops = doc.createNestedArray("loops");
+    for (uint8_t t = 0; t < PROF_TASK_COUNT; t++) {
+        const LoopStats& stats = loopStats[t];
+        JsonObject loop = loops.createNestedObject();
+        loop["name"] = kLoopNames[t];
+        loop["iterations"] = stats.iterations;
+        loop["iteration_avg_us"] = stats.iterations > 1 ? (uint32_t)(stats.iterationTotalUs / (stats.iterations - 1)) : 0;
+        loop["iteration_max_us"] = stats.iterationMaxUs;
+        loop["late_avg_ms"] = stats.lateSamples > 0 ? (uint32_t)(stats.lateTotalMs / stats.lateSamples) : 0;
+        loop["late_max_ms"] = stats.lateMaxMs;
+        loop["wake_samples"] = stats.wakeSamples;
+        loop["wake_avg_us"] = stats.wakeSamples > 0 ? (uint32_t)(stats.wakeTotalUs / stats.wakeSamples) : 0;
+        loop["wake_max_us"] = stats.wakeMaxUs;
+    }
+}
+
+// Prints a compact one-line-per-task report.
+void profilerReport(Print& out) {
+    TaskRow rows[PROF_MAX_TASKS];
+    UBaseType_t count = collectTasks(rows, PROF_MAX_TASKS);
+
+    out.printf("Heap free %u min %u\n", ESP.getFreeHeap(), ESP.getMinFreeHeap());
+    for (UBaseType_t i = 0; i < count; i++) {
+        out.printf("%-16s p%u c%d stack %uB", rows[i].name, (unsigned)rows[i].priority,
+                   rows[i].core, (unsigned)rows[i].stackFree);
+        if (rows[i].cpuPercent >= 0) out.printf(" cpu %.1f%%", rows[i].cpuPercent);
+        out.println();
+    }
+    for (uint8_t t = 0; t < PROF_TASK_COUNT; t++) {
+        const LoopStats& stats = loopStats[t];
+        out.printf("%-16s iter avg %luus max %luus late avg %lums max %lums wake avg %luus max %luus\n",
+                   kLoopNames[t],
+                   stats.iterations > 1 ? (unsigned long)(stats.iterationTotalUs / (stats.iterations - 1)) : 0UL,
+                   (unsigned long)stats.iterationMaxUs,
+                   stats.lateSamples > 0 ? (unsigned long)(stats.lateTotalMs / stats.lateSamples) : 0UL,
+                   (unsigned long)stats.lateMaxMs,
+                   stats.wakeSamples > 0 ? (unsigned long)(stats.wakeTotalUs / stats.wakeSamples) : 0UL,
+                   (unsigned long)stats.wakeMaxUs);
+    }
+}
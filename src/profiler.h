@@ -0,0 +1,89 @@
+/*
+ Project Name ------  FRS
+ Task --------------  Escalator Node Firmware with Esp32
+ Engineer ----------- Muhammad Usman
+ File --------------- Task Profiler Header File
+ Company -----------  Machadev Pvt Limited
+ */
+
+// profiler.h
+#ifndef PROFILER_H
+#define PROFILER_H
+
+#include <Arduino.h>
+#include <ArduinoJson.h>
+
+/*
+ Samples, for every FreeRTOS task, the stack high-water mark and (when the
+ core is built with run-time stats) the CPU share since the previous sample,
+ i.e. the previous /profile request or serial report. The application tasks
+ below are also instrumented in their loops:
+
+   - iteration time: gap between two passes of the task's loop
+   - lateness: how long after it became due a periodic job ran. The tasks
+     only look at their timers between other work, so this is not a
+     scheduling delay: LoRatask checks them after each receive window, and
+     its figure is dominated by the 2 s recvfromAckTimeout() of that window.
+   - wakeup: from the moment work became ready for the task, stamped by the
+     task or interrupt that made it ready, to the task picking it up. For
+     LoRatask the UART event task stamps the end of each received frame and
+     listenForNodes() reads the stamp when it returns with the frame, so
+     the figure covers light sleep wakeups, polling and time spent behind
+     loop() on the shared core. Only the first stamp since the task last
+     ran is kept.
+
+ The CPU shares are differences from the previous sample, which /profile
+ (loop()) and the serial report (LoRatask) both take; a mutex keeps the
+ two from interleaving.
+*/
+
+enum ProfiledTask : uint8_t {
+    PROF_LORA_TASK,
+    PROF_LOOP_TASK,
+    PROF_TASK_COUNT
+};
+
+/**
+ * @brief Associates an instrumented task with its FreeRTOS handle.
+ */
+void profilerRegisterTask(ProfiledTask task, TaskHandle_t handle);
+
+/**
+ * @brief Marks the start of one pass through a task's loop.
+ */
+void profilerIteration(ProfiledTask task);
+
+/**
+ * @brief Records how late a periodic job ran.
+ *
+ * @param task The task that ran the job.
+ * @param dueMillis The millis() value at which the job became due.
+ */
+void profilerLateness(ProfiledTask task, unsigned long dueMillis);
+
+/**
+ * @brief Stamps the moment work became ready for a task; safe from any task.
+ */
+void profilerWake(ProfiledTask task);
+
+/**
+ * @brief Records the time since profilerWake(), when the task picks the work up.
+ */
+void profilerRun(ProfiledTask task);
+
+/**
+ * @brief Drops a stamp whose work the task did not pick up (e.g. a frame for another node).
+ */
+void profilerClearWake(ProfiledTask task);
+
+/**
+ * @brief Fills doc with a snapshot of all tasks (served on /profile).
+ */
+void profilerSnapshot(JsonDocument& doc);
+
+/**
+ * @brief Prints a compact one-line-per-task report.
+ */
+void profilerReport(Print& out);
+
+#endif // PROFILER_H
@@ -0,0 +1,63 @@
+/*
+ Project Name ------  FRS
+ Task --------------  Escalator Node Firmware with Esp32
+ Engineer ----------- Muhammad Usman
+ File --------------- Mesh Protocol Header File
+ Company -----------  Machadev Pvt Limited
+ */
+
+// protocol.h
+#ifndef PROTOCOL_H
+#define PROTOCOL_H
+
+#include <stdint.h>
+
+/**
+ * @brief Largest application payload that fits in one E32 mesh frame.
+ *
+ * RH_E32 carries at most 54 bytes per packet; RHRouter adds a 5 byte
+ * header and RHMesh a 1 byte header on top of that.
+ */
+constexpr uint8_t MESH_FRAME_MAX_LEN = 48;
+
+/**
+ * @brief First byte of every binary mesh frame.
+ *
+ * All values are below MSG_BINARY_LIMIT, so a binary frame can never be
+ * mistaken for one of the printable text messages ("Node Present", ...).
+ */
+enum MessageType : uint8_t {
+    MSG_XFER_DATA = 0x01,   // fragment of a large payload
+    MSG_XFER_ACK  = 0x02,   // selective-repeat acknowledgement bitmap
+    MSG_SYNC_DIGEST = 0x03, // hash of this node's config versions
+    MSG_SYNC_VECTOR = 0x04, // per-field config versions (sent as a payload)
+    MSG_SYNC_DELTA  = 0x05, // changed config fields (sent as a payload)
+    MSG_ACTIVE      = 0x06, // controller: switch the escalator relay on ("Active")
+    MSG_INACTIVE    = 0x07, // controller: switch it off ("Inactive")
+    MSG_PRESENCE    = 0x08, // periodic beacon ("Node Present")
+    MSG_ACTIVATED   = 0x09, // node: relay switched on ("Actived")
+    MSG_DEACTIVATED = 0x0A, // node: relay switched off ("Deactived")
+    MSG_GROUP_SWITCH = 0x0B, // controller: switch relay groups by site group mask
+    MSG_FW_ANNOUNCE = 0x0C, // controller: firmware image id, size and hash
+    MSG_FW_CHUNK    = 0x0D, // controller: one fountain-coded image symbol
+    MSG_FW_STATUS   = 0x0E, // node: generations still missing and their deficits
+    MSG_FW_QUERY    = 0x0F, // controller: ask unfinished nodes for their status
+};
+
+constexpr uint8_t MSG_BINARY_LIMIT = 0x20;
+
+/**
+ * @brief Node roles, as bits so one handler can serve several roles.
+ */
+enum NodeRole : uint8_t {
+    ROLE_ESCALATOR  = 0x01,
+    ROLE_CONTROLLER = 0x02,
+    ROLE_ANY        = 0xFF,
+};
+
+// Returns true if the frame starts with a binary message type.
+inline bool isBinaryFrame(const uint8_t* frame, uint8_t len) {
+    return len > 0 && frame[0] < MSG_BINARY_LIMIT;
+}
+
+#endif // PROTOCOL_H
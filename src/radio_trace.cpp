@@ -0,0 +1,75 @@
+/*
+ Project Name ------  FRS
+ Task --------------  Escalator Node Firmware with Esp32
+ Engineer ----------- Muhammad Usman
+ File --------------- Radio Trace Source File
+ Company -----------  Machadev Pvt Limited
+ */
+
+// Import Libraries
+#include "radio_trace.h"
+#include <string.h>
+
+RadioTrace::RadioTrace() : head(0), tail(0), droppedCount(0), enabled(true), paused(false) {}
+
+void RadioTrace::read(uint32_t pos, void* out, size_t len) const {
+    size_t index = pos % TRACE_RING_BYTES;
+    size_t first = len < TRACE_RING_BYTES - index ? len : TRACE_RING_BYTES - index;
+    memcpy(out, ring + index, first);
+    memcpy((uint8_t*)out + first, ring, len - first);
+}
+
+void RadioTrace::write(uint32_t pos, const void* data, size_t len) {
+    size_t index = pos % TRACE_RING_BYTES;
+    size_t first = len < TRACE_RING_BYTES - index ? len : TRACE_RING_BYTES - index;
+    memcpy(ring + index, data, first);
+    memcpy(ring, (const uint8_t*)data + first, len - first);
+}
+
+// Appends one frame, dropping the oldest records until it fits.
+void RadioTrace::record(TraceKind kind, uint32_t time, uint16_t duration, uint8_t peer, uint8_t status,
+                        const uint8_t* frame, uint8_t len) {
+    if (!enabled) {
+        return;
+    }
+    if (paused) {
+        droppedCount++;
+        return;
+    }
+    TraceRecord header = { time, duration, (uint8_t)kind, peer, status, len };
+    size_t size = sizeof(header) + len;
+    while (head - tail + size > TRACE_RING_BYTES) {
+        TraceRecord oldest;
+        read(tail, &oldest, sizeof(oldest));
+        tail += sizeof(oldest) + oldest.len;
+        droppedCount++;
+    }
+    write(head, &header, sizeof(header));
+    write(head + sizeof(header), frame, len);
+    head += size;
+}
+
+void RadioTrace::clear() {
+    tail = head;
+    droppedCount = 0;
+}
+
+// Copies as many whole records as fit, oldest first.
+size_t RadioTrace::copy(uint32_t* pos, uint8_t* out, size_t cap) const {
+    if ((int32_t)(*pos - tail) < 0) {
+        *pos = tail;
+    }
+    size_t copied = 0;
+    while (*pos != head) {
+        TraceRecord header;
+        read(*pos, &header, sizeof(header));
+        size_t size = sizeof(header) + header.len;
+        if (copied + size > cap) {
+            break;
+        }
+        read(*pos, out + copied, size);
+        copied += size;
+        *pos += size;
+    }
+    return copied;
+}
@@ -0,0 +1,114 @@
+/*
+ Project Name ------  FRS
+ Task --------------  Escalator Node Firmware with Esp32
+ Engineer ----------- Muhammad Usman
+ File --------------- Radio Trace Header File
+ Company -----------  Machadev Pvt Limited
+ */
+
+// radio_trace.h
+#ifndef RADIO_TRACE_H
+#define RADIO_TRACE_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+/*
+ Capture of every frame the node sends or receives, for reproducing
+ field incidents with tools/replay.
+
+ Records go into a RAM ring of TRACE_RING_BYTES; when it is full the
+ oldest records are dropped. A record is a TraceRecord followed by the
+ frame bytes. Records are addressed by their absolute byte position, so
+ a reader that fell behind the writer skips to the oldest record still
+ held instead of reading torn bytes. A dump pauses recording so that
+ cannot happen to it; frames missed while paused count as dropped and
+ show up in the next dump's header.
+
+ A dump (GET /trace) is one TraceFileHeader followed by the records,
+ oldest first, little endian:
+
+   header  magic "FRST"  version  node  role  0  dropped u32
+   record  time u32  duration u16  kind  peer  status  len  frame[len]
+
+ The ring size is a build parameter (FRS_TRACE_BYTES) so host tools can
+ keep a whole replay.
+*/
+
+#ifndef FRS_TRACE_BYTES
+#define FRS_TRACE_BYTES 8192
+#endif
+
+constexpr uint32_t TRACE_MAGIC = 0x54535246;   // "FRST"
+constexpr uint8_t TRACE_VERSION = 1;
+constexpr size_t TRACE_RING_BYTES = FRS_TRACE_BYTES;
+
+static_assert((TRACE_RING_BYTES & (TRACE_RING_BYTES - 1)) == 0, "positions wrap at 2^32, a multiple of the ring size");
+
+enum TraceKind : uint8_t {
+    TRACE_RX = 1,   // peer is the sender, status 0
+    TRACE_TX = 2,   // peer is the destination, status is the RHRouter result
+};
+
+struct __attribute__((packed)) TraceFileHeader {
+    uint32_t magic;
+    uint8_t version;
+    uint8_t node;
+    uint8_t role;
+    uint8_t reserved;
+    uint32_t dropped;   // records overwritten or missed during an earlier dump
+};
+
+struct __attribute__((packed)) TraceRecord {
+    uint32_t time;      // millis() when the frame arrived or the send started
+    uint16_t duration;  // ms the send took, 0 for a received frame
+    uint8_t kind;
+    uint8_t peer;
+    uint8_t status;
+    uint8_t len;
+};
+
+class RadioTrace {
+public:
+    RadioTrace();
+
+    void setEnabled(bool on) { enabled = on; }
+    bool isEnabled() const { return enabled; }
+
+    // While paused the ring does not change; frames that would have been recorded are counted as dropped.
+    void setPaused(bool on) { paused = on; }
+
+    // Appends one frame; a no-op while disabled.
+    void record(TraceKind kind, uint32_t time, uint16_t duration, uint8_t peer, uint8_t status,
+                const uint8_t* frame, uint8_t len);
+
+    void clear();
+
+    // Absolute position of the oldest record held and of the next one to be written.
+    uint32_t start() const { return tail; }
+    uint32_t end() const { return head; }
+    uint32_t dropped() const { return droppedCount; }
+
+    /**
+     * @brief Copies whole records starting at *pos into out and advances *pos.
+     *
+     * A position older than start() is moved up to start() first; the
+     * records in between were overwritten.
+     *
+     * @return Bytes copied, 0 once *pos reaches end().
+     */
+    size_t copy(uint32_t* pos, uint8_t* out, size_t cap) const;
+
+private:
+    void read(uint32_t pos, void* out, size_t len) const;
+    void write(uint32_t pos, const void* data, size_t len);
+
+    uint8_t ring[TRACE_RING_BYTES];
+    uint32_t head;      // absolute byte positions; the ring index is pos % TRACE_RING_BYTES
+    uint32_t tail;
+    uint32_t droppedCount;
+    bool enabled;
+    bool paused;
+};
+
+#endif // RADIO_TRACE_H
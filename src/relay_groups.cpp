@@ -0,0 +1,74 @@
+/*
+ Project Name ------  FRS
+ Task --------------  Escalator Node Firmware with Esp32
+ Engineer ----------- Muhammad Usman
+ File --------------- Relay Groups Source File
+ Company -----------  Machadev Pvt Limited
+ */
+
+// Import Libraries
+#include "relay_groups.h"
+#include <Arduino.h>
+#include <soc/soc.h>
+#include <soc/gpio_reg.h>
+
+RelayBank::RelayBank() : count(0), allPins(0), state(0) {}
+
+bool RelayBank::begin(const RelayGroup* table, uint8_t n) {
+    bool ok = true;
+    count = 0;
+    allPins = 0;
+    for (uint8_t i = 0; i < n; i++) {
+        const RelayGroup& group = table[i];
+        if (count == RELAY_GROUP_MAX || !relayGroupsValid(&group, 1)) {
+            ok = false;
+            continue;
+        }
+        groups[count++] = group;
+        allPins |= group.pins;
+    }
+    for (uint8_t pin = 0; pin < 32; pin++) {
+        if (allPins & (1u << pin)) {
+            pinMode(pin, OUTPUT);
+        }
+    }
+    write(allPins, false);
+    return ok;
+}
+
+// One register write per direction, so all pins change together.
+void RelayBank::write(uint32_t pins, bool on) {
+    if (pins == 0) {
+        return;
+    }
+    if (on) {
+        REG_WRITE(GPIO_OUT_W1TS_REG, pins);
+        state |= pins;
+    } else {
+        REG_WRITE(GPIO_OUT_W1TC_REG, pins);
+        state &= ~pins;
+    }
+}
+
+void RelayBank::setAll(bool on) {
+    write(allPins, on);
+}
+
+uint8_t RelayBank::applyFrame(const uint8_t* frame, uint8_t len) {
+    if (len <= GROUP_SWITCH_HEADER_LEN || len > GROUP_SWITCH_MAX_LEN) {
+        return 0;
+    }
+    const uint8_t* mask = frame + GROUP_SWITCH_HEADER_LEN;
+    uint8_t maskBits = (uint8_t)((len - GROUP_SWITCH_HEADER_LEN) * 8);
+    uint32_t pins = 0;
+    uint8_t selected = 0;
+    for (uint8_t i = 0; i < count; i++) {
+        uint8_t bit = groups[i].siteGroup;
+        if (bit < maskBits && (mask[bit / 8] & (1u << (bit % 8)))) {
+            pins |= groups[i].pins;
+            selected++;
+        }
+    }
+    write(pins, frame[1] != 0);
+    return selected;
+}
@@ -0,0 +1,90 @@
+/*
+ Project Name ------  FRS
+ Task --------------  Escalator Node Firmware with Esp32
+ Engineer ----------- Muhammad Usman
+ File --------------- Relay Groups Header File
+ Company -----------  Machadev Pvt Limited
+ */
+
+// relay_groups.h
+#ifndef RELAY_GROUPS_H
+#define RELAY_GROUPS_H
+
+#include <stdint.h>
+#include "protocol.h"
+
+/*
+ A node drives one or more relay groups. Each group is a set of GPIOs
+ switched together and carries a site-wide group number, so groups on
+ different nodes can share a number and move as one escalator bank.
+
+ Group switch frame, one packet for any number of groups and nodes:
+
+   [MSG_GROUP_SWITCH][state][mask LSB .. (1 to 8 bytes)]
+
+ Bit n of the mask selects site group n; state 1 switches the selected
+ groups on, 0 off. A node ORs the pins of every selected group into one
+ mask and writes it to GPIO_OUT_W1TS or GPIO_OUT_W1TC, so its relays
+ change in the same register write.
+*/
+
+constexpr uint8_t RELAY_GROUP_MAX = 8;     // groups per node
+constexpr uint8_t RELAY_SITE_GROUPS = 64;  // bits in the switch mask
+constexpr uint8_t GROUP_SWITCH_HEADER_LEN = 2;
+constexpr uint8_t GROUP_SWITCH_MAX_LEN = GROUP_SWITCH_HEADER_LEN + RELAY_SITE_GROUPS / 8;
+
+struct RelayGroup {
+    uint8_t siteGroup;  // 0 .. RELAY_SITE_GROUPS - 1
+    uint32_t pins;      // bit n drives GPIOn; only GPIO0..31 sit in the W1TS/W1TC registers
+};
+
+// GPIO0 is a strapping pin, GPIO1/3 carry Serial and GPIO6..11 the SPI flash.
+// GPIO5 and 16..19 go to the E32 (AUXPIN, LORA_RXPIN, LORA_TXPIN, MOPIN, M1PIN).
+// GPIO20, 24 and 28..31 do not exist on the ESP32.
+constexpr uint32_t RELAY_RESERVED_PINS = (1u << 0) | (1u << 1) | (1u << 3) | (1u << 5) | (0x3Fu << 6) |
+                                         (0x1Fu << 16) | (1u << 20) | (1u << 24) | (0xFu << 28);
+
+// True if every group has pins, none of them reserved, and a site group in range.
+constexpr bool relayGroupsValid(const RelayGroup* groups, uint8_t count) {
+    return count == 0 ||
+           (groups[0].pins != 0 && (groups[0].pins & RELAY_RESERVED_PINS) == 0 &&
+            groups[0].siteGroup < RELAY_SITE_GROUPS && relayGroupsValid(groups + 1, (uint8_t)(count - 1)));
+}
+
+class RelayBank {
+public:
+    RelayBank();
+
+    /**
+     * @brief Takes a group table, makes its pins outputs and switches everything off.
+     *
+     * @return False if a group has no pins, an invalid pin or a bad site
+     *         group number; such groups are left out.
+     */
+    bool begin(const RelayGroup* groups, uint8_t count);
+
+    // Switches every group at once.
+    void setAll(bool on);
+
+    /**
+     * @brief Applies a group switch frame.
+     *
+     * @return The number of local groups it selected.
+     */
+    uint8_t applyFrame(const uint8_t* frame, uint8_t len);
+
+    // Pins currently driven high.
+    uint32_t outputs() const { return state; }
+
+    uint8_t groupCount() const { return count; }
+
+private:
+    void write(uint32_t pins, bool on);
+
+    RelayGroup groups[RELAY_GROUP_MAX];
+    uint8_t count;
+    uint32_t allPins;
+    uint32_t state;
+};
+
+#endif // RELAY_GROUPS_H
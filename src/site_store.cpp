@@ -0,0 +1,158 @@
+/*
+ Project Name ------  FRS
+ Task --------------  Escalator Node Firmware with Esp32
+ Engineer ----------- Muhammad Usman
+ File --------------- Site Record Store Source File
+ Company -----------  Machadev Pvt Limited
+ */
+
+// Import Libraries
+#include "site_store.h"
+#include <esp_rom_crc.h>
+#include <stdlib.h>
+#include <string.h>
+
+SiteStore::SiteStore()
+    : partition(nullptr), mapHandle(0), mapped(nullptr), current(nullptr), currentSector(0) {
+}
+
+// Finds and maps the "siterec" partition and selects the current image.
+bool SiteStore::begin() {
+    partition = esp_partition_find_first(ESP_PARTITION_TYPE_DATA, ESP_PARTITION_SUBTYPE_ANY, "siterec");
+    if (partition == nullptr || partition->size < 2 * SITE_SECTOR_SIZE) {
+        return false;
+    }
+    const void* ptr = nullptr;
+    if (esp_partition_mmap(partition, 0, 2 * SITE_SECTOR_SIZE, ESP_PARTITION_MMAP_DATA,
+                           &ptr, &mapHandle) != ESP_OK) {
+        return false;
+    }
+    mapped = (const uint8_t*)ptr;
+    selectCurrent();
+    return true;
+}
+
+// Returns the header at the start of a sector.
+const SiteImageHeader* SiteStore::sectorHeader(uint8_t sector) const {
+    return (const SiteImageHeader*)(mapped + sector * SITE_SECTOR_SIZE);
+}
+
+// Checks magic, layout, bounds and CRC of the image in a sector.
+bool SiteStore::sectorValid(uint8_t sector) const {
+    const SiteImageHeader* header = sectorHeader(sector);
+    if (header->magic != SITE_IMAGE_MAGIC || header->layout != SITE_IMAGE_LAYOUT) {
+        return false;
+    }
+    size_t bodyLength = header->fieldCount * sizeof(SiteFieldIndex) + header->dataLength;
+    if (sizeof(SiteImageHeader) + bodyLength > SITE_SECTOR_SIZE) {
+        return false;
+    }
+    const uint8_t* body = (const uint8_t*)header + sizeof(SiteImageHeader);
+    return esp_rom_crc32_le(0, body, bodyLength) == header->crc;
+}
+
+// Picks the valid image with the highest generation.
+void SiteStore::selectCurrent() {
+    current = nullptr;
+    for (uint8_t sector = 0; sector < 2; sector++) {
+        if (!sectorValid(sector)) {
+            continue;
+        }
+        const SiteImageHeader* header = sectorHeader(sector);
+        if (current == nullptr || (int32_t)(header->generation - current->generation) > 0) {
+            current = header;
+            currentSector = sector;
+        }
+    }
+}
+
+// Writes all config fields as a new image into the other sector.
+bool SiteStore::save(const ConfigStore& config) {
+    if (mapped == nullptr) {
+        return false;
+    }
+    uint8_t* image = (uint8_t*)malloc(SITE_SECTOR_SIZE);
+    if (image == nullptr) {
+        return false;
+    }
+
+    SiteImageHeader* header = (SiteImageHeader*)image;
+    SiteFieldIndex* index = (SiteFieldIndex*)(image + sizeof(SiteImageHeader));
+    size_t dataStart = sizeof(SiteImageHeader) + CFG_FIELD_COUNT * sizeof(SiteFieldIndex);
+    size_t offset = dataStart;
+    for (uint8_t i = 0; i < CFG_FIELD_COUNT; i++) {
+        const char* value = config.get((ConfigField)i);
+        size_t len = strlen(value);   // < CONFIG_VALUE_MAX, so all fields always fit
+        FieldVersion version = config.version((ConfigField)i);
+        memcpy(image + offset, value, len);
+        index[i].offset = (uint16_t)offset;
+        index[i].length = (uint8_t)len;
+        index[i].writer = version.writer;
+        index[i].counter = version.counter;
+        offset += len;
+    }
+
+    header->magic = SITE_IMAGE_MAGIC;
+    header->layout = SITE_IMAGE_LAYOUT;
+    header->fieldCount = CFG_FIELD_COUNT;
+    header->generation = current ? current->generation + 1 : 1;
+    header->dataLength = (uint16_t)(offset - dataStart);
+    header->reserved = 0;
+    header->crc = esp_rom_crc32_le(0, image + sizeof(SiteImageHeader), offset - sizeof(SiteImageHeader));
+
+    // Body first, header last: a torn write leaves an image without magic, never a bad one.
+    uint8_t target = current ? (uint8_t)(currentSector ^ 1) : 0;
+    size_t base = target * SITE_SECTOR_SIZE;
+    bool ok = esp_partition_erase_range(partition, base, SITE_SECTOR_SIZE) == ESP_OK &&
+              esp_partition_write(partition, base + sizeof(SiteImageHeader),
+                                  image + sizeof(SiteImageHeader), offset - sizeof(SiteImageHeader)) == ESP_OK &&
+              esp_partition_write(partition, base, image, sizeof(SiteImageHeader)) == ESP_OK;
+    free(image);
+
+    if (ok) {
+        selectCurrent();
+    }
+    return ok;
+}
+
+// Restores every stored field and its version into the config.
+bool SiteStore::load(ConfigStore& config) const {
+    if (current == nullptr) {
+        return false;
+    }
+    for (uint8_t i = 0; i < CFG_FIELD_COUNT; i++) {
+        size_t len = 0;
+        const char* value = field((ConfigField)i, &len);
+        if (value == nullptr) {
+            continue;
+        }
+        const SiteFieldIndex* index = (const SiteFieldIndex*)((const uint8_t*)current + sizeof(SiteImageHeader));
+        FieldVersion version = { index[i].counter, index[i].writer };
+        config.restore((ConfigField)i, value, len, version);
+    }
+    return true;
+}
+
+// Returns true if any field of the record is stored and non-empty.
+bool SiteStore::hasRecord(SiteRecord record) const {
+    if (record >= REC_COUNT) {
+        return false;
+    }
+    for (uint8_t i = SITE_RECORD_FIELDS[record].first; i <= SITE_RECORD_FIELDS[record].last; i++) {
+        size_t len = 0;
+        if (field((ConfigField)i, &len) != nullptr && len > 0) {
+            return true;
+        }
+    }
+    return false;
+}
+
+// Returns a pointer into mapped flash for a field.
+const char* SiteStore::field(ConfigField field, size_t* len) const {
+    if (current == nullptr || field >= current->fieldCount) {
+        return nullptr;
+    }
+    const SiteFieldIndex* index = (const SiteFieldIndex*)((const uint8_t*)current + sizeof(SiteImageHeader));
+    *len = index[field].length;
+    return (const char*)current + index[field].offset;
+}
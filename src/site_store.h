@@ -0,0 +1,129 @@
+/*
+ Project Name ------  FRS
+ Task --------------  Escalator Node Firmware with Esp32
+ Engineer ----------- Muhammad Usman
+ File --------------- Site Record Store Header File
+ Company -----------  Machadev Pvt Limited
+ */
+
+// site_store.h
+#ifndef SITE_STORE_H
+#define SITE_STORE_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include <esp_partition.h>
+#include "config_sync.h"
+
+/*
+ The "siterec" partition (see partitions.csv) holds two 4 KB sectors that
+ are written alternately; the valid image with the highest generation is
+ current, so a power cut mid-write leaves the previous image intact.
+
+ Image layout (little endian, packed):
+
+   SiteImageHeader                        20 bytes
+   SiteFieldIndex[fieldCount]              6 bytes each
+   field bytes, back to back, no NUL      dataLength bytes
+
+ The whole partition is memory mapped once at start-up; readers get
+ pointers straight into flash and never copy a field into RAM. Each
+ save() erases the sector that is not current, so a pointer from before
+ the previous save may point at erased flash: callers hold configMutex
+ around save() and for as long as they use field() pointers.
+*/
+
+constexpr uint32_t SITE_IMAGE_MAGIC = 0x52535246;  // "FRSR"
+constexpr uint16_t SITE_IMAGE_LAYOUT = 1;
+constexpr size_t SITE_SECTOR_SIZE = 4096;
+
+struct __attribute__((packed)) SiteImageHeader {
+    uint32_t magic;
+    uint16_t layout;
+    uint16_t fieldCount;
+    uint32_t generation;
+    uint16_t dataLength;
+    uint16_t reserved;
+    uint32_t crc;          // CRC32 of the index and field bytes
+};
+
+struct __attribute__((packed)) SiteFieldIndex {
+    uint16_t offset;       // from the start of the image
+    uint8_t length;
+    uint8_t writer;        // config sync version of the field
+    uint16_t counter;
+};
+
+// Portal records, each a contiguous range of config fields.
+enum SiteRecord : uint8_t {
+    REC_COMPANY,
+    REC_UNIT,
+    REC_MANUFACTURER,
+    REC_ACCESS_POINT,
+    REC_COUNT
+};
+
+struct SiteRecordRange {
+    ConfigField first;
+    ConfigField last;
+};
+
+constexpr SiteRecordRange SITE_RECORD_FIELDS[REC_COUNT] = {
+    { CFG_COMPANY_NAME, CFG_FIRE_DEPARTMENT_CONTACT },
+    { CFG_UNIT_LOCATION, CFG_UNIT_IP_ADDRESS },
+    { CFG_MFR_NAME, CFG_MFR_SERIAL },
+    { CFG_AP_SSID, CFG_AP_PASSWORD },
+};
+
+class SiteStore {
+public:
+    SiteStore();
+
+    /**
+     * @brief Finds and maps the "siterec" partition and selects the current image.
+     *
+     * @return false if the partition is missing or cannot be mapped.
+     */
+    bool begin();
+
+    /**
+     * @brief Writes all config fields as a new image into the other sector.
+     *
+     * @return true once the new image is written and current.
+     */
+    bool save(const ConfigStore& config);
+
+    /**
+     * @brief Restores every stored field and its version into the config.
+     *
+     * @return false if no valid image exists.
+     */
+    bool load(ConfigStore& config) const;
+
+    /**
+     * @brief Returns true if any field of the record is stored and non-empty.
+     */
+    bool hasRecord(SiteRecord record) const;
+
+    /**
+     * @brief Returns a pointer into mapped flash for a field.
+     *
+     * The bytes are not NUL terminated; use len.
+     *
+     * @return nullptr if there is no valid image or the field is not stored.
+     */
+    const char* field(ConfigField field, size_t* len) const;
+
+private:
+    const SiteImageHeader* sectorHeader(uint8_t sector) const;
+    bool sectorValid(uint8_t sector) const;
+    void selectCurrent();
+
+    const esp_partition_t* partition;
+    spi_flash_mmap_handle_t mapHandle;
+    const uint8_t* mapped;
+    const SiteImageHeader* current;   // nullptr until a valid image exists
+    uint8_t currentSector;
+};
+
+#endif // SITE_STORE_H
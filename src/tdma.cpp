@@ -0,0 +1,46 @@
+/*
+ Project Name ------  FRS
+ Task --------------  Escalator Node Firmware with Esp32
+ Engineer ----------- Muhammad Usman
+ File --------------- TDMA Slot Schedule Source File
+ Company -----------  Machadev Pvt Limited
+ */
+
+// Import Libraries
+#include "tdma.h"
+
+// The n-th beacon slot, skipping contention and transfer slots; IDs start at 1.
+void TdmaSchedule::begin(uint8_t nodeId) {
+    uint16_t n = (uint16_t)((nodeId + TDMA_BEACON_SLOTS - 1) % TDMA_BEACON_SLOTS);
+    beaconSlot = (uint16_t)((n / TDMA_BEACONS_PER_GROUP) * TDMA_CONTENTION_EVERY + 1 + n % TDMA_BEACONS_PER_GROUP);
+}
+
+// A frame may start from guard after the window start until it would end guard before the window end.
+uint32_t TdmaSchedule::untilWindow(uint32_t phase, uint32_t period, uint32_t start, uint32_t length,
+                                   uint32_t airMs, uint16_t guardMs) {
+    if (guardMs > TDMA_MAX_GUARD_MS) {
+        guardMs = TDMA_MAX_GUARD_MS;
+    }
+    uint32_t open = start + guardMs;
+    uint32_t close = start + length - guardMs - airMs;
+    if (phase >= open && phase <= close) {
+        return 0;
+    }
+    return phase < open ? open - phase : period - phase + open;
+}
+
+uint32_t TdmaSchedule::untilBeacon(uint32_t netMs, uint16_t guardMs) const {
+    return untilWindow(netMs % TDMA_SUPERFRAME_MS, TDMA_SUPERFRAME_MS, beaconSlot * TDMA_SLOT_MS, TDMA_SLOT_MS,
+                       TDMA_BEACON_AIR_MS, guardMs);
+}
+
+uint32_t TdmaSchedule::untilContention(uint32_t netMs, uint16_t guardMs) {
+    uint32_t period = TDMA_SLOT_MS * TDMA_CONTENTION_EVERY;
+    return untilWindow(netMs % period, period, 0, TDMA_SLOT_MS, TDMA_BEACON_AIR_MS, guardMs);
+}
+
+uint32_t TdmaSchedule::untilTransfer(uint32_t netMs, uint16_t guardMs) {
+    uint32_t period = TDMA_SLOT_MS * TDMA_CONTENTION_EVERY;
+    uint32_t start = (TDMA_CONTENTION_EVERY - TDMA_TRANSFER_SLOTS) * TDMA_SLOT_MS;
+    return untilWindow(netMs % period, period, start, TDMA_TRANSFER_SLOTS * TDMA_SLOT_MS, TDMA_TRANSFER_AIR_MS, guardMs);
+}
@@ -0,0 +1,90 @@
+/*
+ Project Name ------  FRS
+ Task --------------  Escalator Node Firmware with Esp32
+ Engineer ----------- Muhammad Usman
+ File --------------- TDMA Slot Schedule Header File
+ Company -----------  Machadev Pvt Limited
+ */
+
+// tdma.h
+#ifndef TDMA_H
+#define TDMA_H
+
+#include <stdint.h>
+#include "power.h"
+
+/*
+ Beacons are sent in a repeating superframe of TDMA_SLOTS slots, timed
+ by network time (time_sync.h). The superframe is made of groups of
+ TDMA_CONTENTION_EVERY slots:
+
+   [contention][beacon] ... [beacon][transfer] ... [transfer]
+
+ The contention slot carries alarm traffic, so it never has to compete
+ with the beacons. Each beacon slot belongs to one node ID, so beacons
+ from up to TDMA_BEACON_SLOTS nodes never collide. Higher IDs wrap
+ around and share slots. The transfer slots at the end of each group
+ carry the fragments and ACKs of the transport (transport.h), which are
+ too long for one slot; nodes contend for them like for the contention
+ slot, and collisions are left to the transport's retries.
+
+ A node sends its beacon once per superframe. It waits its own error
+ bound after the start of its slot, and must also stay that far from
+ the end, so that neighbours whose clocks are off the other way do not
+ overlap.
+
+ On a wake-on-radio site (power.h) every frame carries the wake-up
+ preamble, so each slot, and with it the superframe, grows by the
+ wake-up period.
+*/
+
+constexpr uint16_t TDMA_SLOTS = 100;
+constexpr uint32_t TDMA_SLOT_MS = 300 + WAKE_PERIOD_MS;
+constexpr uint32_t TDMA_SUPERFRAME_MS = TDMA_SLOT_MS * TDMA_SLOTS;  // 30 s, the old presence period, without wake-up
+constexpr uint16_t TDMA_CONTENTION_EVERY = 10;  // slots 0, 10, 20, ... carry alarms
+constexpr uint16_t TDMA_TRANSFER_SLOTS = 6;     // at the end of each group, four transport frames' worth
+constexpr uint16_t TDMA_BEACONS_PER_GROUP = TDMA_CONTENTION_EVERY - 1 - TDMA_TRANSFER_SLOTS;
+constexpr uint16_t TDMA_BEACON_SLOTS = TDMA_SLOTS / TDMA_CONTENTION_EVERY * TDMA_BEACONS_PER_GROUP;
+constexpr uint32_t TDMA_BEACON_AIR_MS = 190 + WAKE_PERIOD_MS;  // 14 byte beacon at 2.4 kbps, UART at both ends
+constexpr uint32_t TDMA_TRANSFER_AIR_MS = 400 + WAKE_PERIOD_MS;  // 48 byte transport frame, UART at both ends
+constexpr uint16_t TDMA_MAX_GUARD_MS = (TDMA_SLOT_MS - TDMA_BEACON_AIR_MS) / 2;  // about 9 hops from the root
+
+static_assert(TDMA_SLOT_MS > TDMA_BEACON_AIR_MS, "a beacon must fit in its slot");
+static_assert(TDMA_TRANSFER_SLOTS * TDMA_SLOT_MS > TDMA_TRANSFER_AIR_MS + 2 * TDMA_MAX_GUARD_MS,
+              "a transport frame must fit in the transfer slots");
+
+class TdmaSchedule {
+public:
+    TdmaSchedule() : beaconSlot(1) {}
+
+    // Picks the beacon slot of this node ID.
+    void begin(uint8_t nodeId);
+
+    uint16_t slot() const { return beaconSlot; }
+
+    /**
+     * @brief Milliseconds until this node may start its beacon.
+     *
+     * @param netMs Current network time.
+     * @param guardMs This node's clock error bound, at most TDMA_MAX_GUARD_MS.
+     * @return 0 while inside the window of the current slot.
+     */
+    uint32_t untilBeacon(uint32_t netMs, uint16_t guardMs) const;
+
+    // Same window, in the next contention slot, for alarm frames no longer than a beacon.
+    static uint32_t untilContention(uint32_t netMs, uint16_t guardMs);
+
+    // Same window, in the next transfer slots, for one transport frame.
+    static uint32_t untilTransfer(uint32_t netMs, uint16_t guardMs);
+
+    static uint16_t slotAt(uint32_t netMs) { return (uint16_t)((netMs % TDMA_SUPERFRAME_MS) / TDMA_SLOT_MS); }
+    static bool isContention(uint16_t slot) { return slot % TDMA_CONTENTION_EVERY == 0; }
+
+private:
+    static uint32_t untilWindow(uint32_t phase, uint32_t period, uint32_t start, uint32_t length,
+                                uint32_t airMs, uint16_t guardMs);
+
+    uint16_t beaconSlot;
+};
+
+#endif // TDMA_H
@@ -0,0 +1,174 @@
+/*
+ Project Name ------  FRS
+ Task --------------  Escalator Node Firmware with Esp32
+ Engineer ----------- Muhammad Usman
+ File --------------- Time Sync Source File
+ Company -----------  Machadev Pvt Limited
+ */
+
+// Import Libraries
+#include "time_sync.h"
+#include <string.h>
+
+TimeSync::TimeSync()
+    : self(0), rootId(0), hopCount(0), parentId(0), rootSeq(0), established(false), announce(false),
+      lowestListener(0xFF), deadRoot(0), deadSeq(0), offset(0), bootMs(0), lastSyncMs(0), lastSeqMs(0), deadAtMs(0),
+      syncBound(0), lastLocalMs(0), localWraps(0) {
+    memset(&counters, 0, sizeof(counters));
+}
+
+void TimeSync::begin(uint8_t selfId, uint32_t localMs) {
+    self = selfId;
+    bootMs = localMs;
+    lastSyncMs = localMs;
+    lastSeqMs = localMs;
+    lastLocalMs = localMs;
+    localWraps = 0;
+    established = false;
+    announce = false;
+    lowestListener = 0xFF;
+    deadRoot = 0;
+    becomeRoot();
+}
+
+// millis() extended past its wraps, counted from the last poll().
+uint64_t TimeSync::extend(uint32_t localMs) const {
+    uint64_t wraps = localWraps;
+    bool after = (int32_t)(localMs - lastLocalMs) >= 0;
+    if (after && localMs < lastLocalMs) {
+        wraps++;   // wrapped since the last poll()
+    } else if (!after && localMs > lastLocalMs && wraps > 0) {
+        wraps--;   // taken before the last wrap
+    }
+    return (wraps << 32) | localMs;
+}
+
+// a - b the short way round the epoch.
+static int32_t epochDelta(uint32_t a, uint32_t b) {
+    uint32_t d = a >= b ? a - b : a + (TIME_SYNC_EPOCH_MS - b);
+    return d > TIME_SYNC_EPOCH_MS / 2 ? -(int32_t)(TIME_SYNC_EPOCH_MS - d) : (int32_t)d;
+}
+
+void TimeSync::becomeRoot() {
+    rootId = self;
+    hopCount = 0;
+    parentId = self;
+    syncBound = 0;
+}
+
+uint16_t TimeSync::errorBound(uint32_t localMs) const {
+    if (!established) {
+        return TIME_SYNC_UNBOUNDED;
+    }
+    if (isRoot()) {
+        return 0;
+    }
+    uint32_t drift = (localMs - lastSyncMs) / (1000000 / TIME_SYNC_DRIFT_PPM) + 1;
+    uint32_t bound = syncBound + drift;
+    return bound < TIME_SYNC_UNBOUNDED ? (uint16_t)bound : TIME_SYNC_UNBOUNDED;
+}
+
+bool TimeSync::synced(uint32_t localMs, uint16_t maxBoundMs) const {
+    return established && errorBound(localMs) <= maxBoundMs;
+}
+
+void TimeSync::fill(uint8_t* out, uint32_t localMs) {
+    if (isRoot()) {
+        rootSeq++;
+    }
+    uint32_t now = networkTime(localMs);
+    uint16_t bound = errorBound(localMs);
+    out[0] = (uint8_t)now;
+    out[1] = (uint8_t)(now >> 8);
+    out[2] = (uint8_t)(now >> 16);
+    out[3] = (uint8_t)(now >> 24);
+    out[4] = (uint8_t)bound;
+    out[5] = (uint8_t)(bound >> 8);
+    out[6] = rootId;
+    out[7] = hopCount;
+    out[8] = rootSeq;
+}
+
+bool TimeSync::onBeacon(uint8_t from, const uint8_t* sync, uint32_t rxLocalMs) {
+    uint32_t time = (uint32_t)sync[0] | ((uint32_t)sync[1] << 8) | ((uint32_t)sync[2] << 16) | ((uint32_t)sync[3] << 24);
+    uint16_t bound = (uint16_t)(sync[4] | (sync[5] << 8));
+    uint8_t root = sync[6];
+    uint8_t hops = sync[7];
+    uint8_t seq = sync[8];
+    counters.beacons++;
+    if (bound == TIME_SYNC_UNBOUNDED || hops == 0xFF) {
+        if (from < lowestListener) {
+            lowestListener = from;   // the sender is still listening itself
+        }
+        return false;
+    }
+
+    // Neighbours still repeating a root we gave up on must not pull us back into its tree.
+    if (root == deadRoot && !seqBefore(deadSeq, seq) && rxLocalMs - deadAtMs < TIME_SYNC_ROOT_TIMEOUT_MS) {
+        counters.stale++;
+        return false;
+    }
+
+    // Any tree while listening, then only a lower root, a shorter path to ours, or our parent.
+    bool join = !established || root < rootId;
+    bool follow = root == rootId && !isRoot() && (from == parentId || hops + 1 < hopCount);
+    if (follow && seqBefore(seq, rootSeq)) {
+        counters.stale++;
+        return false;
+    }
+    if (!join && !follow) {
+        return false;
+    }
+
+    uint32_t rxNet = (uint32_t)(extend(rxLocalMs) % TIME_SYNC_EPOCH_MS);
+    uint32_t estimate = (uint32_t)(((uint64_t)time + TIME_SYNC_LINK_DELAY_MS + TIME_SYNC_EPOCH_MS - rxNet) % TIME_SYNC_EPOCH_MS);
+    int32_t delta = epochDelta(estimate, offset);
+    uint32_t correction = (uint32_t)(delta < 0 ? -delta : delta);
+    if (join || correction > TIME_SYNC_STEP_MS) {
+        offset = estimate;
+        syncBound = bound + TIME_SYNC_JITTER_MS;
+        counters.steps++;
+    } else {
+        offset = (uint32_t)(((int64_t)offset + delta / 2 + TIME_SYNC_EPOCH_MS) % TIME_SYNC_EPOCH_MS);
+        syncBound = bound + TIME_SYNC_JITTER_MS + correction / 2;
+        counters.adjustments++;
+    }
+    counters.lastCorrectionMs = correction;
+    if (join && root != rootId) {
+        announce = true;
+    }
+    if (join || seqBefore(rootSeq, seq)) {
+        lastSeqMs = rxLocalMs;   // the root is alive
+    }
+    rootSeq = seq;
+    rootId = root;
+    hopCount = (uint8_t)(hops + 1);
+    parentId = from;
+    established = true;
+    lastSyncMs = rxLocalMs;
+    return true;
+}
+
+void TimeSync::poll(uint32_t localMs) {
+    if ((int32_t)(localMs - lastLocalMs) >= 0) {
+        if (localMs < lastLocalMs) {
+            localWraps++;
+        }
+        lastLocalMs = localMs;
+    }
+
+    // No tree around: start one on our own clock, unless a lower ID is about to.
+    uint32_t listened = localMs - bootMs;
+    if (!established && listened >= TIME_SYNC_LISTEN_MS &&
+        (lowestListener > self || listened >= 2 * TIME_SYNC_LISTEN_MS)) {
+        established = true;
+        announce = true;   // the listening neighbours can join now rather than in a superframe
+    }
+    if (!isRoot() && localMs - lastSeqMs > TIME_SYNC_ROOT_TIMEOUT_MS) {
+        counters.rootTimeouts++;
+        deadRoot = rootId;
+        deadSeq = rootSeq;
+        deadAtMs = localMs;
+        becomeRoot();
+    }
+}
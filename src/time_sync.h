@@ -0,0 +1,166 @@
+/*
+ Project Name ------  FRS
+ Task --------------  Escalator Node Firmware with Esp32
+ Engineer ----------- Muhammad Usman
+ File --------------- Time Sync Header File
+ Company -----------  Machadev Pvt Limited
+ */
+
+// time_sync.h
+#ifndef TIME_SYNC_H
+#define TIME_SYNC_H
+
+#include <stdint.h>
+#include "power.h"
+#include "tdma.h"
+
+/*
+ Network time rides on the presence beacons:
+
+   [time u32][bound u16][root][hops][seq]
+
+ time is the sender's network time when it started the send. bound is
+ the most that time can be off from the root's clock, in ms. root is
+ the node the time comes from, and hops is how far the sender is from
+ it. seq is the root's beacon count; only the root advances it, the
+ other nodes pass on the latest one they took.
+
+ Network time counts up to TIME_SYNC_EPOCH_MS and starts over at 0. The
+ epoch is a whole number of superframes, so the TDMA slot keeps running
+ when the network time wraps; millis() wraps at 2^32, which is not, so
+ the node counts its own wraps and works on the extended local time.
+
+ A new node first listens. It joins the first tree it hears and takes
+ that tree's time. If it hears no tree for TIME_SYNC_LISTEN_MS, it
+ becomes a root and its network time is its own millis(). It waits
+ longer if it heard a lower ID that is still listening, so that after a
+ site-wide power-up only the lowest ID in each area starts a tree. When
+ two trees meet, the one with the lower root ID wins. The listen time
+ and the root timeout below are counted in superframes, so they stretch
+ with the wake-up period.
+
+ A node that starts a tree or moves to a lower root does not wait up to
+ a superframe for its own slot to tell its neighbours: it beacons once
+ more in one of the next TIME_SYNC_ANNOUNCE_GROUPS contention slots,
+ drawn at random so that neighbours that switched on the same beacon do
+ not all collide. The lower root so spreads by a few groups per hop
+ instead of a superframe.
+
+ Every other node follows the neighbour closest to the root. From each
+ beacon it estimates offset = time + link delay - rx time. Small
+ corrections are averaged in, large ones replace the clock. The error
+ bound adds the parent's bound, receive jitter, half the last correction
+ and crystal drift since the last beacon. So it grows with hops and with
+ silence.
+
+ Beacons of our root whose seq is older than the one we have are stale
+ and ignored. If seq has not advanced for TIME_SYNC_ROOT_TIMEOUT_MS, the
+ root is gone: the node becomes a root itself and keeps its current
+ network time, so the clocks do not jump. Neighbours still repeating the
+ old root's last seq cannot pull it back into that tree, so the nodes do
+ not keep each other alive by counting hops up to infinity.
+*/
+
+constexpr uint8_t TIME_SYNC_LEN = 9;
+constexpr uint32_t TIME_SYNC_LINK_DELAY_MS = 185 + WAKE_PERIOD_MS;   // beacon send to receive, UART both ends + preamble + air at 2.4 kbps
+constexpr uint32_t TIME_SYNC_JITTER_MS = 5;         // receive timestamp uncertainty per hop
+constexpr uint32_t TIME_SYNC_DRIFT_PPM = 40;        // two crystals at +-20 ppm
+constexpr uint32_t TIME_SYNC_STEP_MS = 500;         // larger corrections replace the clock
+constexpr uint32_t TIME_SYNC_ROOT_TIMEOUT_MS = 3 * TDMA_SUPERFRAME_MS + 10000;  // three missed superframes and some slack
+constexpr uint32_t TIME_SYNC_LISTEN_MS = 2 * TDMA_SUPERFRAME_MS + 5000;  // a new node listens this long before it trusts itself as root
+constexpr uint8_t TIME_SYNC_ANNOUNCE_GROUPS = 4;     // a new root is announced in one of the next four contention slots
+constexpr uint16_t TIME_SYNC_UNBOUNDED = 0xFFFF;
+constexpr uint32_t TIME_SYNC_EPOCH_MS = 0xFFFFFFFFUL / TDMA_SUPERFRAME_MS * TDMA_SUPERFRAME_MS;
+
+struct TimeSyncStats {
+    uint32_t beacons;       // sync fields received
+    uint32_t adjustments;   // averaged corrections
+    uint32_t steps;         // clock replaced (first sync, new root, large error)
+    uint32_t rootTimeouts;
+    uint32_t stale;         // beacons of our root or of a dead one with an old seq
+    uint32_t lastCorrectionMs;   // absolute size of the last correction
+};
+
+class TimeSync {
+public:
+    TimeSync();
+
+    /**
+     * @brief Starts listening for a tree to join.
+     */
+    void begin(uint8_t selfId, uint32_t localMs);
+
+    /**
+     * @brief Network time at localMs, 0 .. TIME_SYNC_EPOCH_MS - 1.
+     *
+     * localMs may lie up to 2^31 ms either side of the last poll().
+     */
+    uint32_t networkTime(uint32_t localMs) const {
+        return (uint32_t)((extend(localMs) % TIME_SYNC_EPOCH_MS + offset) % TIME_SYNC_EPOCH_MS);
+    }
+
+    /**
+     * @brief Largest possible error of networkTime() against the root, in ms.
+     *
+     * @return 0 on the root, TIME_SYNC_UNBOUNDED while still listening.
+     */
+    uint16_t errorBound(uint32_t localMs) const;
+
+    /**
+     * @brief True once the network time is within maxBoundMs of the root's.
+     */
+    bool synced(uint32_t localMs, uint16_t maxBoundMs) const;
+
+    // Writes the TIME_SYNC_LEN sync field; call right before the send starts. A root advances seq.
+    void fill(uint8_t* out, uint32_t localMs);
+
+    /**
+     * @brief Takes the sync field of a received beacon.
+     *
+     * @param rxLocalMs millis() when the frame was received.
+     * @return True if the beacon moved this node's clock.
+     */
+    bool onBeacon(uint8_t from, const uint8_t* sync, uint32_t rxLocalMs);
+
+    // Counts millis() wraps, ends the listening period and falls back to being a root when seq stops.
+    void poll(uint32_t localMs);
+
+    /**
+     * @brief True from starting a tree or taking a new root until clearAnnounce().
+     */
+    bool announcePending() const { return announce; }
+    void clearAnnounce() { announce = false; }
+
+    bool isRoot() const { return rootId == self; }
+    uint8_t root() const { return rootId; }
+    uint8_t hops() const { return hopCount; }
+    uint8_t parent() const { return parentId; }
+    const TimeSyncStats& stats() const { return counters; }
+
+private:
+    void becomeRoot();
+    uint64_t extend(uint32_t localMs) const;
+    static bool seqBefore(uint8_t a, uint8_t b) { return (int8_t)(a - b) < 0; }
+
+    uint8_t self;
+    uint8_t rootId;
+    uint8_t hopCount;
+    uint8_t parentId;
+    uint8_t rootSeq;         // latest seq of our root
+    bool established;        // has a network time: joined a tree, or listened long enough to start one
+    bool announce;           // took a new root and has not beaconed it outside its slot yet
+    uint8_t lowestListener;  // lowest ID heard while both were still listening
+    uint8_t deadRoot;        // root we gave up on, 0 if none
+    uint8_t deadSeq;         // its last seq; beacons up to it are stale
+    uint32_t offset;         // network time - local time, mod TIME_SYNC_EPOCH_MS
+    uint32_t bootMs;
+    uint32_t lastSyncMs;     // local time of the last beacon taken
+    uint32_t lastSeqMs;      // local time seq last advanced
+    uint32_t deadAtMs;       // local time we gave up on deadRoot
+    uint32_t syncBound;      // error bound right after that beacon
+    uint32_t lastLocalMs;    // millis() at the last poll()
+    uint32_t localWraps;     // times millis() wrapped before it
+    TimeSyncStats counters;
+};
+
+#endif // TIME_SYNC_H
@@ -0,0 +1,269 @@
+/*
+ Project Name ------  FRS
+ Task --------------  Escalator Node Firmware with Esp32
+ Engineer ----------- Muhammad Usman
+ File --------------- Fragment Transport Source File
+ Company -----------  Machadev Pvt Limited
+ */
+
+// Import Libraries
+#include "transport.h"
+#include <string.h>
+
+FragmentTransport::FragmentTransport(SendFrameFn sendFrame, DeliverFn deliver, CompleteFn complete, ClockFn clock,
+                                     ClearFn clear)
+    : sendFrame(sendFrame), deliver(deliver), complete(complete), clock(clock), clear(clear), selfId(0),
+      ackTimeout(XFER_ACK_TIMEOUT), jitterState(1), txState(TX_IDLE), txDest(0), txId(0), txTotal(0), txRetries(0),
+      txAcked(0), txSent(0), txQueue(0), txLast(0), txLength(0), txDeadline(0) {
+    memset(rxSlots, 0, sizeof(rxSlots));
+    memset(&counters, 0, sizeof(counters));
+}
+
+// Sets the node ID used to filter inbound fragments.
+void FragmentTransport::begin(uint8_t id, unsigned long ackTimeoutMs, uint8_t bootSeed) {
+    selfId = id;
+    ackTimeout = ackTimeoutMs;
+    txId = bootSeed;
+    jitterState = 0x9E3779B9UL * (id + 1UL);
+}
+
+// Starts an outbound transfer.
+bool FragmentTransport::send(uint8_t dest, const uint8_t* data, size_t len, unsigned long now) {
+    if (busy() || len == 0 || len > XFER_MAX_PAYLOAD) {
+        return false;
+    }
+    memcpy(txData, data, len);
+    txLength = len;
+    txDest = dest;
+    txId++;
+    txTotal = (uint8_t)((len + XFER_FRAGMENT_LEN - 1) / XFER_FRAGMENT_LEN);
+    txAcked = 0;
+    txSent = 0;
+    txRetries = 0;
+    startWindow(now);
+    return true;
+}
+
+// True while fragments or ACKs wait for the channel.
+bool FragmentTransport::waiting() const {
+    if (txState == TX_SEND_WINDOW) {
+        return true;
+    }
+    for (const auto& slot : rxSlots) {
+        if (slot.inUse && slot.ackDue) {
+            return true;
+        }
+    }
+    return false;
+}
+
+// Sends held-back ACKs and fragments, and retransmits windows whose ACK timed out.
+void FragmentTransport::poll(unsigned long now) {
+    for (auto& slot : rxSlots) {
+        if (slot.inUse && slot.ackDue) {
+            sendAck(slot);
+        }
+    }
+    if (txState == TX_SEND_WINDOW) {
+        sendQueued(now);
+    }
+    else if (txState == TX_WAIT_ACK && (long)(now - txDeadline) >= 0) {
+        if (++txRetries > XFER_MAX_RETRIES) {
+            finishTx(false);
+            return;
+        }
+        startWindow(now);
+    }
+}
+
+// Queues up to XFER_WINDOW fragments that are not yet acknowledged, starting
+// from the lowest missing one, and sends as many as the channel allows.
+void FragmentTransport::startWindow(unsigned long now) {
+    uint8_t count = 0;
+    txQueue = 0;
+    for (uint8_t seq = 0; seq < txTotal && count < XFER_WINDOW; seq++) {
+        if (!(txAcked & (1UL << seq))) {
+            txQueue |= 1UL << seq;
+            txLast = seq;
+            count++;
+        }
+    }
+    txState = TX_SEND_WINDOW;
+    sendQueued(now);
+}
+
+// Sends queued fragments while the channel is clear; the last of the window
+// asks for an ACK. The ACK timer runs from the end of the window.
+void FragmentTransport::sendQueued(unsigned long now) {
+    uint8_t frame[MESH_FRAME_MAX_LEN];
+    uint8_t seq = 0;
+    while (txQueue != 0 && (clear == nullptr || clear())) {
+        while (!(txQueue & (1UL << seq))) seq++;
+        txQueue &= ~(1UL << seq);
+        size_t offset = (size_t)seq * XFER_FRAGMENT_LEN;
+        size_t chunk = txLength - offset;
+        if (chunk > XFER_FRAGMENT_LEN) chunk = XFER_FRAGMENT_LEN;
+
+        frame[0] = MSG_XFER_DATA;
+        frame[1] = txDest;
+        frame[2] = txId;
+        frame[3] = seq;
+        frame[4] = txTotal;
+        frame[5] = seq == txLast ? XFER_FLAG_ACK_REQ : 0;
+        memcpy(frame + XFER_DATA_HEADER_LEN, txData + offset, chunk);
+
+        if (sendFrame(frame, (uint8_t)(XFER_DATA_HEADER_LEN + chunk))) {
+            counters.framesSent++;
+            if (txSent & (1UL << seq)) counters.retransmits++;
+            txSent |= 1UL << seq;
+        }
+    }
+    if (txQueue != 0) {
+        return; // the rest waits for the channel
+    }
+
+    txState = TX_WAIT_ACK;
+    jitterState = jitterState * 1664525UL + 1013904223UL;
+    txDeadline = (clock ? clock() : now) + ackTimeout + (jitterState >> 8) % (ackTimeout + 1);
+}
+
+// Ends the outbound transfer and reports the result.
+void FragmentTransport::finishTx(bool ok) {
+    txState = TX_IDLE;
+    if (ok) counters.transfersSent++;
+    else counters.transfersFailed++;
+    if (complete) complete(txDest, ok);
+}
+
+// Feeds a received transport frame.
+void FragmentTransport::onFrame(uint8_t from, const uint8_t* frame, uint8_t len, unsigned long now) {
+    if (len < 2 || (frame[1] != selfId && frame[1] != XFER_BROADCAST)) {
+        return; // not addressed to this node
+    }
+    if (frame[0] == MSG_XFER_DATA) {
+        handleData(from, frame, len, now);
+    }
+    else if (frame[0] == MSG_XFER_ACK) {
+        handleAck(from, frame, len, now);
+    }
+}
+
+// Merges an ACK bitmap and either completes the transfer or sends the next window.
+// An ACK that adds nothing (late or duplicated) leaves the retry timer running.
+void FragmentTransport::handleAck(uint8_t from, const uint8_t* frame, uint8_t len, unsigned long now) {
+    if (len < XFER_ACK_LEN || txState == TX_IDLE || from != txDest || frame[2] != txId) {
+        return;
+    }
+    uint32_t bitmap = (uint32_t)frame[3] | ((uint32_t)frame[4] << 8) |
+                      ((uint32_t)frame[5] << 16) | ((uint32_t)frame[6] << 24);
+    uint32_t acked = txAcked | (bitmap & fullMask(txTotal));
+    if (acked == txAcked) {
+        return;
+    }
+    txAcked = acked;
+    if (txAcked == fullMask(txTotal)) {
+        finishTx(true);
+        return;
+    }
+    txRetries = 0;
+    startWindow(now);
+}
+
+// Stores a fragment and acknowledges when asked to or when the payload is complete.
+void FragmentTransport::handleData(uint8_t from, const uint8_t* frame, uint8_t len, unsigned long now) {
+    if (len <= XFER_DATA_HEADER_LEN) {
+        counters.rxDropped++;
+        return;
+    }
+    uint8_t xferId = frame[2];
+    uint8_t seq = frame[3];
+    uint8_t total = frame[4];
+    uint8_t flags = frame[5];
+    size_t chunk = len - XFER_DATA_HEADER_LEN;
+
+    bool last = (seq == total - 1);
+    if (total == 0 || total > XFER_MAX_FRAGMENTS || seq >= total ||
+        (!last && chunk != XFER_FRAGMENT_LEN)) {
+        counters.rxDropped++;
+        return;
+    }
+
+    RxSlot* slot = findSlot(from, xferId, now);
+    if (slot == nullptr) {
+        counters.rxDropped++;
+        return;
+    }
+    if (!slot->inUse) {
+        slot->inUse = true;
+        slot->delivered = false;
+        slot->ackDue = false;
+        slot->from = from;
+        slot->xferId = xferId;
+        slot->total = total;
+        slot->received = 0;
+        slot->length = 0;
+    }
+    else if (slot->total != total) {
+        counters.rxDropped++;
+        return;
+    }
+    slot->lastActivity = now;
+
+    if (!(slot->received & (1UL << seq))) {
+        memcpy(slot->data + (size_t)seq * XFER_FRAGMENT_LEN, frame + XFER_DATA_HEADER_LEN, chunk);
+        slot->received |= 1UL << seq;
+        if (last) {
+            slot->length = (size_t)seq * XFER_FRAGMENT_LEN + chunk;
+        }
+    }
+
+    bool done = slot->received == fullMask(total);
+    if ((flags & XFER_FLAG_ACK_REQ) || done) {
+        sendAck(*slot);
+    }
+    if (done && !slot->delivered) {
+        slot->delivered = true;  // keep the slot so retransmitted fragments are re-ACKed, not re-delivered
+        counters.transfersReceived++;
+        if (deliver) deliver(from, slot->data, slot->length);
+    }
+}
+
+// Sends the reassembly bitmap of a slot back to its sender, or holds it
+// for poll() until the channel is clear.
+void FragmentTransport::sendAck(RxSlot& slot) {
+    slot.ackDue = clear != nullptr && !clear();
+    if (slot.ackDue) {
+        return;
+    }
+    uint8_t frame[XFER_ACK_LEN];
+    frame[0] = MSG_XFER_ACK;
+    frame[1] = slot.from;
+    frame[2] = slot.xferId;
+    frame[3] = (uint8_t)(slot.received);
+    frame[4] = (uint8_t)(slot.received >> 8);
+    frame[5] = (uint8_t)(slot.received >> 16);
+    frame[6] = (uint8_t)(slot.received >> 24);
+    if (sendFrame(frame, XFER_ACK_LEN)) {
+        counters.acksSent++;
+    }
+}
+
+// Finds the slot of an inbound transfer, or a free one for a new transfer.
+// Slots idle for longer than XFER_RX_TIMEOUT are reclaimed.
+FragmentTransport::RxSlot* FragmentTransport::findSlot(uint8_t from, uint8_t xferId, unsigned long now) {
+    RxSlot* freeSlot = nullptr;
+    for (auto& slot : rxSlots) {
+        if (slot.inUse && slot.from == from && slot.xferId == xferId) {
+            return &slot;
+        }
+    }
+    for (auto& slot : rxSlots) {
+        if (slot.inUse && (now - slot.lastActivity > XFER_RX_TIMEOUT || slot.from == from)) {
+            slot.inUse = false; // stale, or superseded by a newer transfer from the same node
+        }
+        if (!slot.inUse && freeSlot == nullptr) {
+            freeSlot = &slot;
+        }
+    }
+    return freeSlot;
+}
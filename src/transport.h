@@ -0,0 +1,182 @@
+/*
+ Project Name ------  FRS
+ Task --------------  Escalator Node Firmware with Esp32
+ Engineer ----------- Muhammad Usman
+ File --------------- Fragment Transport Header File
+ Company -----------  Machadev Pvt Limited
+ */
+
+// transport.h
+#ifndef TRANSPORT_H
+#define TRANSPORT_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include "protocol.h"
+
+/*
+ Frame layout (all frames fit in MESH_FRAME_MAX_LEN):
+
+   DATA: [MSG_XFER_DATA][dest][xferId][seq][total][flags][data...]
+   ACK:  [MSG_XFER_ACK ][dest][xferId][bitmap LSB .. MSB (4 bytes)]
+
+ Fragments are sent link-layer broadcast so RHReliableDatagram does not
+ stop and wait for a hop ACK on every frame; the receiver filters on the
+ dest byte and answers a whole window with one ACK bitmap. The sender
+ only retransmits the fragments whose bit is still clear.
+
+ The ACK timer starts once the last fragment of a window has gone out.
+ Each send blocks for the frame's air time, which on a wake-on-radio site
+ includes the wake-up preamble, so a window alone can take longer than
+ the timeout. The caller sets the timeout in begin(), from the air time
+ of its radio. The timer adds a random wait of up to one more timeout, drawn
+ from a sequence seeded with the node ID: neighbours that answer the same
+ beacon start their transfers together, and with equal timers their
+ retries would collide every time.
+
+ Fragments and ACKs go on the air only while the caller's ClearFn says
+ the channel belongs to the transport (the TDMA transfer slots, tdma.h).
+ Whatever it holds back waits in the transport and goes out from poll().
+*/
+
+constexpr uint8_t XFER_DATA_HEADER_LEN = 6;
+constexpr uint8_t XFER_ACK_LEN = 7;
+constexpr uint8_t XFER_FRAGMENT_LEN = MESH_FRAME_MAX_LEN - XFER_DATA_HEADER_LEN;
+constexpr uint8_t XFER_MAX_FRAGMENTS = 32;  // one bit each in the ACK bitmap
+constexpr size_t XFER_MAX_PAYLOAD = (size_t)XFER_FRAGMENT_LEN * XFER_MAX_FRAGMENTS;
+constexpr uint8_t XFER_WINDOW = 8;          // fragments in flight before an ACK is requested
+constexpr uint8_t XFER_RX_SLOTS = 2;        // concurrent inbound transfers
+constexpr uint8_t XFER_MAX_RETRIES = 5;
+constexpr unsigned long XFER_ACK_TIMEOUT = 4000;   // default; the receiver may finish a 2 s send of its own before its ACK
+constexpr unsigned long XFER_RX_TIMEOUT = 30000;   // an idle reassembly slot is reclaimed after this
+
+constexpr uint8_t XFER_FLAG_ACK_REQ = 0x01;
+constexpr uint8_t XFER_BROADCAST = 0xFF;
+
+struct TransportStats {
+    uint32_t framesSent;
+    uint32_t retransmits;
+    uint32_t acksSent;
+    uint32_t transfersSent;
+    uint32_t transfersFailed;
+    uint32_t transfersReceived;
+    uint32_t rxDropped;      // fragments rejected (bad header or no free slot)
+};
+
+class FragmentTransport {
+public:
+    // Puts one frame on the air; returns false if the radio refused it.
+    typedef bool (*SendFrameFn)(const uint8_t* frame, uint8_t len);
+    // Called once per completely reassembled payload.
+    typedef void (*DeliverFn)(uint8_t from, const uint8_t* data, size_t len);
+    // Called when an outbound transfer finishes, successfully or not.
+    typedef void (*CompleteFn)(uint8_t dest, bool ok);
+    // Current time in ms, read after a window has been sent; without it the ACK timer starts at now.
+    typedef unsigned long (*ClockFn)();
+    // True while a transport frame may go on the air; without it frames go out at once.
+    typedef bool (*ClearFn)();
+
+    FragmentTransport(SendFrameFn sendFrame, DeliverFn deliver, CompleteFn complete = nullptr,
+                      ClockFn clock = nullptr, ClearFn clear = nullptr);
+
+    /**
+     * @brief Sets the node ID used to filter inbound fragments.
+     *
+     * @param ackTimeoutMs Wait for an ACK after the last fragment of a window,
+     *        before the random part.
+     * @param bootSeed Transfer IDs count on from here; pass a value that differs
+     *        per boot, so a receiver still holding a transfer from before a
+     *        reboot does not take a new one for a retransmission of it.
+     */
+    void begin(uint8_t selfId, unsigned long ackTimeoutMs = XFER_ACK_TIMEOUT, uint8_t bootSeed = 0);
+
+    /**
+     * @brief Starts an outbound transfer.
+     *
+     * The payload is copied, so the caller's buffer may be reused at once.
+     *
+     * @return false if a transfer is already running or the payload is
+     *         empty or larger than XFER_MAX_PAYLOAD.
+     */
+    bool send(uint8_t dest, const uint8_t* data, size_t len, unsigned long now);
+
+    /**
+     * @brief Returns true while an outbound transfer is in progress.
+     */
+    bool busy() const { return txState != TX_IDLE; }
+
+    /**
+     * @brief Returns true while fragments or ACKs wait for the channel.
+     *
+     * The caller should poll() as soon as its ClearFn opens again.
+     */
+    bool waiting() const;
+
+    /**
+     * @brief Sends frames held back for the channel and drives retransmission
+     *        timers; call regularly from the LoRa task.
+     */
+    void poll(unsigned long now);
+
+    /**
+     * @brief Feeds a received MSG_XFER_DATA or MSG_XFER_ACK frame.
+     */
+    void onFrame(uint8_t from, const uint8_t* frame, uint8_t len, unsigned long now);
+
+    const TransportStats& stats() const { return counters; }
+
+private:
+    enum TxState : uint8_t { TX_IDLE, TX_SEND_WINDOW, TX_WAIT_ACK };
+
+    struct RxSlot {
+        bool inUse;
+        bool delivered;
+        bool ackDue;         // asked for while the channel was not clear
+        uint8_t from;
+        uint8_t xferId;
+        uint8_t total;
+        uint32_t received;   // bitmap of stored fragments
+        size_t length;       // known once the last fragment arrives
+        unsigned long lastActivity;
+        uint8_t data[XFER_MAX_PAYLOAD];
+    };
+
+    void startWindow(unsigned long now);
+    void sendQueued(unsigned long now);
+    void finishTx(bool ok);
+    void handleData(uint8_t from, const uint8_t* frame, uint8_t len, unsigned long now);
+    void handleAck(uint8_t from, const uint8_t* frame, uint8_t len, unsigned long now);
+    void sendAck(RxSlot& slot);
+    RxSlot* findSlot(uint8_t from, uint8_t xferId, unsigned long now);
+
+    static uint32_t fullMask(uint8_t total) {
+        return total >= 32 ? 0xFFFFFFFFUL : ((1UL << total) - 1);
+    }
+
+    SendFrameFn sendFrame;
+    DeliverFn deliver;
+    CompleteFn complete;
+    ClockFn clock;
+    ClearFn clear;
+    uint8_t selfId;
+    unsigned long ackTimeout;
+    uint32_t jitterState;   // linear congruential sequence for the ACK timer jitter
+
+    TxState txState;
+    uint8_t txDest;
+    uint8_t txId;
+    uint8_t txTotal;
+    uint8_t txRetries;
+    uint32_t txAcked;
+    uint32_t txSent;     // fragments put on the air at least once
+    uint32_t txQueue;    // fragments of the current window still to go out
+    uint8_t txLast;      // last fragment of the current window, which asks for the ACK
+    size_t txLength;
+    unsigned long txDeadline;
+    uint8_t txData[XFER_MAX_PAYLOAD];
+
+    RxSlot rxSlots[XFER_RX_SLOTS];
+    TransportStats counters;
+};
+
+#endif // TRANSPORT_H
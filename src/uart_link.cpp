@@ -0,0 +1,139 @@
+/*
+ Project Name ------  FRS
+ Task --------------  Escalator Node Firmware with Esp32
+ Engineer ----------- Muhammad Usman
+ File --------------- UART Link Source File
+ Company -----------  Machadev Pvt Limited
+ */
+
+// Import Libraries
+#include "uart_link.h"
+#include <string.h>
+
+UartLink::UartLink(uart_port_t port) : port(port), events(nullptr), task(nullptr), peeked(-1), frameEnd(nullptr) {
+    memset(&counters, 0, sizeof(counters));
+}
+
+// Installs the driver with an RX ring and event queue, then starts the event task.
+bool UartLink::begin(uint32_t baud, int rxPin, int txPin) {
+    uart_config_t config = {};
+    config.baud_rate = (int)baud;
+    config.data_bits = UART_DATA_8_BITS;
+    config.parity = UART_PARITY_DISABLE;
+    config.stop_bits = UART_STOP_BITS_1;
+    config.flow_ctrl = UART_HW_FLOWCTRL_DISABLE;
+    config.source_clk = UART_SCLK_APB;
+
+    // No TX ring: writes block until the bytes are in the FIFO, as they did on HardwareSerial
+    if (uart_driver_install(port, UART_LINK_RX_RING, 0, UART_LINK_EVENT_QUEUE, &events, 0) != ESP_OK) {
+        return false;
+    }
+    if (uart_param_config(port, &config) != ESP_OK ||
+        uart_set_pin(port, txPin, rxPin, UART_PIN_NO_CHANGE, UART_PIN_NO_CHANGE) != ESP_OK ||
+        uart_set_rx_timeout(port, UART_LINK_FRAME_GAP) != ESP_OK) {
+        uart_driver_delete(port);
+        return false;
+    }
+    return xTaskCreatePinnedToCore(eventTask, "uartLink", 2048, this, UART_LINK_TASK_PRIORITY, &task,
+                                   tskNO_AFFINITY) == pdPASS;
+}
+
+void UartLink::eventTask(void* parameter) {
+    UartLink* link = (UartLink*)parameter;
+    uart_event_t event;
+    for (;;) {
+        if (xQueueReceive(link->events, &event, portMAX_DELAY) == pdTRUE) {
+            link->handleEvent(event);
+        }
+    }
+}
+
+// Counts one driver event; an overflow flushes the ring, as the driver requires.
+void UartLink::handleEvent(const uart_event_t& event) {
+    switch (event.type) {
+        case UART_DATA: {
+            counters.rxBytes += event.size;
+            if (event.timeout_flag) {
+                counters.frames++;
+                if (frameEnd != nullptr) frameEnd();
+            }
+            size_t waiting = 0;
+            if (uart_get_buffered_data_len(port, &waiting) == ESP_OK && waiting > counters.ringPeak) {
+                counters.ringPeak = waiting;
+            }
+            break;
+        }
+        case UART_FIFO_OVF:
+        case UART_BUFFER_FULL:
+            if (event.type == UART_FIFO_OVF) {
+                counters.fifoOverflows++;
+            } else {
+                counters.ringOverflows++;
+            }
+            uart_flush_input(port);
+            xQueueReset(events);
+            break;
+        case UART_FRAME_ERR:
+            counters.frameErrors++;
+            break;
+        case UART_PARITY_ERR:
+            counters.parityErrors++;
+            break;
+        case UART_BREAK:
+            counters.breaks++;
+            break;
+        default:
+            break;
+    }
+}
+
+int UartLink::available() {
+    size_t waiting = 0;
+    uart_get_buffered_data_len(port, &waiting);
+    return (int)waiting + (peeked >= 0 ? 1 : 0);
+}
+
+int UartLink::read() {
+    if (peeked >= 0) {
+        int c = peeked;
+        peeked = -1;
+        return c;
+    }
+    uint8_t c;
+    return uart_read_bytes(port, &c, 1, 0) == 1 ? c : -1;
+}
+
+int UartLink::peek() {
+    if (peeked < 0) {
+        peeked = read();
+    }
+    return peeked;
+}
+
+void UartLink::flush() {
+    uart_wait_tx_done(port, portMAX_DELAY);
+}
+
+size_t UartLink::write(uint8_t c) {
+    return write(&c, 1);
+}
+
+size_t UartLink::write(const uint8_t* buffer, size_t size) {
+    int written = uart_write_bytes(port, (const char*)buffer, size);
+    return written < 0 ? 0 : (size_t)written;
+}
+
+size_t UartLink::readTimeout(uint8_t* buffer, size_t len, uint32_t timeoutMs) {
+    size_t got = 0;
+    if (len > 0 && peeked >= 0) {
+        buffer[got++] = (uint8_t)peeked;
+        peeked = -1;
+    }
+    int n = uart_read_bytes(port, buffer + got, len - got, pdMS_TO_TICKS(timeoutMs));
+    return n > 0 ? got + (size_t)n : got;
+}
+
+void UartLink::discardInput() {
+    peeked = -1;
+    uart_flush_input(port);
+}
@@ -0,0 +1,95 @@
+/*
+ Project Name ------  FRS
+ Task --------------  Escalator Node Firmware with Esp32
+ Engineer ----------- Muhammad Usman
+ File --------------- UART Link Header File
+ Company -----------  Machadev Pvt Limited
+ */
+
+// uart_link.h
+#ifndef UART_LINK_H
+#define UART_LINK_H
+
+#include <Arduino.h>
+#include <driver/uart.h>
+#include <freertos/queue.h>
+
+/*
+ Stream for RH_E32 on the ESP-IDF UART driver instead of HardwareSerial.
+
+ The driver's RX interrupt empties the 128 byte hardware FIFO into a
+ UART_LINK_RX_RING byte ring, so reception goes on while LoRatask, the
+ only task that reads the radio, is printing, sending or writing flash,
+ and while loop() serves HTTP on the same core. A small
+ event task drains the driver's event queue: it counts the bytes, the
+ frames and the errors, and recovers from an overflow by flushing the
+ ring.
+
+ The E32 sends a received packet as one burst of bytes and then goes
+ quiet, so the driver's RX timeout (UART_LINK_FRAME_GAP symbols of
+ silence) marks the end of a frame. The boundary is only counted:
+ RH_E32 frames packets by their own length byte, and holding bytes back
+ until the gap would add about 10 ms to every packet and command reply.
+*/
+
+constexpr size_t UART_LINK_RX_RING = 4096;       // about 4 s of traffic at 9600 baud
+constexpr uint8_t UART_LINK_EVENT_QUEUE = 20;
+constexpr uint8_t UART_LINK_FRAME_GAP = 10;      // symbols of silence that end a frame
+constexpr uint8_t UART_LINK_TASK_PRIORITY = 12;  // above the LoRa task and loop()
+
+struct UartLinkStats {
+    uint32_t rxBytes;
+    uint32_t frames;          // bursts ended by the RX timeout
+    uint32_t fifoOverflows;   // hardware FIFO filled before the interrupt ran
+    uint32_t ringOverflows;   // ring filled because nobody read it
+    uint32_t frameErrors;
+    uint32_t parityErrors;
+    uint32_t breaks;
+    size_t ringPeak;          // most bytes ever waiting in the ring
+};
+
+class UartLink : public Stream {
+public:
+    explicit UartLink(uart_port_t port);
+
+    /**
+     * @brief Installs the UART driver, routes the pins and starts the event task.
+     *
+     * @return false if the driver could not be installed or configured.
+     */
+    bool begin(uint32_t baud, int rxPin, int txPin);
+
+    int available() override;
+    int read() override;
+    int peek() override;
+    void flush() override;   // waits until the TX FIFO is empty, like HardwareSerial
+
+    using Print::write;
+    size_t write(uint8_t c) override;
+    size_t write(const uint8_t* buffer, size_t size) override;
+
+    // Reads up to len bytes, waiting at most timeoutMs; for the E32's command replies.
+    size_t readTimeout(uint8_t* buffer, size_t len, uint32_t timeoutMs);
+
+    // Drops everything received so far.
+    void discardInput();
+
+    // Called from the event task at each frame boundary; set before begin().
+    void onFrameEnd(void (*callback)()) { frameEnd = callback; }
+
+    // Counters are only written by the event task; each field reads atomically.
+    UartLinkStats stats() const { return counters; }
+
+private:
+    static void eventTask(void* parameter);
+    void handleEvent(const uart_event_t& event);
+
+    uart_port_t port;
+    QueueHandle_t events;
+    TaskHandle_t task;
+    int peeked;   // byte taken out of the ring by peek(), -1 if none
+    void (*frameEnd)();
+    UartLinkStats counters;
+};
+
+#endif // UART_LINK_H
@@ -0,0 +1,173 @@
+/*
+ Project Name ------  FRS
+ Task --------------  Escalator Node Firmware with Esp32
+ Engineer ----------- Muhammad Usman
+ File --------------- Config Sync Test File
+ Company -----------  Machadev Pvt Limited
+ */
+
+// Runs on the host: pio test -e native -f test_config_sync
+#include <unity.h>
+#include <string.h>
+#include "config_sync.h"
+#include "protocol.h"
+
+static int changes;
+static ConfigField lastChanged;
+
+static void countChange(ConfigField field) {
+    changes++;
+    lastChanged = field;
+}
+
+void setUp() {
+    changes = 0;
+    lastChanged = CFG_FIELD_COUNT;
+}
+
+void tearDown() {}
+
+// Appends one delta entry; returns the new length.
+static size_t addEntry(uint8_t* delta, size_t len, uint8_t field, uint16_t counter, uint8_t writer,
+                       const char* value) {
+    size_t valueLen = strlen(value);
+    uint8_t* p = delta + len;
+    p[0] = field;
+    p[1] = (uint8_t)counter;
+    p[2] = (uint8_t)(counter >> 8);
+    p[3] = writer;
+    p[4] = (uint8_t)valueLen;
+    memcpy(p + 5, value, valueLen);
+    delta[1]++;
+    return len + 5 + valueLen;
+}
+
+static size_t startDelta(uint8_t* delta) {
+    delta[0] = MSG_SYNC_DELTA;
+    delta[1] = 0;
+    return 2;
+}
+
+// A delta built from a peer's vector brings it level with the sender.
+static void test_delta_round_trip() {
+    ConfigStore a, b;
+    a.begin(1);
+    b.begin(2, countChange);
+    a.set(CFG_COMPANY_NAME, "Machadev");
+    a.set(CFG_FIRE_DEPARTMENT, "Station 9");
+
+    uint8_t vector[CONFIG_VECTOR_LEN];
+    TEST_ASSERT_EQUAL_size_t(CONFIG_VECTOR_LEN, b.encodeVector(vector, sizeof(vector)));
+    TEST_ASSERT_FALSE(b.peerHasNewer(vector, sizeof(vector)));
+    uint8_t delta[MESH_FRAME_MAX_LEN * 4];
+    size_t len = a.encodeDelta(vector, sizeof(vector), delta, sizeof(delta));
+    TEST_ASSERT_TRUE(len > 0);
+
+    TEST_ASSERT_EQUAL_INT(2, b.applyDelta(delta, len));
+    TEST_ASSERT_EQUAL_INT(2, changes);
+    TEST_ASSERT_EQUAL_STRING("Machadev", b.get(CFG_COMPANY_NAME));
+    TEST_ASSERT_EQUAL_STRING("Station 9", b.get(CFG_FIRE_DEPARTMENT));
+    TEST_ASSERT_EQUAL_UINT32(a.digest(), b.digest());
+}
+
+// Equal counters go to the higher writer ID, whichever store receives the delta.
+static void test_counter_tie_goes_to_higher_writer() {
+    ConfigStore low, high;
+    low.begin(3);
+    high.begin(5);
+    low.set(CFG_KEY_PERSON, "Ali");
+    high.set(CFG_KEY_PERSON, "Sara");
+
+    uint8_t delta[64];
+    size_t len = addEntry(delta, startDelta(delta), CFG_KEY_PERSON, 1, 3, "Ali");
+    TEST_ASSERT_EQUAL_INT(0, high.applyDelta(delta, len));
+    TEST_ASSERT_EQUAL_STRING("Sara", high.get(CFG_KEY_PERSON));
+
+    len = addEntry(delta, startDelta(delta), CFG_KEY_PERSON, 1, 5, "Sara");
+    TEST_ASSERT_EQUAL_INT(1, low.applyDelta(delta, len));
+    TEST_ASSERT_EQUAL_STRING("Sara", low.get(CFG_KEY_PERSON));
+    TEST_ASSERT_EQUAL_UINT8(5, low.version(CFG_KEY_PERSON).writer);
+
+    // The same entry again changes nothing
+    TEST_ASSERT_EQUAL_INT(0, low.applyDelta(delta, len));
+    TEST_ASSERT_EQUAL_UINT32(high.digest(), low.digest());
+}
+
+// A higher counter wins over a higher writer ID, and an older counter is ignored.
+static void test_higher_counter_wins() {
+    ConfigStore s;
+    s.begin(9, countChange);
+    s.set(CFG_UNIT_NUMBER, "A1");
+    s.set(CFG_UNIT_NUMBER, "A2");   // counter 2, writer 9
+
+    uint8_t delta[64];
+    size_t len = addEntry(delta, startDelta(delta), CFG_UNIT_NUMBER, 1, 200, "old");
+    TEST_ASSERT_EQUAL_INT(0, s.applyDelta(delta, len));
+    len = addEntry(delta, startDelta(delta), CFG_UNIT_NUMBER, 3, 1, "A3");
+    TEST_ASSERT_EQUAL_INT(1, s.applyDelta(delta, len));
+    TEST_ASSERT_EQUAL_STRING("A3", s.get(CFG_UNIT_NUMBER));
+    TEST_ASSERT_EQUAL_INT(1, changes);
+    TEST_ASSERT_EQUAL(CFG_UNIT_NUMBER, lastChanged);
+}
+
+// Fields this firmware does not know are skipped, and the rest still merges.
+static void test_unknown_field_skipped() {
+    ConfigStore s;
+    s.begin(1, countChange);
+    uint8_t delta[64];
+    size_t len = startDelta(delta);
+    len = addEntry(delta, len, CFG_FIELD_COUNT + 4, 7, 2, "future");
+    len = addEntry(delta, len, CFG_MFR_NAME, 1, 2, "Acme");
+
+    TEST_ASSERT_EQUAL_INT(1, s.applyDelta(delta, len));
+    TEST_ASSERT_EQUAL_INT(1, changes);
+    TEST_ASSERT_EQUAL_STRING("Acme", s.get(CFG_MFR_NAME));
+}
+
+// A delta cut short, even after well-formed entries, is rejected whole.
+static void test_truncated_delta_changes_nothing() {
+    ConfigStore s;
+    s.begin(1, countChange);
+    s.set(CFG_COMPANY_NAME, "Before");
+    uint32_t before = s.digest();
+
+    uint8_t delta[64];
+    size_t len = startDelta(delta);
+    len = addEntry(delta, len, CFG_COMPANY_NAME, 5, 2, "After");
+    size_t full = addEntry(delta, len, CFG_COMPANY_ADDRESS, 5, 2, "Street 1");
+
+    TEST_ASSERT_EQUAL_INT(-1, s.applyDelta(delta, full - 3));   // value cut short
+    TEST_ASSERT_EQUAL_INT(-1, s.applyDelta(delta, len + 2));    // header cut short
+    delta[1]++;                                                 // count claims an entry that is missing
+    TEST_ASSERT_EQUAL_INT(-1, s.applyDelta(delta, full));
+    TEST_ASSERT_EQUAL_INT(0, changes);
+    TEST_ASSERT_EQUAL_STRING("Before", s.get(CFG_COMPANY_NAME));
+    TEST_ASSERT_EQUAL_UINT32(before, s.digest());
+
+    delta[1]--;
+    TEST_ASSERT_EQUAL_INT(2, s.applyDelta(delta, full));
+    TEST_ASSERT_EQUAL_STRING("Street 1", s.get(CFG_COMPANY_ADDRESS));
+}
+
+// Values too long for a field and frames of another type are malformed.
+static void test_rejects_bad_delta() {
+    ConfigStore s;
+    s.begin(1);
+    uint8_t delta[5 + CONFIG_VALUE_MAX + 2] = { MSG_SYNC_DELTA, 1, CFG_COMPANY_NAME, 1, 0, 2, CONFIG_VALUE_MAX };
+    TEST_ASSERT_EQUAL_INT(-1, s.applyDelta(delta, sizeof(delta)));
+    delta[0] = MSG_SYNC_VECTOR;
+    TEST_ASSERT_EQUAL_INT(-1, s.applyDelta(delta, sizeof(delta)));
+    TEST_ASSERT_EQUAL_INT(-1, s.applyDelta(delta, 1));
+    TEST_ASSERT_EQUAL_UINT16(0, s.version(CFG_COMPANY_NAME).counter);
+}
+
+int main() {
+    UNITY_BEGIN();
+    RUN_TEST(test_delta_round_trip);
+    RUN_TEST(test_counter_tie_goes_to_higher_writer);
+    RUN_TEST(test_higher_counter_wins);
+    RUN_TEST(test_unknown_field_skipped);
+    RUN_TEST(test_truncated_delta_changes_nothing);
+    RUN_TEST(test_rejects_bad_delta);
+    return UNITY_END();
+}
@@ -0,0 +1,103 @@
+/*
+ Project Name ------  FRS
+ Task --------------  Escalator Node Firmware with Esp32
+ Engineer ----------- Muhammad Usman
+ File --------------- Frame Pool Test File
+ Company -----------  Machadev Pvt Limited
+ */
+
+// Runs on the host: pio test -e native -f test_frame_pool
+#include <unity.h>
+#include "frame_pool.h"
+
+void setUp() {}
+
+void tearDown() {}
+
+// Receives one frame into the log, as listenForNodes() does; returns it, or an empty ref on backpressure.
+static FrameRef receive(FrameLog& log, uint32_t seq) {
+    FrameRef frame = log.acquire();
+    if (frame) {
+        frame->seq = seq;
+        log.add(frame);
+    }
+    return frame;
+}
+
+// The last reference returns a buffer to the pool.
+static void test_refs_return_buffer() {
+    FramePool pool;
+    FrameRef a(pool, pool.acquire());
+    FrameRef b = a;
+    TEST_ASSERT_EQUAL_UINT8(1, pool.stats().inUse);
+    a.reset();
+    TEST_ASSERT_EQUAL_UINT8(1, pool.stats().inUse);
+    b.reset();
+    TEST_ASSERT_EQUAL_UINT8(0, pool.stats().inUse);
+    TEST_ASSERT_EQUAL_UINT8(1, pool.stats().highWater);
+}
+
+// With the log full and the other task receiving, the next frame drops the oldest logged one.
+static void test_log_gives_up_oldest() {
+    FramePool pool;
+    FrameLog log(pool);
+    for (uint32_t seq = 1; seq <= FRAME_LOG_LEN; seq++) {
+        receive(log, seq);
+    }
+    FrameRef other(pool, pool.acquire());
+    TEST_ASSERT_EQUAL_UINT8(FRAME_POOL_SIZE, pool.stats().inUse);
+    TEST_ASSERT_EQUAL_UINT32(0, log.evicted());
+
+    TEST_ASSERT_TRUE(receive(log, FRAME_LOG_LEN + 1));
+    TEST_ASSERT_EQUAL_UINT32(1, log.evicted());
+    TEST_ASSERT_EQUAL_UINT32(0, pool.stats().exhausted);
+
+    FrameRef frames[FRAME_LOG_LEN];
+    log.copy(frames);
+    TEST_ASSERT_EQUAL_UINT32(2, frames[0]->seq);
+    TEST_ASSERT_EQUAL_UINT32(FRAME_LOG_LEN + 1, frames[FRAME_LOG_LEN - 1]->seq);
+}
+
+// Logged frames a /frames snapshot still holds free nothing; the log drops on until one does.
+static void test_snapshot_frames_skipped() {
+    FramePool pool;
+    FrameLog log(pool);
+    for (uint32_t seq = 1; seq <= FRAME_LOG_LEN; seq++) {
+        receive(log, seq);
+    }
+    FrameRef snapshot[FRAME_LOG_LEN];
+    log.copy(snapshot);
+
+    TEST_ASSERT_TRUE(receive(log, 7));   // the one free buffer
+    TEST_ASSERT_TRUE(receive(log, 8));   // drops 2..6, all shared, then 7
+    TEST_ASSERT_EQUAL_UINT32(FRAME_LOG_LEN, log.evicted());
+    TEST_ASSERT_EQUAL_UINT32(0, pool.stats().exhausted);
+}
+
+// Once the frames held outside the log fill the pool, the receiver is told to back off.
+static void test_backpressure_when_pool_full() {
+    FramePool pool;
+    FrameLog log(pool);
+    FrameRef held[FRAME_POOL_SIZE];
+    for (uint8_t i = 0; i < FRAME_POOL_SIZE; i++) {
+        held[i] = receive(log, i + 1);
+        TEST_ASSERT_TRUE(held[i]);
+    }
+    // The log shares every buffer it still has with a holder, so dropping frees nothing
+    TEST_ASSERT_FALSE(log.acquire());
+    TEST_ASSERT_EQUAL_UINT32(1, pool.stats().exhausted);
+
+    held[0].reset();
+    held[3].reset();
+    TEST_ASSERT_TRUE(receive(log, 100));
+    TEST_ASSERT_EQUAL_UINT32(1, pool.stats().exhausted);
+}
+
+int main() {
+    UNITY_BEGIN();
+    RUN_TEST(test_refs_return_buffer);
+    RUN_TEST(test_log_gives_up_oldest);
+    RUN_TEST(test_snapshot_frames_skipped);
+    RUN_TEST(test_backpressure_when_pool_full);
+    return UNITY_END();
+}
@@ -0,0 +1,193 @@
+/*
+ Project Name ------  FRS
+ Task --------------  Escalator Node Firmware with Esp32
+ Engineer ----------- Muhammad Usman
+ File --------------- Event Journal Test File
+ Company -----------  Machadev Pvt Limited
+ */
+
+// Runs on the host: pio test -e native -f test_journal
+// The "journal" partition is the host's RAM buffer (tools/host/esp_partition.cpp),
+// which keeps its contents across EventJournal instances like flash across a reboot.
+#include <unity.h>
+#include <string.h>
+#include "journal.h"
+
+static constexpr uint32_t R = JOURNAL_RECORDS_PER_SECTOR;
+static constexpr uint32_t T0 = 100000;   // network time of record 0; record n is T0 + n
+
+static const esp_partition_t* flash() {
+    return esp_partition_find_first(ESP_PARTITION_TYPE_DATA, ESP_PARTITION_SUBTYPE_ANY, "journal");
+}
+
+static uint32_t sectors() {
+    return flash()->size / JOURNAL_SECTOR_SIZE;
+}
+
+void setUp() {
+    memset(flash()->data, 0xFF, flash()->size);
+}
+
+void tearDown() {}
+
+static void appendRecords(EventJournal& journal, uint32_t count) {
+    for (uint32_t i = 0; i < count; i++) {
+        uint32_t seq = journal.end();
+        TEST_ASSERT_TRUE(journal.append(JOURNAL_NODE_DEAD, (uint8_t)seq, 0, T0 + seq, seq));
+    }
+}
+
+static void assertRecord(const EventJournal& journal, uint32_t seq) {
+    JournalRecord record;
+    TEST_ASSERT_TRUE(journal.read(seq, &record));
+    TEST_ASSERT_EQUAL_UINT32(seq, record.seq);
+    TEST_ASSERT_EQUAL_UINT32(T0 + seq, record.time);
+    TEST_ASSERT_EQUAL_UINT8((uint8_t)seq, record.node);
+}
+
+// An erased partition is formatted and starts at sequence 0.
+static void test_empty_partition_starts_at_zero() {
+    EventJournal journal;
+    TEST_ASSERT_TRUE(journal.begin());
+    TEST_ASSERT_EQUAL_UINT32(0, journal.oldest());
+    TEST_ASSERT_EQUAL_UINT32(0, journal.end());
+
+    appendRecords(journal, 3);
+    assertRecord(journal, 0);
+    assertRecord(journal, 2);
+    JournalRecord record;
+    TEST_ASSERT_FALSE(journal.read(3, &record));
+}
+
+// A full ring erases its oldest sector, and exactly that sector's records are gone.
+static void test_wrap_drops_oldest_sector() {
+    EventJournal journal;
+    TEST_ASSERT_TRUE(journal.begin());
+    uint32_t capacity = sectors() * R;
+    appendRecords(journal, capacity);
+    TEST_ASSERT_EQUAL_UINT32(0, journal.oldest());
+
+    appendRecords(journal, 10);
+    TEST_ASSERT_EQUAL_UINT32(R, journal.oldest());
+    TEST_ASSERT_EQUAL_UINT32(capacity + 10, journal.end());
+    JournalRecord record;
+    TEST_ASSERT_FALSE(journal.read(R - 1, &record));
+    assertRecord(journal, R);
+    assertRecord(journal, capacity - 1);
+    assertRecord(journal, capacity + 9);
+    TEST_ASSERT_FALSE(journal.read(capacity + 10, &record));
+}
+
+// After a reboot the ring, its head and every readable record are where they were.
+static void test_reboot_recovers_wrapped_ring() {
+    uint32_t total = sectors() * R * 2 + 37;   // around the ring twice and into a sector
+    uint32_t oldest;
+    {
+        EventJournal journal;
+        TEST_ASSERT_TRUE(journal.begin());
+        appendRecords(journal, total);
+        oldest = journal.oldest();
+    }
+
+    EventJournal rebooted;
+    TEST_ASSERT_TRUE(rebooted.begin());
+    TEST_ASSERT_EQUAL_UINT32(oldest, rebooted.oldest());
+    TEST_ASSERT_EQUAL_UINT32(total, rebooted.end());
+    assertRecord(rebooted, oldest);
+    assertRecord(rebooted, total - 1);
+
+    appendRecords(rebooted, 1);
+    assertRecord(rebooted, total);
+}
+
+// A record torn by a power cut fails its check; its slot stays spent after the reboot.
+static void test_torn_record_spends_its_slot() {
+    uint32_t torn;
+    {
+        EventJournal journal;
+        TEST_ASSERT_TRUE(journal.begin());
+        appendRecords(journal, 5);
+        torn = journal.end();
+
+        // Only the first half of the record reached flash
+        JournalRecord record = { torn, T0 + torn, torn, JOURNAL_NODE_DEAD, 0, 0, 0 };
+        size_t offset = (torn + 1) * sizeof(JournalRecord);   // sector 0, after its header
+        TEST_ASSERT_EQUAL_INT(ESP_OK, esp_partition_write(flash(), offset, &record, sizeof(record) / 2));
+    }
+
+    EventJournal rebooted;
+    TEST_ASSERT_TRUE(rebooted.begin());
+    TEST_ASSERT_EQUAL_UINT32(torn + 1, rebooted.end());
+    JournalRecord record;
+    TEST_ASSERT_FALSE(rebooted.read(torn, &record));
+    assertRecord(rebooted, torn - 1);
+
+    appendRecords(rebooted, 1);
+    assertRecord(rebooted, torn + 1);
+}
+
+// A power cut between erasing the oldest sector for reuse and writing its header keeps the rest of the ring.
+static void test_reboot_after_interrupted_sector_start() {
+    uint32_t capacity = sectors() * R;
+    {
+        EventJournal journal;
+        TEST_ASSERT_TRUE(journal.begin());
+        appendRecords(journal, capacity);
+        TEST_ASSERT_EQUAL_INT(ESP_OK, esp_partition_erase_range(flash(), 0, JOURNAL_SECTOR_SIZE));
+    }
+
+    EventJournal rebooted;
+    TEST_ASSERT_TRUE(rebooted.begin());
+    TEST_ASSERT_EQUAL_UINT32(R, rebooted.oldest());
+    TEST_ASSERT_EQUAL_UINT32(capacity, rebooted.end());
+    assertRecord(rebooted, R);
+    appendRecords(rebooted, 1);
+    assertRecord(rebooted, capacity);
+    assertRecord(rebooted, capacity - 1);
+}
+
+// seekTime() skips whole sectors outside the range, before and after a reboot.
+static void test_seek_time_skips_sectors() {
+    EventJournal journal;
+    TEST_ASSERT_TRUE(journal.begin());
+    appendRecords(journal, 3 * R);
+
+    for (int boot = 0; boot < 2; boot++) {
+        // A time in the third sector starts at that sector's first record
+        TEST_ASSERT_EQUAL_UINT32(2 * R, journal.seekTime(0, T0 + 2 * R + 5, T0 + 2 * R + 5));
+        // A range that starts in the first sector starts at the given record
+        TEST_ASSERT_EQUAL_UINT32(7, journal.seekTime(7, T0 + R - 1, T0 + R));
+        // A sector whose records all miss the range is skipped
+        TEST_ASSERT_EQUAL_UINT32(R, journal.seekTime(3, T0 + R, T0 + 2 * R));
+        // Ranges before and after every record find nothing
+        TEST_ASSERT_EQUAL_UINT32(journal.end(), journal.seekTime(0, 0, T0 - 1));
+        TEST_ASSERT_EQUAL_UINT32(journal.end(), journal.seekTime(0, T0 + 3 * R, 0xFFFFFFFF));
+
+        journal = EventJournal();   // the time index is rebuilt from flash
+        TEST_ASSERT_TRUE(journal.begin());
+    }
+}
+
+// A seek from before the oldest record starts at the oldest once the ring has wrapped.
+static void test_seek_time_after_wrap() {
+    EventJournal journal;
+    TEST_ASSERT_TRUE(journal.begin());
+    appendRecords(journal, sectors() * R + 1);
+    uint32_t oldest = journal.oldest();
+
+    TEST_ASSERT_EQUAL_UINT32(oldest, journal.seekTime(0, 0, 0xFFFFFFFF));
+    TEST_ASSERT_EQUAL_UINT32(journal.end() - 1, journal.seekTime(0, T0 + journal.end() - 1, 0xFFFFFFFF));
+    TEST_ASSERT_EQUAL_UINT32(journal.end(), journal.seekTime(0, 0, T0 + oldest - 1));
+}
+
+int main() {
+    UNITY_BEGIN();
+    RUN_TEST(test_empty_partition_starts_at_zero);
+    RUN_TEST(test_wrap_drops_oldest_sector);
+    RUN_TEST(test_reboot_recovers_wrapped_ring);
+    RUN_TEST(test_torn_record_spends_its_slot);
+    RUN_TEST(test_reboot_after_interrupted_sector_start);
+    RUN_TEST(test_seek_time_skips_sectors);
+    RUN_TEST(test_seek_time_after_wrap);
+    return UNITY_END();
+}
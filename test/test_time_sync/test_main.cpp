@@ -0,0 +1,149 @@
+/*
+ Project Name ------  FRS
+ Task --------------  Escalator Node Firmware with Esp32
+ Engineer ----------- Muhammad Usman
+ File --------------- Time Sync Test File
+ Company -----------  Machadev Pvt Limited
+ */
+
+// Runs on the host: pio test -e native -f test_time_sync
+#include <unity.h>
+#include "time_sync.h"
+
+// Each node's millis() is the shared virtual time plus its own boot offset.
+struct Node {
+    uint8_t id;
+    uint32_t bootOffset;
+    TimeSync sync;
+
+    uint32_t local(uint32_t now) const { return now + bootOffset; }
+};
+
+void setUp() {}
+
+void tearDown() {}
+
+static void boot(Node& node, uint32_t now) {
+    node.sync.begin(node.id, node.local(now));
+}
+
+// Delivers one beacon from tx to rx, sent at now and received a link delay later.
+static bool beacon(Node& tx, Node& rx, uint32_t now) {
+    uint8_t field[TIME_SYNC_LEN];
+    tx.sync.fill(field, tx.local(now));
+    uint32_t rxAt = rx.local(now + TIME_SYNC_LINK_DELAY_MS);
+    rx.sync.poll(rxAt);
+    return rx.sync.onBeacon(tx.id, field, rxAt);
+}
+
+// Network time of both nodes at the same instant; the difference must lie within the claimed bound.
+static void assertSameTime(Node& a, Node& b, uint32_t now) {
+    uint32_t ta = a.sync.networkTime(a.local(now));
+    uint32_t tb = b.sync.networkTime(b.local(now));
+    uint32_t diff = ta > tb ? ta - tb : tb - ta;
+    TEST_ASSERT_LESS_OR_EQUAL_UINT32(a.sync.errorBound(a.local(now)) + b.sync.errorBound(b.local(now)) + 1, diff);
+}
+
+// A node that hears no tree starts its own once it has listened long enough, and announces it.
+static void test_lone_node_starts_tree() {
+    Node a = { 2, 1000, TimeSync() };
+    boot(a, 0);
+    a.sync.poll(a.local(TIME_SYNC_LISTEN_MS - 1));
+    TEST_ASSERT_FALSE(a.sync.synced(a.local(TIME_SYNC_LISTEN_MS - 1), TDMA_MAX_GUARD_MS));
+    TEST_ASSERT_FALSE(a.sync.announcePending());
+
+    a.sync.poll(a.local(TIME_SYNC_LISTEN_MS));
+    TEST_ASSERT_TRUE(a.sync.synced(a.local(TIME_SYNC_LISTEN_MS), TDMA_MAX_GUARD_MS));
+    TEST_ASSERT_TRUE(a.sync.isRoot());
+    TEST_ASSERT_TRUE(a.sync.announcePending());
+}
+
+// Two trees that meet merge into the one with the lower root, down to the far side's children.
+static void test_two_roots_merge_to_lower() {
+    Node a = { 2, 7000, TimeSync() };
+    Node b = { 5, 123456, TimeSync() };
+    Node c = { 7, 40, TimeSync() };
+    boot(a, 0);
+    boot(b, 0);
+    boot(c, 0);
+    uint32_t now = TIME_SYNC_LISTEN_MS;
+    a.sync.poll(a.local(now));
+    b.sync.poll(b.local(now));
+    TEST_ASSERT_TRUE(a.sync.isRoot());
+    TEST_ASSERT_TRUE(b.sync.isRoot());
+
+    // c only hears b, and joins its tree
+    TEST_ASSERT_TRUE(beacon(b, c, now));
+    TEST_ASSERT_EQUAL_UINT8(5, c.sync.root());
+    c.sync.clearAnnounce();
+    b.sync.clearAnnounce();
+    a.sync.clearAnnounce();
+
+    // b then hears a: the lower root wins and b steps onto a's clock
+    now += TDMA_SLOT_MS;
+    TEST_ASSERT_TRUE(beacon(a, b, now));
+    TEST_ASSERT_EQUAL_UINT8(2, b.sync.root());
+    TEST_ASSERT_EQUAL_UINT8(1, b.sync.hops());
+    TEST_ASSERT_TRUE(b.sync.announcePending());
+    assertSameTime(a, b, now);
+
+    // a hears b's first beacon in the new tree and stays root
+    now += TDMA_SLOT_MS;
+    TEST_ASSERT_FALSE(beacon(b, a, now));
+    TEST_ASSERT_TRUE(a.sync.isRoot());
+    TEST_ASSERT_FALSE(a.sync.announcePending());
+
+    // The same beacon takes c along
+    TEST_ASSERT_TRUE(beacon(b, c, now));
+    TEST_ASSERT_EQUAL_UINT8(2, c.sync.root());
+    TEST_ASSERT_EQUAL_UINT8(2, c.sync.hops());
+    TEST_ASSERT_TRUE(c.sync.announcePending());
+    assertSameTime(a, c, now);
+}
+
+// A beacon from a tree with a higher root changes nothing, whichever clock it carries.
+static void test_higher_root_ignored() {
+    Node a = { 3, 0, TimeSync() };
+    Node b = { 9, 55555, TimeSync() };
+    boot(a, 0);
+    boot(b, 0);
+    uint32_t now = TIME_SYNC_LISTEN_MS;
+    a.sync.poll(a.local(now));
+    b.sync.poll(b.local(now));
+    a.sync.clearAnnounce();
+    uint32_t before = a.sync.networkTime(a.local(now + TIME_SYNC_LINK_DELAY_MS));
+
+    TEST_ASSERT_FALSE(beacon(b, a, now));
+    TEST_ASSERT_TRUE(a.sync.isRoot());
+    TEST_ASSERT_FALSE(a.sync.announcePending());
+    TEST_ASSERT_EQUAL_UINT32(before, a.sync.networkTime(a.local(now + TIME_SYNC_LINK_DELAY_MS)));
+}
+
+// Following the parent in the same tree keeps the clock in step without a new announce.
+static void test_parent_beacons_do_not_announce() {
+    Node a = { 2, 0, TimeSync() };
+    Node b = { 4, 999, TimeSync() };
+    boot(a, 0);
+    boot(b, 0);
+    uint32_t now = TIME_SYNC_LISTEN_MS;
+    a.sync.poll(a.local(now));
+    TEST_ASSERT_TRUE(beacon(a, b, now));
+    b.sync.clearAnnounce();
+
+    for (int i = 0; i < 3; i++) {
+        now += TDMA_SUPERFRAME_MS;
+        TEST_ASSERT_TRUE(beacon(a, b, now));
+        TEST_ASSERT_FALSE(b.sync.announcePending());
+        assertSameTime(a, b, now);
+    }
+    TEST_ASSERT_EQUAL_UINT32(1, b.sync.stats().steps);
+}
+
+int main() {
+    UNITY_BEGIN();
+    RUN_TEST(test_lone_node_starts_tree);
+    RUN_TEST(test_two_roots_merge_to_lower);
+    RUN_TEST(test_higher_root_ignored);
+    RUN_TEST(test_parent_beacons_do_not_announce);
+    return UNITY_END();
+}
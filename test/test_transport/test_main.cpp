@@ -0,0 +1,444 @@
+/*
+ Project Name ------  FRS
+ Task --------------  Escalator Node Firmware with Esp32
+ Engineer ----------- Muhammad Usman
+ File --------------- Fragment Transport Test File
+ Company -----------  Machadev Pvt Limited
+ */
+
+// Runs on the host: pio test -e native -f test_transport
+#include <unity.h>
+#include <string.h>
+#include "transport.h"
+
+// Frames the transport under test put on the air, in order.
+struct SentFrame {
+    uint8_t data[MESH_FRAME_MAX_LEN];
+    uint8_t len;
+};
+
+static SentFrame sent[64];
+static int sentCount;
+static bool radioUp;
+static unsigned long clockMs;
+static unsigned long frameAirMs;   // clockMs advances this much per frame put on the air
+static int channelLimit;           // the channel stays clear until this many frames are on the air
+
+static uint8_t delivered[XFER_MAX_PAYLOAD];
+static size_t deliveredLen;
+static int deliveries;
+static int completions;
+static bool lastOk;
+
+static bool captureFrame(const uint8_t* frame, uint8_t len) {
+    if (!radioUp || sentCount >= (int)(sizeof(sent) / sizeof(sent[0]))) {
+        return false;
+    }
+    memcpy(sent[sentCount].data, frame, len);
+    sent[sentCount].len = len;
+    sentCount++;
+    clockMs += frameAirMs;
+    return true;
+}
+
+static unsigned long radioClock() {
+    return clockMs;
+}
+
+static bool channelClear() {
+    return sentCount < channelLimit;
+}
+
+static void captureDelivery(uint8_t, const uint8_t* data, size_t len) {
+    memcpy(delivered, data, len);
+    deliveredLen = len;
+    deliveries++;
+}
+
+static void captureCompletion(uint8_t, bool ok) {
+    completions++;
+    lastOk = ok;
+}
+
+static const uint8_t SENDER = 2;
+static const uint8_t RECEIVER = 7;
+static const unsigned long ACK_WAIT_MAX = 2 * XFER_ACK_TIMEOUT;   // the timeout and at most as much again at random
+
+static uint8_t payload[XFER_MAX_PAYLOAD];
+
+void setUp() {
+    sentCount = 0;
+    radioUp = true;
+    clockMs = 0;
+    frameAirMs = 0;
+    channelLimit = 1000;
+    deliveredLen = 0;
+    deliveries = 0;
+    completions = 0;
+    lastOk = false;
+    for (size_t i = 0; i < sizeof(payload); i++) {
+        payload[i] = (uint8_t)(i * 7 + 1);
+    }
+}
+
+void tearDown() {}
+
+static uint8_t frameSeq(int i) { return sent[i].data[3]; }
+static bool frameAsksAck(int i) { return sent[i].data[5] & XFER_FLAG_ACK_REQ; }
+
+static void ack(FragmentTransport& t, uint8_t xferId, uint32_t bitmap, unsigned long now) {
+    uint8_t frame[XFER_ACK_LEN] = { MSG_XFER_ACK, SENDER, xferId, (uint8_t)bitmap, (uint8_t)(bitmap >> 8),
+                                    (uint8_t)(bitmap >> 16), (uint8_t)(bitmap >> 24) };
+    t.onFrame(RECEIVER, frame, sizeof(frame), now);
+}
+
+// A payload of n fragments goes out as one window of at most XFER_WINDOW,
+// with the ACK request on the last fragment only.
+static void test_send_first_window() {
+    FragmentTransport t(captureFrame, captureDelivery, captureCompletion);
+    t.begin(SENDER);
+    TEST_ASSERT_TRUE(t.send(RECEIVER, payload, XFER_FRAGMENT_LEN * 10, 0));
+    TEST_ASSERT_TRUE(t.busy());
+    TEST_ASSERT_EQUAL_INT(XFER_WINDOW, sentCount);
+    for (int i = 0; i < sentCount; i++) {
+        TEST_ASSERT_EQUAL_UINT8(MSG_XFER_DATA, sent[i].data[0]);
+        TEST_ASSERT_EQUAL_UINT8(RECEIVER, sent[i].data[1]);
+        TEST_ASSERT_EQUAL_UINT8(i, frameSeq(i));
+        TEST_ASSERT_EQUAL_UINT8(10, sent[i].data[4]);
+        TEST_ASSERT_EQUAL(i == sentCount - 1, frameAsksAck(i));
+    }
+    TEST_ASSERT_FALSE(t.send(RECEIVER, payload, 1, 0));   // one transfer at a time
+}
+
+static void test_send_rejects_bad_length() {
+    FragmentTransport t(captureFrame, captureDelivery, captureCompletion);
+    TEST_ASSERT_FALSE(t.send(RECEIVER, payload, 0, 0));
+    TEST_ASSERT_FALSE(t.send(RECEIVER, payload, XFER_MAX_PAYLOAD + 1, 0));
+    TEST_ASSERT_FALSE(t.busy());
+}
+
+// An ACK with holes only brings back the fragments still missing.
+static void test_ack_retransmits_missing_only() {
+    FragmentTransport t(captureFrame, captureDelivery, captureCompletion);
+    t.begin(SENDER);
+    t.send(RECEIVER, payload, XFER_FRAGMENT_LEN * 4, 0);
+    uint8_t xferId = sent[0].data[2];
+    sentCount = 0;
+
+    ack(t, xferId, 0x05, 100);   // fragments 0 and 2 arrived
+    TEST_ASSERT_EQUAL_INT(2, sentCount);
+    TEST_ASSERT_EQUAL_UINT8(1, frameSeq(0));
+    TEST_ASSERT_EQUAL_UINT8(3, frameSeq(1));
+    TEST_ASSERT_TRUE(frameAsksAck(1));
+    TEST_ASSERT_EQUAL_UINT32(2, t.stats().retransmits);
+
+    ack(t, xferId, 0x0A, 200);   // bitmaps merge: 0x05 | 0x0A is complete
+    TEST_ASSERT_FALSE(t.busy());
+    TEST_ASSERT_EQUAL_INT(1, completions);
+    TEST_ASSERT_TRUE(lastOk);
+    TEST_ASSERT_EQUAL_UINT32(1, t.stats().transfersSent);
+}
+
+// ACKs from another node or for another transfer are ignored.
+static void test_ack_for_other_transfer_ignored() {
+    FragmentTransport t(captureFrame, captureDelivery, captureCompletion);
+    t.begin(SENDER);
+    t.send(RECEIVER, payload, XFER_FRAGMENT_LEN * 2, 0);
+    uint8_t xferId = sent[0].data[2];
+
+    ack(t, (uint8_t)(xferId + 1), 0x03, 100);
+    uint8_t frame[XFER_ACK_LEN] = { MSG_XFER_ACK, SENDER, xferId, 0x03, 0, 0, 0 };
+    t.onFrame(RECEIVER + 1, frame, sizeof(frame), 100);
+    TEST_ASSERT_TRUE(t.busy());
+    TEST_ASSERT_EQUAL_INT(0, completions);
+}
+
+// A late or duplicated ACK that adds no fragments does not resend the window
+// or reset the retry count.
+static void test_stale_ack_ignored() {
+    FragmentTransport t(captureFrame, captureDelivery, captureCompletion);
+    t.begin(SENDER);
+    t.send(RECEIVER, payload, XFER_FRAGMENT_LEN * 3, 0);
+    uint8_t xferId = sent[0].data[2];
+    ack(t, xferId, 0x01, 100);
+    TEST_ASSERT_EQUAL_INT(5, sentCount);
+
+    unsigned long now = 100;
+    for (uint8_t retry = 0; retry < XFER_MAX_RETRIES; retry++) {
+        ack(t, xferId, 0x01, now);
+        TEST_ASSERT_EQUAL_INT(5 + 2 * retry, sentCount);
+        now += ACK_WAIT_MAX;
+        t.poll(now);
+    }
+    ack(t, xferId, 0x01, now);
+    now += ACK_WAIT_MAX;
+    t.poll(now);
+    TEST_ASSERT_FALSE(t.busy());
+    TEST_ASSERT_FALSE(lastOk);
+}
+
+// Transfer IDs start from the boot seed, so they do not repeat those of the last boot.
+static void test_transfer_id_follows_boot_seed() {
+    FragmentTransport t(captureFrame, captureDelivery, captureCompletion);
+    t.begin(SENDER, XFER_ACK_TIMEOUT, 0xFF);
+    t.send(RECEIVER, payload, XFER_FRAGMENT_LEN, 0);
+    TEST_ASSERT_EQUAL_UINT8(0x00, sent[0].data[2]);
+
+    FragmentTransport u(captureFrame, captureDelivery, captureCompletion);
+    u.begin(SENDER, XFER_ACK_TIMEOUT, 0x40);
+    u.send(RECEIVER, payload, XFER_FRAGMENT_LEN, 0);
+    TEST_ASSERT_EQUAL_UINT8(0x41, sent[1].data[2]);
+}
+
+// Without an ACK the window goes out again between XFER_ACK_TIMEOUT and
+// ACK_WAIT_MAX, and the transfer fails after XFER_MAX_RETRIES retries.
+static void test_retry_limit_fails_transfer() {
+    FragmentTransport t(captureFrame, captureDelivery, captureCompletion);
+    t.begin(SENDER);
+    t.send(RECEIVER, payload, XFER_FRAGMENT_LEN * 2, 0);
+    unsigned long now = 0;
+
+    t.poll(now + XFER_ACK_TIMEOUT - 1);
+    TEST_ASSERT_EQUAL_INT(2, sentCount);   // not yet
+
+    for (uint8_t retry = 1; retry <= XFER_MAX_RETRIES; retry++) {
+        now += ACK_WAIT_MAX;
+        t.poll(now);
+        TEST_ASSERT_EQUAL_INT(2 * (retry + 1), sentCount);
+        TEST_ASSERT_TRUE(t.busy());
+    }
+    now += ACK_WAIT_MAX;
+    t.poll(now);
+    TEST_ASSERT_FALSE(t.busy());
+    TEST_ASSERT_EQUAL_INT(1, completions);
+    TEST_ASSERT_FALSE(lastOk);
+    TEST_ASSERT_EQUAL_UINT32(1, t.stats().transfersFailed);
+}
+
+// The ACK timer runs from the last fragment of the window, which on a slow
+// radio goes out long after the window started.
+static void test_ack_timer_starts_after_window() {
+    FragmentTransport t(captureFrame, captureDelivery, captureCompletion, radioClock);
+    t.begin(SENDER);
+    frameAirMs = XFER_ACK_TIMEOUT / 2;
+    t.send(RECEIVER, payload, XFER_FRAGMENT_LEN * XFER_WINDOW, 0);
+    unsigned long windowEnd = clockMs;
+    TEST_ASSERT_EQUAL_UINT32(XFER_WINDOW * frameAirMs, windowEnd);
+
+    t.poll(XFER_ACK_TIMEOUT);
+    t.poll(windowEnd + XFER_ACK_TIMEOUT - 1);
+    TEST_ASSERT_EQUAL_INT(XFER_WINDOW, sentCount);
+    t.poll(windowEnd + ACK_WAIT_MAX);
+    TEST_ASSERT_EQUAL_INT(2 * XFER_WINDOW, sentCount);
+}
+
+// Polls until the window goes out again; returns when, or 0 if it did not by ACK_WAIT_MAX.
+static unsigned long retryTime(FragmentTransport& t) {
+    for (unsigned long now = XFER_ACK_TIMEOUT; now <= ACK_WAIT_MAX; now++) {
+        int before = sentCount;
+        t.poll(now);
+        if (sentCount > before) {
+            return now;
+        }
+    }
+    return 0;
+}
+
+// Two senders whose first windows collided do not retry in lockstep.
+static void test_retry_jitter_differs_per_node() {
+    FragmentTransport a(captureFrame, nullptr, nullptr);
+    FragmentTransport b(captureFrame, nullptr, nullptr);
+    a.begin(SENDER);
+    b.begin(SENDER + 1);
+    a.send(RECEIVER, payload, XFER_FRAGMENT_LEN, 0);
+    b.send(RECEIVER, payload, XFER_FRAGMENT_LEN, 0);
+
+    unsigned long retryA = retryTime(a);
+    unsigned long retryB = retryTime(b);
+    TEST_ASSERT_NOT_EQUAL(0, retryA);
+    TEST_ASSERT_NOT_EQUAL(0, retryB);
+    TEST_ASSERT_NOT_EQUAL(retryA, retryB);
+}
+
+// A partial ACK shows the receiver is alive, so it resets the retry count.
+static void test_progress_resets_retries() {
+    FragmentTransport t(captureFrame, captureDelivery, captureCompletion);
+    t.begin(SENDER);
+    t.send(RECEIVER, payload, XFER_FRAGMENT_LEN * 3, 0);
+    uint8_t xferId = sent[0].data[2];
+    unsigned long now = 0;
+
+    for (uint8_t retry = 0; retry < XFER_MAX_RETRIES; retry++) {
+        now += ACK_WAIT_MAX;
+        t.poll(now);
+    }
+    ack(t, xferId, 0x01, now);
+    for (uint8_t retry = 0; retry < XFER_MAX_RETRIES; retry++) {
+        now += ACK_WAIT_MAX;
+        t.poll(now);
+    }
+    TEST_ASSERT_TRUE(t.busy());
+    TEST_ASSERT_EQUAL_INT(0, completions);
+}
+
+// Frames the radio refused are not counted as sent and still go out on the retry.
+static void test_refused_frames_resent() {
+    FragmentTransport t(captureFrame, captureDelivery, captureCompletion);
+    t.begin(SENDER);
+    radioUp = false;
+    t.send(RECEIVER, payload, XFER_FRAGMENT_LEN * 2, 0);
+    TEST_ASSERT_EQUAL_UINT32(0, t.stats().framesSent);
+
+    radioUp = true;
+    t.poll(ACK_WAIT_MAX);
+    TEST_ASSERT_EQUAL_INT(2, sentCount);
+    TEST_ASSERT_EQUAL_UINT32(2, t.stats().framesSent);
+    TEST_ASSERT_EQUAL_UINT32(0, t.stats().retransmits);
+}
+
+// Fragments the channel holds back wait in the transport and go out from poll()
+// once it clears; the last of the window still asks for the ACK.
+static void test_window_waits_for_channel() {
+    FragmentTransport t(captureFrame, captureDelivery, captureCompletion, nullptr, channelClear);
+    t.begin(SENDER);
+    channelLimit = 0;
+    TEST_ASSERT_TRUE(t.send(RECEIVER, payload, XFER_FRAGMENT_LEN * 5, 0));
+    TEST_ASSERT_EQUAL_INT(0, sentCount);
+    TEST_ASSERT_TRUE(t.waiting());
+
+    channelLimit = 3;
+    t.poll(10);
+    TEST_ASSERT_EQUAL_INT(3, sentCount);
+    TEST_ASSERT_FALSE(frameAsksAck(2));
+    TEST_ASSERT_TRUE(t.waiting());
+
+    // The ACK timer has not started, so nothing is retried while fragments are held
+    t.poll(ACK_WAIT_MAX);
+    TEST_ASSERT_EQUAL_INT(3, sentCount);
+
+    channelLimit = 1000;
+    t.poll(ACK_WAIT_MAX + 10);
+    TEST_ASSERT_EQUAL_INT(5, sentCount);
+    for (int i = 0; i < sentCount; i++) {
+        TEST_ASSERT_EQUAL_UINT8(i, frameSeq(i));
+    }
+    TEST_ASSERT_TRUE(frameAsksAck(4));
+    TEST_ASSERT_FALSE(t.waiting());
+    TEST_ASSERT_EQUAL_UINT32(0, t.stats().retransmits);
+}
+
+// An ACK asked for while the channel is busy goes out from poll() once it clears.
+static void test_ack_waits_for_channel() {
+    FragmentTransport rx(captureFrame, captureDelivery, nullptr, nullptr, channelClear);
+    rx.begin(RECEIVER);
+    uint8_t frame[XFER_DATA_HEADER_LEN + 4] = { MSG_XFER_DATA, RECEIVER, 9, 0, 1, XFER_FLAG_ACK_REQ, 1, 2, 3, 4 };
+    channelLimit = 0;
+    rx.onFrame(SENDER, frame, sizeof(frame), 0);
+    TEST_ASSERT_EQUAL_INT(1, deliveries);
+    TEST_ASSERT_EQUAL_INT(0, sentCount);
+    TEST_ASSERT_TRUE(rx.waiting());
+
+    rx.poll(100);
+    TEST_ASSERT_EQUAL_INT(0, sentCount);
+    channelLimit = 1000;
+    rx.poll(200);
+    TEST_ASSERT_EQUAL_INT(1, sentCount);
+    TEST_ASSERT_EQUAL_UINT8(MSG_XFER_ACK, sent[0].data[0]);
+    TEST_ASSERT_EQUAL_UINT8(SENDER, sent[0].data[1]);
+    TEST_ASSERT_EQUAL_UINT8(0x01, sent[0].data[3]);
+    TEST_ASSERT_FALSE(rx.waiting());
+}
+
+// Feeds every frame the sender put on the air, from index first on, to the receiver.
+static void relay(FragmentTransport& rx, int first, unsigned long now, uint32_t dropMask = 0) {
+    int last = sentCount;
+    for (int i = first; i < last; i++) {
+        if (!(dropMask & (1UL << frameSeq(i)))) {
+            rx.onFrame(SENDER, sent[i].data, sent[i].len, now);
+        }
+    }
+}
+
+// The receiver reassembles out of order, ACKs the window and delivers once.
+static void test_reassembly_and_single_delivery() {
+    FragmentTransport tx(captureFrame, nullptr, captureCompletion);
+    FragmentTransport rx(captureFrame, captureDelivery, nullptr);
+    tx.begin(SENDER);
+    rx.begin(RECEIVER);
+    size_t len = XFER_FRAGMENT_LEN * 3 + 5;
+    tx.send(RECEIVER, payload, len, 0);
+    int windowEnd = sentCount;
+
+    relay(rx, 0, 10, 0x02);   // fragment 1 is lost
+    TEST_ASSERT_EQUAL_INT(0, deliveries);
+    TEST_ASSERT_EQUAL_INT(windowEnd + 1, sentCount);
+    const SentFrame& reply = sent[windowEnd];
+    TEST_ASSERT_EQUAL_UINT8(MSG_XFER_ACK, reply.data[0]);
+    TEST_ASSERT_EQUAL_UINT8(SENDER, reply.data[1]);
+    TEST_ASSERT_EQUAL_UINT8(0x0D, reply.data[3]);
+
+    tx.onFrame(RECEIVER, reply.data, reply.len, 20);
+    int resent = sentCount;
+    TEST_ASSERT_EQUAL_INT(windowEnd + 2, resent);   // only fragment 1 again
+    relay(rx, resent - 1, 30);
+    TEST_ASSERT_EQUAL_INT(1, deliveries);
+    TEST_ASSERT_EQUAL_size_t(len, deliveredLen);
+    TEST_ASSERT_EQUAL_MEMORY(payload, delivered, len);
+
+    tx.onFrame(RECEIVER, sent[sentCount - 1].data, sent[sentCount - 1].len, 40);
+    TEST_ASSERT_FALSE(tx.busy());
+    TEST_ASSERT_TRUE(lastOk);
+}
+
+// A retransmitted fragment of a delivered payload is ACKed again but not re-delivered,
+// so a sender whose ACK was lost still completes.
+static void test_duplicate_reacked_not_redelivered() {
+    FragmentTransport rx(captureFrame, captureDelivery, nullptr);
+    rx.begin(RECEIVER);
+    uint8_t frame[XFER_DATA_HEADER_LEN + 4] = { MSG_XFER_DATA, RECEIVER, 9, 0, 1, XFER_FLAG_ACK_REQ, 1, 2, 3, 4 };
+
+    rx.onFrame(SENDER, frame, sizeof(frame), 0);
+    rx.onFrame(SENDER, frame, sizeof(frame), 100);
+    TEST_ASSERT_EQUAL_INT(1, deliveries);
+    TEST_ASSERT_EQUAL_INT(2, sentCount);
+    TEST_ASSERT_EQUAL_UINT8(MSG_XFER_ACK, sent[1].data[0]);
+    TEST_ASSERT_EQUAL_UINT8(0x01, sent[1].data[3]);
+    TEST_ASSERT_EQUAL_UINT32(2, rx.stats().acksSent);
+}
+
+// Fragments for another node, or with an inconsistent header, are not stored.
+static void test_receiver_filters_frames() {
+    FragmentTransport rx(captureFrame, captureDelivery, nullptr);
+    rx.begin(RECEIVER);
+    uint8_t other[XFER_DATA_HEADER_LEN + 1] = { MSG_XFER_DATA, RECEIVER + 1, 1, 0, 1, XFER_FLAG_ACK_REQ, 0 };
+    rx.onFrame(SENDER, other, sizeof(other), 0);
+    TEST_ASSERT_EQUAL_INT(0, sentCount);
+
+    uint8_t badSeq[XFER_DATA_HEADER_LEN + 1] = { MSG_XFER_DATA, RECEIVER, 1, 3, 2, 0, 0 };
+    rx.onFrame(SENDER, badSeq, sizeof(badSeq), 0);
+    uint8_t shortMiddle[XFER_DATA_HEADER_LEN + 1] = { MSG_XFER_DATA, RECEIVER, 1, 0, 2, 0, 0 };
+    rx.onFrame(SENDER, shortMiddle, sizeof(shortMiddle), 0);
+    TEST_ASSERT_EQUAL_UINT32(2, rx.stats().rxDropped);
+    TEST_ASSERT_EQUAL_INT(0, deliveries);
+}
+
+int main() {
+    UNITY_BEGIN();
+    RUN_TEST(test_send_first_window);
+    RUN_TEST(test_send_rejects_bad_length);
+    RUN_TEST(test_ack_retransmits_missing_only);
+    RUN_TEST(test_ack_for_other_transfer_ignored);
+    RUN_TEST(test_stale_ack_ignored);
+    RUN_TEST(test_transfer_id_follows_boot_seed);
+    RUN_TEST(test_retry_limit_fails_transfer);
+    RUN_TEST(test_ack_timer_starts_after_window);
+    RUN_TEST(test_retry_jitter_differs_per_node);
+    RUN_TEST(test_progress_resets_retries);
+    RUN_TEST(test_refused_frames_resent);
+    RUN_TEST(test_window_waits_for_channel);
+    RUN_TEST(test_ack_waits_for_channel);
+    RUN_TEST(test_reassembly_and_single_delivery);
+    RUN_TEST(test_duplicate_reacked_not_redelivered);
+    RUN_TEST(test_receiver_filters_frames);
+    return UNITY_END();
+}
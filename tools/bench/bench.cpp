@@ -0,0 +1,457 @@
+/*
+ Project Name ------  FRS
+ Task --------------  Escalator Node Firmware with Esp32
+ Engineer ----------- Muhammad Usman
+ File --------------- Host Benchmark Source File
+ Company -----------  Machadev Pvt Limited
+
+Microbenchmarks for the node's hot paths, built natively from the
+unmodified src/ files and the host shims in tools/host:
+
+- listenForNodes() dispatch of each frame kind
+- updateNodeStatus() / checkNodeActivity() / printNetworkStats() at 4..255 nodes
+- the portal wizard posts with the bodies data/portal.html sends, the
+  GET handlers that prefill its forms, and the /frames status stream
+
+Each benchmark reports time per op and heap allocations (count and bytes)
+per op. Results go to stdout and, in Go benchmark format, to
+bench_output.txt, so they can be compared with benchstat or with
+--baseline, which fails the run when a benchmark regresses.
+
+  pio run -e bench
+  .pio/build/bench/program                                  # writes bench_output.txt
+  .pio/build/bench/program --baseline old.txt --max-regress 20
+
+Options:
+
+  --filter S         only benchmarks whose name contains S
+  --min-time S       measuring time per benchmark (default 0.3)
+  --out FILE         results file (default bench_output.txt, - for none)
+  --baseline FILE    compare with an earlier results file
+  --max-regress P    allowed ns/op increase in percent (default 25);
+                     any increase in allocs/op is a regression
+
+Host allocation counts are from glibc malloc (ArduinoJson, String,
+std::vector); the ESP32 heap sees the same calls. Times are host times:
+compare them with each other, not with the device.
+ */
+
+// Import Libraries
+#include <Arduino.h>
+#include <chrono>
+#include <functional>
+#include <map>
+#include <vector>
+#include "functions.h"
+#include "protocol.h"
+#include "time_sync.h"
+
+extern WebServer server;
+
+// ---- Allocation counting ----
+
+static uint64_t allocCount = 0;
+static uint64_t allocBytes = 0;
+
+#if defined(__GLIBC__)
+extern "C" {
+void* __libc_malloc(size_t size);
+void* __libc_calloc(size_t count, size_t size);
+void* __libc_realloc(void* ptr, size_t size);
+void __libc_free(void* ptr);
+
+// operator new ends in malloc, so this sees C and C++ allocations once each.
+void* malloc(size_t size) {
+    allocCount++;
+    allocBytes += size;
+    return __libc_malloc(size);
+}
+
+void* calloc(size_t count, size_t size) {
+    allocCount++;
+    allocBytes += count * size;
+    return __libc_calloc(count, size);
+}
+
+void* realloc(void* ptr, size_t size) {
+    allocCount++;
+    allocBytes += size;
+    return __libc_realloc(ptr, size);
+}
+
+void free(void* ptr) {
+    __libc_free(ptr);
+}
+}
+#else
+void* operator new(size_t size) {
+    allocCount++;
+    allocBytes += size;
+    void* p = malloc(size);
+    if (!p) throw std::bad_alloc();
+    return p;
+}
+
+void operator delete(void* ptr) noexcept {
+    free(ptr);
+}
+#endif
+
+// ---- Host hooks ----
+
+static uint64_t benchNowUs = 0;
+static uint8_t rxFrame[RH_MESH_MAX_MESSAGE_LEN];
+static uint8_t rxLen = 0;
+static uint8_t rxFrom = 0;
+static bool rxPending = false;
+static uint8_t txFrame[RH_MESH_MAX_MESSAGE_LEN];
+static uint8_t txLen = 0;
+
+uint64_t hostMicros() {
+    return benchNowUs;
+}
+
+void hostDelay(uint32_t ms) {
+    benchNowUs += (uint64_t)ms * 1000;
+}
+
+bool hostLightSleep(uint32_t ms) {
+    benchNowUs += (uint64_t)ms * 1000;
+    return false;
+}
+
+void hostDigitalWrite(uint8_t, uint8_t) {}
+
+// The console is discarded, but formatting it is part of the measured cost.
+void hostSerialWrite(const uint8_t*, size_t) {}
+
+uint8_t hostRadioAddress() {
+    return 2;
+}
+
+uint8_t hostRadioSend(const uint8_t* buf, uint8_t len, uint8_t) {
+    memcpy(txFrame, buf, len);
+    txLen = len;
+    return RH_ROUTER_ERROR_NONE;
+}
+
+// Hands out the frame staged by stageFrame(), once.
+bool hostRadioRecv(uint8_t* buf, uint8_t* len, uint16_t, uint8_t* from) {
+    if (!rxPending) {
+        return false;
+    }
+    uint8_t n = rxLen < *len ? rxLen : *len;
+    memcpy(buf, rxFrame, n);
+    *len = n;
+    *from = rxFrom;
+    rxPending = false;
+    return true;
+}
+
+static void stageFrame(uint8_t from, const void* frame, uint8_t len) {
+    memcpy(rxFrame, frame, len);
+    rxLen = len;
+    rxFrom = from;
+    rxPending = true;
+}
+
+// ---- Harness ----
+
+struct BenchResult {
+    std::string name;
+    uint64_t iterations;
+    double nsPerOp;
+    double bytesPerOp;
+    double allocsPerOp;
+};
+
+static double minTimeS = 0.3;
+static std::string filter;
+static std::vector<BenchResult> results;
+
+// Runs fn in growing batches until a batch takes minTimeS, then records that batch.
+static void runBench(const std::string& name, const std::function<void()>& fn) {
+    if (!filter.empty() && name.find(filter) == std::string::npos) {
+        return;
+    }
+    fn();  // warm-up: first-use allocations (static buffers, vectors) are not per-op costs
+
+    uint64_t n = 1;
+    for (;;) {
+        uint64_t count0 = allocCount, bytes0 = allocBytes;
+        auto start = std::chrono::steady_clock::now();
+        for (uint64_t i = 0; i < n; i++) fn();
+        double elapsed = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+        uint64_t count = allocCount - count0, bytes = allocBytes - bytes0;
+
+        if (elapsed >= minTimeS || n >= (1ull << 32)) {
+            BenchResult r = { name, n, elapsed * 1e9 / n, (double)bytes / n, (double)count / n };
+            results.push_back(r);
+            printf("%-44s %10llu %12.1f ns/op %10.1f B/op %8.2f allocs/op\n", r.name.c_str(),
+                   (unsigned long long)r.iterations, r.nsPerOp, r.bytesPerOp, r.allocsPerOp);
+            fflush(stdout);
+            return;
+        }
+        uint64_t next = elapsed > 0 ? (uint64_t)(n * minTimeS * 1.2 / elapsed) : n * 100;
+        n = std::max(n * 2, std::min(next, n * 100));
+    }
+}
+
+// ---- Fixtures ----
+
+static const uint8_t NODE_COUNTS[] = { 4, 16, 64, 255 };
+
+// A table of count nodes with ids 3.., all recently seen.
+static void fillNodeTable(size_t count) {
+    nodeStatuses.clear();
+    for (size_t i = 0; i < count; i++) {
+        nodeStatuses.push_back({ (uint8_t)(3 + i), (unsigned long)millis(), (uint32_t)millis(), true });
+    }
+}
+
+// Builds the JSON the portal posts for some wizard sections: one object
+// per <section>, one member per <input name=...> in it, filled the way an
+// installer would, with variant alternating the values so every post is
+// an edit.
+static String formBody(const std::vector<const char*>& sections, int variant) {
+    File file = SPIFFS.open("/portal.html", "r");
+    std::string html;
+    int c;
+    while ((c = file.read()) >= 0) html += (char)c;
+    file.close();
+
+    String body = "{";
+    for (const char* section : sections) {
+        size_t pos = html.find(std::string("<section id=\"") + section + "\"");
+        size_t sectionEnd = html.find("</section>", pos);
+        if (body.length() > 1) body += ",";
+        body += (std::string("\"") + section + "\":{").c_str();
+        bool first = true;
+        while ((pos = html.find("<input", pos)) < sectionEnd) {
+            size_t end = html.find('>', pos);
+            std::string tag = html.substr(pos, end - pos);
+            pos = end;
+            size_t n = tag.find("name=\"");
+            if (n == std::string::npos) continue;
+            std::string name = tag.substr(n + 6, tag.find('"', n + 6) - n - 6);
+            std::string value;
+            if (tag.find("type=\"date\"") != std::string::npos) value = variant ? "2024-05-14" : "2024-06-02";
+            else if (tag.find("type=\"email\"") != std::string::npos) value = variant ? "service@machadev.com" : "ops@machadev.com";
+            else value = std::string(variant ? "Machadev Pvt Limited, Plot 14-B " : "Machadev Pvt Ltd, Block C Unit 7 ") + name;
+            body += ((first ? "\"" : ",\"") + name + "\":\"" + value + "\"").c_str();
+            first = false;
+        }
+        body += "}";
+    }
+    body += "}";
+    return body;
+}
+
+static void benchPost(const std::string& name, void (*handler)(), const String& body) {
+    runBench(name, [&]() {
+        server.hostRequest(HTTP_POST, body.c_str());
+        handler();
+    });
+}
+
+static void benchPostForm(const std::string& name, void (*handler)(), const std::vector<const char*>& sections) {
+    String bodies[2] = { formBody(sections, 0), formBody(sections, 1) };
+    int variant = 0;
+    runBench(name, [&]() {
+        server.hostRequest(HTTP_POST, bodies[variant].c_str());
+        handler();
+        variant ^= 1;
+    });
+}
+
+static void benchGet(const std::string& name, void (*handler)()) {
+    runBench(name, [&]() {
+        server.hostRequest(HTTP_GET, nullptr);
+        handler();
+    });
+}
+
+// ---- Benchmarks ----
+
+static void benchDispatch() {
+    static const char active[] = "Active";
+    static const char presence[] = "Node Present";
+    static const char unknown[] = "Hello";
+
+    fillNodeTable(16);
+    runBench("ListenForNodes/idle", [] { listenForNodes(); });
+    runBench("ListenForNodes/active", [] {
+        stageFrame(1, active, sizeof(active));
+        listenForNodes();
+    });
+    runBench("ListenForNodes/group_switch", [] {
+        static const uint8_t groupSwitch[] = { MSG_GROUP_SWITCH, 1, 0x05, 0x00, 0x00, 0x80 };
+        stageFrame(1, groupSwitch, sizeof(groupSwitch));
+        listenForNodes();
+    });
+    runBench("ListenForNodes/unknown", [] {
+        stageFrame(3, unknown, sizeof(unknown));
+        listenForNodes();
+    });
+    for (uint8_t count : NODE_COUNTS) {
+        fillNodeTable(count);
+        uint8_t next = 0;
+        runBench("ListenForNodes/presence/nodes=" + std::to_string(count), [&] {
+            stageFrame((uint8_t)(3 + next), presence, sizeof(presence));
+            next = (uint8_t)((next + 1) % count);
+            listenForNodes();
+        });
+    }
+
+    // Our own digest, taken from our beacon: the common case where a neighbour is already in sync.
+    broadcastPresence();
+    uint8_t digest[5] = { MSG_SYNC_DIGEST };
+    memcpy(digest + 1, txFrame + 1 + TIME_SYNC_LEN, sizeof(digest) - 1);
+    runBench("ListenForNodes/sync_digest_equal", [&] {
+        stageFrame(3, digest, sizeof(digest));
+        listenForNodes();
+    });
+}
+
+static void benchNodeTable() {
+    for (uint8_t count : NODE_COUNTS) {
+        std::string suffix = "/nodes=" + std::to_string(count);
+
+        fillNodeTable(count);
+        uint8_t next = 0;
+        runBench("UpdateNodeStatus/existing" + suffix, [&] {
+            updateNodeStatus((uint8_t)(3 + next));
+            next = (uint8_t)((next + 1) % count);
+        });
+
+        fillNodeTable(count);
+        runBench("UpdateNodeStatus/new" + suffix, [&] {
+            updateNodeStatus(1);   // the controller, never in the table: a full scan plus an append
+            nodeStatuses.pop_back();
+        });
+
+        fillNodeTable(count);
+        runBench("CheckNodeActivity/all_alive" + suffix, [] { checkNodeActivity(); });
+
+        fillNodeTable(count);
+        runBench("PrintNetworkStats" + suffix, [] { printNetworkStats(); });
+    }
+    nodeStatuses.clear();
+}
+
+static void benchPortal() {
+    // Login, WiFi and unique key, as submitAccess() in data/portal.html sends them.
+    benchPost("Post/wizard_access", handleWizardAccessPost,
+              "{\"role\":\"client\",\"username\":\"client\",\"password\":\"client123\",\"rememberMe\":true,"
+              "\"ssid\":\"Machadev\",\"wifiPassword\":\"Machadev321\",\"uniqueKey\":\"FRS-7F3A-91C2-0B5D\"}");
+
+    // The wizard sections; each post is persisted to flash.
+    benchPostForm("Post/wizard_site", handleWizardSitePost, { "company", "unit", "manufacturer" });
+    benchPostForm("Post/wizard_site_autofill", handleWizardSitePost, { "unit", "manufacturer" });
+    benchPostForm("Post/wizard_ap", handleWizardSitePost, { "ap" });
+
+    benchGet("Get/company_details", handleCompanyDetailsGet);
+    benchGet("Get/unit_details", handleUnitDetailsGet);
+    benchGet("Get/manufacturer_details", handleManufacturerDetailsGet);
+    benchGet("Get/frames", handleFramesGet);
+}
+
+// ---- Results files ----
+
+static bool writeResults(const char* path) {
+    FILE* fp = fopen(path, "w");
+    if (!fp) {
+        perror(path);
+        return false;
+    }
+    fprintf(fp, "goos: host\npkg: escalator-node\n");
+    for (const auto& r : results) {
+        fprintf(fp, "Benchmark%s\t%llu\t%.1f ns/op\t%.0f B/op\t%.2f allocs/op\n", r.name.c_str(),
+                (unsigned long long)r.iterations, r.nsPerOp, r.bytesPerOp, r.allocsPerOp);
+    }
+    fclose(fp);
+    return true;
+}
+
+static std::map<std::string, BenchResult> readResults(const char* path) {
+    std::map<std::string, BenchResult> out;
+    FILE* fp = fopen(path, "r");
+    if (!fp) {
+        perror(path);
+        exit(2);
+    }
+    char line[512];
+    while (fgets(line, sizeof(line), fp)) {
+        char name[256];
+        BenchResult r = {};
+        unsigned long long iterations;
+        if (sscanf(line, "Benchmark%255s %llu %lf ns/op %lf B/op %lf allocs/op", name, &iterations, &r.nsPerOp,
+                   &r.bytesPerOp, &r.allocsPerOp) == 5) {
+            r.name = name;
+            r.iterations = iterations;
+            out[r.name] = r;
+        }
+    }
+    fclose(fp);
+    return out;
+}
+
+// Returns the number of regressed benchmarks.
+static int compareResults(const char* baselinePath, double maxRegressPercent) {
+    std::map<std::string, BenchResult> baseline = readResults(baselinePath);
+    int regressions = 0;
+    printf("\n%-44s %12s %12s %8s %10s\n", "vs baseline", "old ns/op", "new ns/op", "delta", "allocs");
+    for (const auto& r : results) {
+        auto it = baseline.find(r.name);
+        if (it == baseline.end()) continue;
+        const BenchResult& old = it->second;
+        double delta = old.nsPerOp > 0 ? (r.nsPerOp - old.nsPerOp) * 100 / old.nsPerOp : 0;
+        bool slower = delta > maxRegressPercent;
+        bool moreAllocs = r.allocsPerOp > old.allocsPerOp + 0.005;
+        printf("%-44s %12.1f %12.1f %+7.1f%% %4.2f->%-4.2f%s\n", r.name.c_str(), old.nsPerOp, r.nsPerOp, delta,
+               old.allocsPerOp, r.allocsPerOp, slower || moreAllocs ? "  REGRESSION" : "");
+        if (slower || moreAllocs) regressions++;
+    }
+    return regressions;
+}
+
+int main(int argc, char** argv) {
+    const char* outPath = "bench_output.txt";
+    const char* baselinePath = nullptr;
+    double maxRegress = 25;
+    for (int i = 1; i < argc; i++) {
+        std::string a = argv[i];
+        const char* v = i + 1 < argc ? argv[i + 1] : "";
+        if (a == "--filter") { filter = v; i++; }
+        else if (a == "--min-time") { minTimeS = atof(v); i++; }
+        else if (a == "--out") { outPath = v; i++; }
+        else if (a == "--baseline") { baselinePath = v; i++; }
+        else if (a == "--max-regress") { maxRegress = atof(v); i++; }
+        else {
+            fprintf(stderr, "unknown option %s (see the header of tools/bench/bench.cpp)\n", a.c_str());
+            return 2;
+        }
+    }
+
+    initializeSiteStore();
+    initializeJournal();
+    initializeRelays();
+    initializeLoRaLink();
+    initializeMESH();
+
+    benchDispatch();
+    benchNodeTable();
+    benchPortal();
+
+    if (strcmp(outPath, "-") != 0 && !writeResults(outPath)) {
+        return 2;
+    }
+    if (baselinePath != nullptr) {
+        int regressions = compareResults(baselinePath, maxRegress);
+        if (regressions > 0) {
+            printf("%d benchmark(s) regressed\n", regressions);
+            return 1;
+        }
+    }
+    return 0;
+}
@@ -0,0 +1,522 @@
+/*
+ Project Name ------  FRS
+ Task --------------  Escalator Node Firmware with Esp32
+ Engineer ----------- Muhammad Usman
+ File --------------- Firmware Broadcast Simulator Source File
+ Company -----------  Machadev Pvt Limited
+
+Airtime of a fountain-coded firmware broadcast (src/fw_update.h):
+
+- Each node is a real FirmwareReceiver with its own OTA partition in RAM.
+  A node passes only when the SHA-256 check has switched its boot
+  partition.
+- The controller side (the FyreBox, not in this tree) is modelled here. It
+  announces the image three times and sends a first pass of
+  32 + --repair symbols per generation. Then it repeats rounds until
+  every node has reported that it is done. Each round is an announce,
+  for nodes that missed the earlier ones, then a query. Then comes a
+  window of two status slots per unfinished node, and fresh symbols for
+  every generation reported.
+- With --repair auto the controller uses the loss rate, as it would have
+  learned it from earlier status replies. It sends enough symbols that,
+  on average, fewer than half a node falls short. A node falls short
+  when it gets fewer than its deficit + --margin symbols; the margin
+  covers GF(2) combinations that turn out to be dependent. With a fixed
+  --repair, each repair round sends the largest deficit + --margin.
+- There is one broadcast domain. Every frame is lost independently at
+  each receiver with probability --loss. Two status replies in the same
+  slot are both lost.
+- Two baselines are given for comparison. "arq" is unicast
+  stop-and-wait per node: data + ACK, repeated until both get through.
+  "repeat" is an uncoded broadcast where each round resends every chunk
+  that any node still lacks. It is charged the same announce and status
+  window per round, but its feedback is assumed never to be lost, so it
+  is a lower bound.
+
+Build and run:
+
+  pio run -e fwsim
+  .pio/build/fwsim/program --nodes 8,32,128 --loss 0.01,0.05,0.1,0.2 --image-kb 64 --csv
+
+Options:
+
+  --nodes a,b,c      node counts (default 8,32,128, max 250)
+  --loss a,b,c       per-frame loss probabilities (default 0.01,0.05,0.1,0.2)
+  --image-kb K       image size (default 64)
+  --repair R|auto    repair symbols per generation in the first pass (default auto)
+  --margin M         symbols a node needs beyond its deficit (default 2)
+  --air-rate BPS     E32 air data rate (default 2400)
+  --preamble MS      preamble + header airtime per frame (default 50)
+  --seed N           random seed (default 1)
+  --csv              machine-readable output
+ */
+
+// Import Libraries
+#include <cmath>
+#include <map>
+#include <memory>
+#include <random>
+#include <string>
+#include <vector>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <esp_ota_ops.h>
+#include <mbedtls/sha256.h>
+#include "fw_update.h"
+
+struct FwSimOptions {
+    std::vector<int> nodes = { 8, 32, 128 };
+    std::vector<double> loss = { 0.01, 0.05, 0.1, 0.2 };
+    uint32_t imageKb = 64;
+    int repair = -1;   // auto
+    int margin = 2;
+    double airRate = 2400;
+    double preambleMs = 50;
+    double uartBaud = 9600;
+    uint32_t seed = 1;
+    bool csv = false;
+};
+
+struct GenerationDemand {
+    uint8_t deficit;   // largest reported
+    int nodes;         // nodes that reported it
+};
+
+struct FwSimResult {
+    int nodes;
+    double loss;
+    int verified;
+    int rounds;
+    uint64_t chunkFrames;
+    uint64_t controlFrames;    // announces and status replies
+    double fountainS;
+    double repeatS;
+    double arqS;
+};
+
+// One OTA partition per simulated node; the esp_* calls below act on the current node.
+// Every node runs from the same blank partition, so none already has the image.
+static std::vector<std::unique_ptr<esp_partition_t>> nodePartitions;
+static std::vector<std::vector<uint8_t>> nodeFlash;
+static esp_partition_t runningPartition;
+static std::vector<uint8_t> runningFlash;
+static size_t currentNode = 0;
+
+const esp_partition_t* esp_ota_get_running_partition(void) {
+    return &runningPartition;
+}
+
+const esp_partition_t* esp_ota_get_next_update_partition(const esp_partition_t* startFrom) {
+    (void)startFrom;
+    return nodePartitions[currentNode].get();
+}
+
+esp_err_t esp_ota_set_boot_partition(const esp_partition_t* partition) {
+    return partition != nullptr ? ESP_OK : ESP_ERR_INVALID_ARG;
+}
+
+esp_err_t esp_partition_read(const esp_partition_t* partition, size_t offset, void* dst, size_t size) {
+    if (offset + size > partition->size) return ESP_ERR_INVALID_SIZE;
+    memcpy(dst, partition->data + offset, size);
+    return ESP_OK;
+}
+
+esp_err_t esp_partition_write(const esp_partition_t* partition, size_t offset, const void* src, size_t size) {
+    if (offset + size > partition->size) return ESP_ERR_INVALID_SIZE;
+    const uint8_t* bytes = (const uint8_t*)src;
+    for (size_t i = 0; i < size; i++) {
+        partition->data[offset + i] &= bytes[i];
+    }
+    return ESP_OK;
+}
+
+esp_err_t esp_partition_erase_range(const esp_partition_t* partition, size_t offset, size_t size) {
+    if (offset % 4096 != 0 || size % 4096 != 0 || offset + size > partition->size) return ESP_ERR_INVALID_ARG;
+    memset(partition->data + offset, 0xFF, size);
+    return ESP_OK;
+}
+
+// Status frames sent by nodes, collected by the send callback.
+struct StatusFrame {
+    size_t node;
+    unsigned long at;
+    std::vector<uint8_t> bytes;
+};
+
+static std::vector<StatusFrame> outbox;
+static unsigned long simNowMs = 0;
+
+static bool collectStatus(const uint8_t* frame, uint8_t len) {
+    outbox.push_back({ currentNode, simNowMs, std::vector<uint8_t>(frame, frame + len) });
+    return true;
+}
+
+class FwSimulation {
+public:
+    FwSimulation(const FwSimOptions& opt, int nodes, double loss);
+    FwSimResult run();
+
+private:
+    double airtimeMs(size_t appLen) const;
+    void broadcast(const uint8_t* frame, uint8_t len);
+    void sendAnnounce();
+    void sendQuery(uint8_t round, uint8_t slots);
+    void sendSymbol(uint16_t generation, uint16_t seed);
+    void pollNodes();
+    void collectReplies(std::map<uint16_t, GenerationDemand>& demand);
+    int symbolsFor(int needed, int receivers) const;
+    double repeatBaselineMs();
+    double arqBaselineMs() const;
+
+    const FwSimOptions& opt;
+    int nodeCount;
+    double loss;
+    std::mt19937 rng;
+    std::uniform_real_distribution<double> uniform;
+    std::vector<uint8_t> image;
+    uint8_t hash[32];
+    uint16_t imageId;
+    uint16_t generations;
+    std::vector<std::unique_ptr<FirmwareReceiver>> receivers;
+    std::vector<int> doneRound;      // round in which the node was first heard done, 0 if not yet
+    int currentRound;
+    std::vector<uint16_t> nextSeed;
+    double clockMs;
+    FwSimResult result;
+};
+
+FwSimulation::FwSimulation(const FwSimOptions& o, int nodes, double p)
+    : opt(o), nodeCount(nodes), loss(p), rng(o.seed * 7919u + (uint32_t)nodes), uniform(0.0, 1.0),
+      imageId(0), currentRound(0), clockMs(0) {
+    image.resize((size_t)opt.imageKb * 1024);
+    for (auto& b : image) b = (uint8_t)rng();
+    mbedtls_sha256_context ctx;
+    mbedtls_sha256_init(&ctx);
+    mbedtls_sha256_starts(&ctx, 0);
+    mbedtls_sha256_update(&ctx, image.data(), image.size());
+    mbedtls_sha256_finish(&ctx, hash);
+    mbedtls_sha256_free(&ctx);
+    imageId = (uint16_t)(rng() | 1);
+    generations = (uint16_t)((image.size() + FOUNTAIN_GEN_BYTES - 1) / FOUNTAIN_GEN_BYTES);
+    nextSeed.assign(generations, 0);
+
+    size_t flashSize = (image.size() + 4095) / 4096 * 4096;
+    nodePartitions.clear();
+    nodeFlash.assign(nodes, std::vector<uint8_t>(flashSize, 0xFF));
+    runningFlash.assign(flashSize, 0xFF);
+    runningPartition.type = ESP_PARTITION_TYPE_APP;
+    runningPartition.subtype = ESP_PARTITION_SUBTYPE_APP_OTA_0;
+    runningPartition.size = (uint32_t)flashSize;
+    runningPartition.data = runningFlash.data();
+    receivers.clear();
+    for (int i = 0; i < nodes; i++) {
+        std::unique_ptr<esp_partition_t> part(new esp_partition_t());
+        part->type = ESP_PARTITION_TYPE_APP;
+        part->subtype = ESP_PARTITION_SUBTYPE_APP_OTA_1;
+        part->size = (uint32_t)flashSize;
+        part->data = nodeFlash[i].data();
+        nodePartitions.push_back(std::move(part));
+        receivers.emplace_back(new FirmwareReceiver(collectStatus));
+        receivers.back()->begin((uint8_t)(i + 2));  // node 1 is the controller
+    }
+    doneRound.assign(nodes, 0);
+    memset(&result, 0, sizeof(result));
+    result.nodes = nodes;
+    result.loss = p;
+}
+
+// Same model as the mesh simulator: UART transfer, preamble, payload at the air rate.
+double FwSimulation::airtimeMs(size_t appLen) const {
+    size_t onAir = appLen + 6 + 5;  // RHRouter + RHMesh headers, RH_E32 length + header
+    return onAir * 10.0 * 1e3 / opt.uartBaud + opt.preambleMs + onAir * 8.0 * 1e3 / opt.airRate;
+}
+
+// Delivers a controller frame to every node that does not lose it.
+void FwSimulation::broadcast(const uint8_t* frame, uint8_t len) {
+    clockMs += airtimeMs(len);
+    simNowMs = (unsigned long)clockMs;
+    for (int i = 0; i < nodeCount; i++) {
+        if (uniform(rng) < loss) continue;
+        currentNode = (size_t)i;
+        if (frame[0] == MSG_FW_CHUNK) {
+            receivers[i]->onChunk(frame, len, simNowMs);
+        } else if (frame[0] == MSG_FW_ANNOUNCE) {
+            receivers[i]->onAnnounce(frame, len);
+        } else {
+            receivers[i]->onQuery(frame, len, simNowMs);
+        }
+    }
+    if (frame[0] == MSG_FW_CHUNK) {
+        result.chunkFrames++;
+    } else {
+        result.controlFrames++;
+    }
+}
+
+void FwSimulation::sendAnnounce() {
+    uint8_t frame[FW_ANNOUNCE_LEN];
+    uint32_t size = (uint32_t)image.size();
+    frame[0] = MSG_FW_ANNOUNCE;
+    frame[1] = (uint8_t)imageId;
+    frame[2] = (uint8_t)(imageId >> 8);
+    for (int i = 0; i < 4; i++) frame[3 + i] = (uint8_t)(size >> (8 * i));
+    memcpy(frame + 7, hash, sizeof(hash));
+    broadcast(frame, sizeof(frame));
+}
+
+void FwSimulation::sendQuery(uint8_t round, uint8_t slots) {
+    uint8_t frame[FW_QUERY_LEN];
+    memset(frame, 0, sizeof(frame));
+    frame[0] = MSG_FW_QUERY;
+    frame[1] = (uint8_t)imageId;
+    frame[2] = (uint8_t)(imageId >> 8);
+    frame[3] = round;
+    frame[4] = slots;
+    for (int i = 0; i < nodeCount; i++) {
+        int id = i + 2;
+        if (doneRound[i] != 0) frame[5 + id / 8] |= (uint8_t)(1u << (id % 8));
+    }
+    broadcast(frame, sizeof(frame));
+}
+
+void FwSimulation::sendSymbol(uint16_t generation, uint16_t seed) {
+    uint8_t source[FOUNTAIN_GEN_BYTES];
+    size_t offset = (size_t)generation * FOUNTAIN_GEN_BYTES;
+    size_t length = image.size() - offset < FOUNTAIN_GEN_BYTES ? image.size() - offset : FOUNTAIN_GEN_BYTES;
+    memset(source, 0, sizeof(source));
+    memcpy(source, image.data() + offset, length);
+
+    uint8_t frame[FW_CHUNK_LEN];
+    frame[0] = MSG_FW_CHUNK;
+    frame[1] = (uint8_t)imageId;
+    frame[2] = (uint8_t)(imageId >> 8);
+    frame[3] = (uint8_t)generation;
+    frame[4] = (uint8_t)(generation >> 8);
+    frame[5] = (uint8_t)seed;
+    frame[6] = (uint8_t)(seed >> 8);
+    fountainEncode(source, fountainCoefficients(imageId, generation, seed), frame + FW_CHUNK_HEADER_LEN);
+    broadcast(frame, sizeof(frame));
+}
+
+void FwSimulation::pollNodes() {
+    simNowMs = (unsigned long)clockMs;
+    for (int i = 0; i < nodeCount; i++) {
+        currentNode = (size_t)i;
+        receivers[i]->poll(simNowMs);
+    }
+}
+
+// Replies sent in the same slot collide; the rest reach the controller unless lost.
+void FwSimulation::collectReplies(std::map<uint16_t, GenerationDemand>& demand) {
+    std::map<unsigned long, int> perSlot;
+    for (const StatusFrame& s : outbox) perSlot[s.at]++;
+    for (const StatusFrame& s : outbox) {
+        result.controlFrames++;
+        if (perSlot[s.at] > 1 || uniform(rng) < loss) continue;
+        const uint8_t* f = s.bytes.data();
+        uint16_t missing = (uint16_t)(f[3] | (f[4] << 8));
+        if (missing == 0) {
+            if (doneRound[s.node] == 0) doneRound[s.node] = currentRound;
+            continue;
+        }
+        for (uint8_t e = 0; e < f[5]; e++) {
+            const uint8_t* entry = f + FW_STATUS_HEADER_LEN + 3 * e;
+            uint16_t g = (uint16_t)(entry[0] | (entry[1] << 8));
+            GenerationDemand& d = demand[g];
+            if (entry[2] > d.deficit) d.deficit = entry[2];
+            d.nodes++;
+        }
+    }
+    outbox.clear();
+}
+
+// Smallest number of symbols after which, on average, fewer than half of the
+// receivers have caught fewer than needed of them.
+int FwSimulation::symbolsFor(int needed, int receivers) const {
+    for (int k = needed;; k++) {
+        // P(Binomial(k, 1 - loss) < needed)
+        double term = pow(loss, k);
+        double shortfall = 0;
+        for (int got = 0; got < needed; got++) {
+            shortfall += term;
+            term *= (double)(k - got) / (got + 1) * (1 - loss) / (loss > 0 ? loss : 1e-12);
+        }
+        if (shortfall * receivers < 0.5 || k > 8 * needed + 64) {
+            return k;
+        }
+    }
+}
+
+FwSimResult FwSimulation::run() {
+    for (int i = 0; i < 3; i++) {
+        sendAnnounce();
+    }
+    // The nodes compare the image with the one they run before they take chunks.
+    for (bool checking = true; checking;) {
+        pollNodes();
+        checking = false;
+        for (int i = 0; i < nodeCount; i++) {
+            checking = checking || receivers[i]->state() == FW_CHECKING;
+        }
+    }
+    int firstPass = opt.repair >= 0 ? FOUNTAIN_GEN_SYMBOLS + opt.repair
+                                    : symbolsFor(FOUNTAIN_GEN_SYMBOLS + opt.margin, nodeCount);
+    for (uint16_t g = 0; g < generations; g++) {
+        while (nextSeed[g] < firstPass) {
+            sendSymbol(g, nextSeed[g]++);
+        }
+    }
+
+    for (int round = 1; round <= 250; round++) {
+        int pending = 0;
+        for (int i = 0; i < nodeCount; i++) {
+            pending += doneRound[i] == 0 ? 1 : 0;
+        }
+        if (pending == 0) break;
+        result.rounds = round;
+        currentRound = round;
+
+        int slots = pending * 2 < 4 ? 4 : (pending * 2 > 255 ? 255 : pending * 2);
+        sendAnnounce();
+        sendQuery((uint8_t)round, (uint8_t)slots);
+        double windowEnd = clockMs + slots * (double)FW_STATUS_SLOT_MS;
+        while (clockMs < windowEnd) {
+            pollNodes();
+            clockMs += FW_STATUS_SLOT_MS;
+        }
+        std::map<uint16_t, GenerationDemand> demand;
+        collectReplies(demand);
+
+        for (const auto& d : demand) {
+            int needed = d.second.deficit + opt.margin;
+            int count = opt.repair >= 0 ? needed : symbolsFor(needed, d.second.nodes);
+            for (int s = 0; s < count; s++) {
+                sendSymbol(d.first, nextSeed[d.first]++);
+            }
+        }
+    }
+
+    for (int i = 0; i < nodeCount; i++) {
+        if (receivers[i]->state() == FW_READY) result.verified++;
+    }
+    result.fountainS = clockMs / 1000.0;
+    result.repeatS = repeatBaselineMs() / 1000.0;
+    result.arqS = arqBaselineMs() / 1000.0;
+    return result;
+}
+
+// Uncoded broadcast: resend every chunk some node lacks until none does.
+double FwSimulation::repeatBaselineMs() {
+    size_t chunks = (image.size() + FOUNTAIN_SYMBOL_LEN - 1) / FOUNTAIN_SYMBOL_LEN;
+    std::vector<int> lacking(chunks, nodeCount);
+    std::vector<std::vector<bool>> have(nodeCount, std::vector<bool>(chunks, false));
+    uint64_t frames = 0;
+    double controlMs = 0;
+    bool anyMissing = true;
+    while (anyMissing) {
+        if (frames > 0) {
+            int lackingNodes = 0;
+            for (int i = 0; i < nodeCount; i++) {
+                for (size_t c = 0; c < chunks; c++) {
+                    if (!have[i][c]) {
+                        lackingNodes++;
+                        break;
+                    }
+                }
+            }
+            controlMs += airtimeMs(FW_ANNOUNCE_LEN) + 2.0 * lackingNodes * FW_STATUS_SLOT_MS;
+        }
+        anyMissing = false;
+        for (size_t c = 0; c < chunks; c++) {
+            if (lacking[c] == 0) continue;
+            frames++;
+            for (int i = 0; i < nodeCount; i++) {
+                if (have[i][c] || uniform(rng) < loss) continue;
+                have[i][c] = true;
+                lacking[c]--;
+            }
+            anyMissing = anyMissing || lacking[c] > 0;
+        }
+    }
+    return frames * airtimeMs(FW_CHUNK_LEN) + controlMs;
+}
+
+// Unicast stop-and-wait: each try costs a data frame and an ACK, and succeeds if both arrive.
+double FwSimulation::arqBaselineMs() const {
+    size_t chunks = (image.size() + FOUNTAIN_SYMBOL_LEN - 1) / FOUNTAIN_SYMBOL_LEN;
+    double success = (1 - loss) * (1 - loss);
+    double perTry = airtimeMs(FW_CHUNK_LEN) + airtimeMs(4);
+    return nodeCount * (double)chunks * perTry / success;
+}
+
+static void printResult(const FwSimOptions& opt, const FwSimResult& r, bool header) {
+    if (opt.csv) {
+        if (header) {
+            printf("nodes,loss,verified,rounds,chunk_frames,control_frames,fountain_s,repeat_s,arq_s\n");
+        }
+        printf("%d,%.3f,%d,%d,%llu,%llu,%.1f,%.1f,%.1f\n", r.nodes, r.loss, r.verified, r.rounds,
+               (unsigned long long)r.chunkFrames, (unsigned long long)r.controlFrames,
+               r.fountainS, r.repeatS, r.arqS);
+        return;
+    }
+    printf("Nodes: %d, loss %.1f%%\n", r.nodes, r.loss * 100);
+    printf("  Verified %d/%d after %d repair rounds; %llu chunk frames, %llu announce/status frames\n",
+           r.verified, r.nodes, r.rounds, (unsigned long long)r.chunkFrames, (unsigned long long)r.controlFrames);
+    printf("  Airtime: fountain %.1f min, uncoded repeat %.1f min, unicast ARQ %.1f min\n",
+           r.fountainS / 60, r.repeatS / 60, r.arqS / 60);
+}
+
+static std::vector<double> parseList(const char* s) {
+    std::vector<double> out;
+    while (*s) {
+        out.push_back(atof(s));
+        const char* comma = strchr(s, ',');
+        if (!comma) break;
+        s = comma + 1;
+    }
+    return out;
+}
+
+int main(int argc, char** argv) {
+    FwSimOptions opt;
+    for (int i = 1; i < argc; i++) {
+        std::string a = argv[i];
+        const char* v = i + 1 < argc ? argv[i + 1] : "";
+        if (a == "--nodes") {
+            opt.nodes.clear();
+            for (double n : parseList(v)) opt.nodes.push_back((int)n);
+            i++;
+        }
+        else if (a == "--loss") { opt.loss = parseList(v); i++; }
+        else if (a == "--image-kb") { opt.imageKb = (uint32_t)atoi(v); i++; }
+        else if (a == "--repair") { opt.repair = strcmp(v, "auto") == 0 ? -1 : atoi(v); i++; }
+        else if (a == "--margin") { opt.margin = atoi(v); i++; }
+        else if (a == "--air-rate") { opt.airRate = atof(v); i++; }
+        else if (a == "--preamble") { opt.preambleMs = atof(v); i++; }
+        else if (a == "--seed") { opt.seed = (uint32_t)atoi(v); i++; }
+        else if (a == "--csv") { opt.csv = true; }
+        else {
+            fprintf(stderr, "unknown option %s (see the header of tools/fwsim/fwsim.cpp)\n", a.c_str());
+            return 2;
+        }
+    }
+    if (opt.imageKb == 0 || opt.imageKb * 1024 > (uint32_t)FW_MAX_GENERATIONS * FOUNTAIN_GEN_BYTES) {
+        fprintf(stderr, "image size must be 1..%u KB\n", (unsigned)(FW_MAX_GENERATIONS * FOUNTAIN_GEN_BYTES / 1024));
+        return 2;
+    }
+
+    bool header = true;
+    for (int n : opt.nodes) {
+        if (n < 1 || n > 250) {
+            fprintf(stderr, "node count must be 1..250\n");
+            return 2;
+        }
+        for (double p : opt.loss) {
+            FwSimulation sim(opt, n, p);
+            printResult(opt, sim.run(), header);
+            header = false;
+        }
+    }
+    return 0;
+}
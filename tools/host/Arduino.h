@@ -0,0 +1,168 @@
+/*
+ Project Name ------  FRS
+ Task --------------  Escalator Node Firmware with Esp32
+ Engineer ----------- Muhammad Usman
+ File --------------- Host Arduino Core Header File
+ Company -----------  Machadev Pvt Limited
+ */
+
+// Arduino.h (host build)
+#ifndef HOST_ARDUINO_H
+#define HOST_ARDUINO_H
+
+#include <stdarg.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <string>
+
+#include "host_hooks.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "freertos/semphr.h"
+
+#define HIGH 0x1
+#define LOW  0x0
+#define INPUT  0x01
+#define OUTPUT 0x03
+#define DEC 10
+#define HEX 16
+
+#define PROGMEM
+#define PGM_P const char*
+#define strlen_P strlen
+
+class __FlashStringHelper;
+#define F(string_literal) (reinterpret_cast<const __FlashStringHelper*>(string_literal))
+
+inline unsigned long millis() { return (unsigned long)(hostMicros() / 1000); }
+inline unsigned long micros() { return (unsigned long)hostMicros(); }
+inline void delay(uint32_t ms) { hostDelay(ms); }
+inline void yield() {}
+inline void pinMode(uint8_t, uint8_t) {}
+inline void digitalWrite(uint8_t pin, uint8_t value) { hostDigitalWrite(pin, value); }
+inline int digitalRead(uint8_t) { return HIGH; }
+uint32_t esp_random();   // host_shims.cpp
+
+// Subset of the Arduino String used by the node sources and ArduinoJson.
+class String {
+public:
+    String() {}
+    String(const char* s) : str(s ? s : "") {}
+    String(const char* s, size_t len) : str(s, len) {}
+    String(const std::string& s) : str(s) {}
+    String(char c) : str(1, c) {}
+    String(int value) : str(std::to_string(value)) {}
+    String(unsigned int value) : str(std::to_string(value)) {}
+    String(long value) : str(std::to_string(value)) {}
+    String(unsigned long value) : str(std::to_string(value)) {}
+
+    const char* c_str() const { return str.c_str(); }
+    unsigned int length() const { return (unsigned int)str.size(); }
+    bool reserve(unsigned int size) { str.reserve(size); return true; }
+    bool concat(const char* s) { str += s; return true; }
+    bool concat(const char* s, unsigned int len) { str.append(s, len); return true; }
+    bool concat(char c) { str += c; return true; }
+    bool concat(const String& s) { str += s.str; return true; }
+    String& operator+=(const char* s) { str += s; return *this; }
+    String& operator+=(const String& s) { str += s.str; return *this; }
+    String& operator+=(char c) { str += c; return *this; }
+    char operator[](unsigned int i) const { return str[i]; }
+    bool operator==(const char* s) const { return str == s; }
+    bool operator==(const String& s) const { return str == s.str; }
+    bool operator!=(const char* s) const { return str != s; }
+    bool startsWith(const String& prefix) const { return str.compare(0, prefix.str.size(), prefix.str) == 0; }
+    bool endsWith(const String& suffix) const {
+        return str.size() >= suffix.str.size() &&
+               str.compare(str.size() - suffix.str.size(), suffix.str.size(), suffix.str) == 0;
+    }
+    int indexOf(char c) const { size_t p = str.find(c); return p == std::string::npos ? -1 : (int)p; }
+    String substring(unsigned int from) const { return String(str.substr(from)); }
+    String substring(unsigned int from, unsigned int to) const { return String(str.substr(from, to - from)); }
+    long toInt() const { return strtol(str.c_str(), nullptr, 10); }
+
+private:
+    std::string str;
+};
+
+inline String operator+(const String& a, const String& b) { String r(a); r += b; return r; }
+inline String operator+(const String& a, const char* b) { String r(a); r += b; return r; }
+
+class Print {
+public:
+    virtual ~Print() {}
+    virtual size_t write(uint8_t c) = 0;
+    virtual size_t write(const uint8_t* buffer, size_t size) {
+        for (size_t i = 0; i < size; i++) write(buffer[i]);
+        return size;
+    }
+    size_t write(const char* s) { return write((const uint8_t*)s, strlen(s)); }
+
+    size_t print(const char* s) { return write(s); }
+    size_t print(const String& s) { return write((const uint8_t*)s.c_str(), s.length()); }
+    size_t print(const __FlashStringHelper* s) { return write(reinterpret_cast<const char*>(s)); }
+    size_t print(char c) { return write((uint8_t)c); }
+    size_t print(unsigned char n, int base = DEC) { return print((unsigned long)n, base); }
+    size_t print(int n, int base = DEC) { return print((long)n, base); }
+    size_t print(unsigned int n, int base = DEC) { return print((unsigned long)n, base); }
+    size_t print(long n, int base = DEC) { return base == DEC ? printf("%ld", n) : print((unsigned long)n, base); }
+    size_t print(unsigned long n, int base = DEC) { return printf(base == HEX ? "%lx" : "%lu", n); }
+    size_t print(long long n, int base = DEC) { return print((long)n, base); }
+    size_t print(unsigned long long n, int base = DEC) { return print((unsigned long)n, base); }
+    size_t print(double n, int digits = 2) { return printf("%.*f", digits, n); }
+
+    template<typename T> size_t println(T value) { size_t n = print(value); return n + println(); }
+    template<typename T> size_t println(T value, int format) { size_t n = print(value, format); return n + println(); }
+    size_t println() { return write("\r\n"); }
+
+    size_t printf(const char* format, ...) __attribute__((format(printf, 2, 3))) {
+        char buf[256];
+        va_list args;
+        va_start(args, format);
+        int n = vsnprintf(buf, sizeof(buf), format, args);
+        va_end(args);
+        if (n < 0) return 0;
+        return write((const uint8_t*)buf, (size_t)n < sizeof(buf) ? (size_t)n : sizeof(buf) - 1);
+    }
+};
+
+class Stream : public Print {
+public:
+    virtual int available() { return 0; }
+    virtual int read() { return -1; }
+    virtual int peek() { return -1; }
+    virtual void flush() {}
+};
+
+class HardwareSerial : public Stream {
+public:
+    explicit HardwareSerial(bool console) : console(console) {}
+    void begin(unsigned long) {}
+    void end() {}
+    using Print::write;
+    size_t write(uint8_t c) override { return write(&c, 1); }
+    size_t write(const uint8_t* buffer, size_t size) override {
+        if (console) hostSerialWrite(buffer, size);
+        return size;
+    }
+    operator bool() const { return true; }
+
+private:
+    bool console;
+};
+
+extern HardwareSerial Serial;
+extern HardwareSerial Serial2;
+
+class EspClass {
+public:
+    uint32_t getFreeHeap() { return 200000; }
+    uint32_t getMinFreeHeap() { return 180000; }
+    void restart() { exit(0); }
+};
+
+extern EspClass ESP;
+
+#endif // HOST_ARDUINO_H
@@ -0,0 +1,23 @@
+/*
+ Project Name ------  FRS
+ Task --------------  Escalator Node Firmware with Esp32
+ Engineer ----------- Muhammad Usman
+ File --------------- Host EEPROM Header File
+ Company -----------  Machadev Pvt Limited
+ */
+
+// EEPROM.h (host build)
+#ifndef HOST_EEPROM_H
+#define HOST_EEPROM_H
+
+#include <Arduino.h>
+
+class EEPROMClass {
+public:
+    bool begin(size_t) { return true; }
+    bool commit() { return true; }
+};
+
+extern EEPROMClass EEPROM;
+
+#endif // HOST_EEPROM_H
@@ -0,0 +1,46 @@
+/*
+ Project Name ------  FRS
+ Task --------------  Escalator Node Firmware with Esp32
+ Engineer ----------- Muhammad Usman
+ File --------------- Host File System Header File
+ Company -----------  Machadev Pvt Limited
+ */
+
+// FS.h (host build)
+#ifndef HOST_FS_H
+#define HOST_FS_H
+
+#include <Arduino.h>
+
+// A file of the host directory that stands in for the SPIFFS image (data/).
+class File : public Stream {
+public:
+    File() : fp(nullptr) {}
+    explicit File(FILE* fp) : fp(fp) {}
+    operator bool() const { return fp != nullptr; }
+    size_t size() const {
+        if (!fp) return 0;
+        long here = ftell(fp);
+        fseek(fp, 0, SEEK_END);
+        long end = ftell(fp);
+        fseek(fp, here, SEEK_SET);
+        return (size_t)end;
+    }
+    int available() override {
+        if (!fp) return 0;
+        return (int)(size() - (size_t)ftell(fp));
+    }
+    int read() override { return fp ? fgetc(fp) : -1; }
+    size_t read(uint8_t* buf, size_t size) { return fp ? fread(buf, 1, size, fp) : 0; }
+    using Print::write;
+    size_t write(uint8_t c) override { return fp ? (fputc(c, fp) == EOF ? 0 : 1) : 0; }
+    void close() {
+        if (fp) fclose(fp);
+        fp = nullptr;
+    }
+
+private:
+    FILE* fp;
+};
+
+#endif // HOST_FS_H
@@ -0,0 +1,50 @@
+/*
+ Project Name ------  FRS
+ Task --------------  Escalator Node Firmware with Esp32
+ Engineer ----------- Muhammad Usman
+ File --------------- Host RHMesh Header File
+ Company -----------  Machadev Pvt Limited
+ */
+
+// RHMesh.h (host build)
+#ifndef HOST_RHMESH_H
+#define HOST_RHMESH_H
+
+#include "RH_E32.h"
+
+#define RH_MAX_MESSAGE_LEN 255
+#define RH_MESH_MAX_MESSAGE_LEN (RH_MAX_MESSAGE_LEN - 6)
+
+#define RH_ROUTER_ERROR_NONE              0
+#define RH_ROUTER_ERROR_INVALID_LENGTH    1
+#define RH_ROUTER_ERROR_NO_ROUTE          2
+#define RH_ROUTER_ERROR_TIMEOUT           3
+#define RH_ROUTER_ERROR_NO_REPLY          4
+#define RH_ROUTER_ERROR_UNABLE_TO_DELIVER 5
+
+class RHMesh {
+public:
+    RHMesh(RH_E32& driver, uint8_t thisAddress) { (void)driver; (void)thisAddress; }
+    bool init() { return true; }
+    uint8_t thisAddress() const { return hostRadioAddress(); }
+    uint8_t sendtoWait(uint8_t* buf, uint8_t len, uint8_t address, uint8_t flags = 0) {
+        (void)flags;
+        return hostRadioSend(buf, len, address);
+    }
+    bool recvfromAckTimeout(uint8_t* buf, uint8_t* len, uint16_t timeout, uint8_t* source = nullptr,
+                            uint8_t* dest = nullptr, uint8_t* id = nullptr, uint8_t* flags = nullptr,
+                            uint8_t* hops = nullptr) {
+        uint8_t from = 0;
+        bool ok = hostRadioRecv(buf, len, timeout, &from);
+        if (ok) {
+            if (source) *source = from;
+            if (dest) *dest = hostRadioAddress();
+            if (id) *id = 0;
+            if (flags) *flags = 0;
+            if (hops) *hops = 0;
+        }
+        return ok;
+    }
+};
+
+#endif // HOST_RHMESH_H
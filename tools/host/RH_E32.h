@@ -0,0 +1,30 @@
+/*
+ Project Name ------  FRS
+ Task --------------  Escalator Node Firmware with Esp32
+ Engineer ----------- Muhammad Usman
+ File --------------- Host RH_E32 Header File
+ Company -----------  Machadev Pvt Limited
+ */
+
+// RH_E32.h (host build)
+#ifndef HOST_RH_E32_H
+#define HOST_RH_E32_H
+
+#include <Arduino.h>
+
+#define RH_BROADCAST_ADDRESS 0xff
+#define RH_E32_MAX_PAYLOAD_LEN 58
+#define RH_E32_HEADER_LEN 4
+#define RH_E32_MAX_MESSAGE_LEN (RH_E32_MAX_PAYLOAD_LEN - RH_E32_HEADER_LEN)
+
+// The radio itself lives in the host program behind hostRadioSend/Recv.
+class RH_E32 {
+public:
+    RH_E32(Stream* s, uint8_t m0Pin, uint8_t m1Pin, uint8_t auxPin) {
+        (void)s; (void)m0Pin; (void)m1Pin; (void)auxPin;
+    }
+    bool init() { return true; }
+    uint8_t maxMessageLength() { return RH_E32_MAX_MESSAGE_LEN; }
+};
+
+#endif // HOST_RH_E32_H
@@ -0,0 +1,38 @@
+/*
+ Project Name ------  FRS
+ Task --------------  Escalator Node Firmware with Esp32
+ Engineer ----------- Muhammad Usman
+ File --------------- Host SPIFFS Header File
+ Company -----------  Machadev Pvt Limited
+ */
+
+// SPIFFS.h (host build)
+#ifndef HOST_SPIFFS_H
+#define HOST_SPIFFS_H
+
+#include "FS.h"
+
+// Paths resolve below root, "data" by default, so "/portal.html" is data/portal.html.
+class SPIFFSFS {
+public:
+    SPIFFSFS() : root("data") {}
+    bool begin(bool formatOnFail = false) { (void)formatOnFail; return true; }
+    void setRoot(const char* dir) { root = dir; }
+    bool exists(const String& path) {
+        FILE* fp = fopen(resolve(path).c_str(), "rb");
+        if (fp) fclose(fp);
+        return fp != nullptr;
+    }
+    File open(const String& path, const char* mode = "r") {
+        std::string m = mode[0] == 'r' ? "rb" : mode[0] == 'a' ? "ab" : "wb";
+        return File(fopen(resolve(path).c_str(), m.c_str()));
+    }
+
+private:
+    std::string resolve(const String& path) const { return root + path.c_str(); }
+    std::string root;
+};
+
+extern SPIFFSFS SPIFFS;
+
+#endif // HOST_SPIFFS_H
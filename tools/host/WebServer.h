@@ -0,0 +1,95 @@
+/*
+ Project Name ------  FRS
+ Task --------------  Escalator Node Firmware with Esp32
+ Engineer ----------- Muhammad Usman
+ File --------------- Host WebServer Header File
+ Company -----------  Machadev Pvt Limited
+ */
+
+// WebServer.h (host build)
+#ifndef HOST_WEBSERVER_H
+#define HOST_WEBSERVER_H
+
+#include <Arduino.h>
+#include "FS.h"
+#include <functional>
+#include <map>
+
+enum HTTPMethod { HTTP_ANY, HTTP_GET, HTTP_HEAD, HTTP_POST, HTTP_PUT, HTTP_PATCH, HTTP_DELETE, HTTP_OPTIONS };
+
+#define CONTENT_LENGTH_UNKNOWN ((size_t)-1)
+
+/*
+ No sockets: a host program sets up a request with hostRequest(), calls
+ the handler directly and reads the captured response from responseCode,
+ responseType and responseBody.
+*/
+class WebServer {
+public:
+    typedef std::function<void(void)> THandlerFunction;
+
+    explicit WebServer(int port = 80) : responseCode(0), requestMethod(HTTP_GET) { (void)port; }
+
+    void on(const String& uri, HTTPMethod method, THandlerFunction fn) { (void)uri; (void)method; (void)fn; }
+    template<typename FS> void serveStatic(const char* uri, FS& fs, const char* path, const char* cacheHeader = nullptr) {
+        (void)uri; (void)fs; (void)path; (void)cacheHeader;
+    }
+    void begin() {}
+    void handleClient() {}
+
+    HTTPMethod method() const { return requestMethod; }
+    String arg(const String& name) const {
+        auto it = args.find(name.c_str());
+        return it == args.end() ? String() : String(it->second);
+    }
+    bool hasArg(const String& name) const { return args.count(name.c_str()) > 0; }
+
+    void send(int code, const char* contentType = nullptr, const String& content = String()) {
+        responseCode = code;
+        responseType = contentType ? contentType : "";
+        responseBody = content.c_str();
+    }
+    void send(int code, const String& contentType, const String& content) {
+        send(code, contentType.c_str(), content);
+    }
+    void setContentLength(size_t length) { (void)length; }
+    void sendHeader(const String& name, const String& value, bool first = false) {
+        (void)name; (void)value; (void)first;
+    }
+    void sendContent(const String& content) { responseBody += content.c_str(); }
+    void sendContent(const char* content, size_t length) { responseBody.append(content, length); }
+    void sendContent_P(const char* content) { responseBody += content; }
+    void sendContent_P(const char* content, size_t length) { responseBody.append(content, length); }
+    template<typename T> size_t streamFile(T& file, const String& contentType) {
+        responseCode = 200;
+        responseType = contentType.c_str();
+        size_t sent = 0;
+        int c;
+        while ((c = file.read()) >= 0) {
+            responseBody += (char)c;
+            sent++;
+        }
+        return sent;
+    }
+
+    // Host side
+    void hostRequest(HTTPMethod method, const char* body) {
+        requestMethod = method;
+        args.clear();
+        if (body) args["plain"] = body;
+        responseCode = 0;
+        responseType.clear();
+        responseBody.clear();
+    }
+    void hostSetArg(const char* name, const char* value) { args[name] = value; }
+
+    int responseCode;
+    std::string responseType;
+    std::string responseBody;
+
+private:
+    HTTPMethod requestMethod;
+    std::map<std::string, std::string> args;
+};
+
+#endif // HOST_WEBSERVER_H
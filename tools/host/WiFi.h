@@ -0,0 +1,18 @@
+/*
+ Project Name ------  FRS
+ Task --------------  Escalator Node Firmware with Esp32
+ Engineer ----------- Muhammad Usman
+ File --------------- Host WiFi Header File
+ Company -----------  Machadev Pvt Limited
+ */
+
+// WiFi.h (host build)
+#ifndef HOST_WIFI_H
+#define HOST_WIFI_H
+
+#include <Arduino.h>
+
+// The node sources only include WiFi.h; setup() in main.cpp, which is not
+// built on the host, is the only user.
+
+#endif // HOST_WIFI_H
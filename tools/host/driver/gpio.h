@@ -0,0 +1,27 @@
+/*
+ Project Name ------  FRS
+ Task --------------  Escalator Node Firmware with Esp32
+ Engineer ----------- Muhammad Usman
+ File --------------- Host GPIO Driver Header File
+ Company -----------  Machadev Pvt Limited
+ */
+
+// driver/gpio.h (host build)
+#ifndef HOST_DRIVER_GPIO_H
+#define HOST_DRIVER_GPIO_H
+
+#include <esp_partition.h>
+
+// Wake-up sources only; pins are driven through digitalWrite().
+
+typedef int gpio_num_t;
+
+typedef enum {
+    GPIO_INTR_LOW_LEVEL = 4,
+    GPIO_INTR_HIGH_LEVEL = 5,
+} gpio_int_type_t;
+
+inline esp_err_t gpio_wakeup_enable(gpio_num_t, gpio_int_type_t) { return ESP_OK; }
+inline esp_err_t gpio_wakeup_disable(gpio_num_t) { return ESP_OK; }
+
+#endif // HOST_DRIVER_GPIO_H
@@ -0,0 +1,70 @@
+/*
+ Project Name ------  FRS
+ Task --------------  Escalator Node Firmware with Esp32
+ Engineer ----------- Muhammad Usman
+ File --------------- Host UART Driver Header File
+ Company -----------  Machadev Pvt Limited
+ */
+
+// driver/uart.h (host build)
+#ifndef HOST_DRIVER_UART_H
+#define HOST_DRIVER_UART_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include <esp_partition.h>
+#include "../freertos/FreeRTOS.h"
+
+// The host radio lives behind hostRadioSend/Recv at the RHMesh level, so
+// the UART installs fine, never receives and swallows what is written.
+
+typedef int uart_port_t;
+#define UART_NUM_2 2
+#define UART_PIN_NO_CHANGE (-1)
+
+typedef enum { UART_DATA_8_BITS = 3 } uart_word_length_t;
+typedef enum { UART_PARITY_DISABLE = 0 } uart_parity_t;
+typedef enum { UART_STOP_BITS_1 = 1 } uart_stop_bits_t;
+typedef enum { UART_HW_FLOWCTRL_DISABLE = 0 } uart_hw_flowcontrol_t;
+typedef enum { UART_SCLK_APB = 0 } uart_sclk_t;
+
+typedef struct {
+    int baud_rate;
+    uart_word_length_t data_bits;
+    uart_parity_t parity;
+    uart_stop_bits_t stop_bits;
+    uart_hw_flowcontrol_t flow_ctrl;
+    uint8_t rx_flow_ctrl_thresh;
+    uart_sclk_t source_clk;
+} uart_config_t;
+
+typedef enum {
+    UART_DATA,
+    UART_BREAK,
+    UART_BUFFER_FULL,
+    UART_FIFO_OVF,
+    UART_FRAME_ERR,
+    UART_PARITY_ERR,
+} uart_event_type_t;
+
+typedef struct {
+    uart_event_type_t type;
+    size_t size;
+    bool timeout_flag;
+} uart_event_t;
+
+inline esp_err_t uart_driver_install(uart_port_t, int, int, int, QueueHandle_t* queue, int) {
+    *queue = (QueueHandle_t)1;
+    return ESP_OK;
+}
+inline esp_err_t uart_driver_delete(uart_port_t) { return ESP_OK; }
+inline esp_err_t uart_param_config(uart_port_t, const uart_config_t*) { return ESP_OK; }
+inline esp_err_t uart_set_pin(uart_port_t, int, int, int, int) { return ESP_OK; }
+inline esp_err_t uart_set_rx_timeout(uart_port_t, uint8_t) { return ESP_OK; }
+inline esp_err_t uart_get_buffered_data_len(uart_port_t, size_t* size) { *size = 0; return ESP_OK; }
+inline int uart_read_bytes(uart_port_t, void*, uint32_t, TickType_t) { return 0; }
+inline int uart_write_bytes(uart_port_t, const void*, size_t size) { return (int)size; }
+inline esp_err_t uart_wait_tx_done(uart_port_t, TickType_t) { return ESP_OK; }
+inline esp_err_t uart_flush_input(uart_port_t) { return ESP_OK; }
+
+#endif // HOST_DRIVER_UART_H
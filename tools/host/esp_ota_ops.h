@@ -0,0 +1,21 @@
+/*
+ Project Name ------  FRS
+ Task --------------  Escalator Node Firmware with Esp32
+ Engineer ----------- Muhammad Usman
+ File --------------- Host OTA Header File
+ Company -----------  Machadev Pvt Limited
+ */
+
+// esp_ota_ops.h (host build)
+#ifndef HOST_ESP_OTA_OPS_H
+#define HOST_ESP_OTA_OPS_H
+
+#include <esp_partition.h>
+
+// The host always runs from app0, so the next update partition is app1.
+const esp_partition_t* esp_ota_get_next_update_partition(const esp_partition_t* startFrom);
+const esp_partition_t* esp_ota_get_running_partition(void);
+esp_err_t esp_ota_set_boot_partition(const esp_partition_t* partition);
+const esp_partition_t* esp_ota_get_boot_partition(void);
+
+#endif // HOST_ESP_OTA_OPS_H
@@ -0,0 +1,69 @@
+/*
+ Project Name ------  FRS
+ Task --------------  Escalator Node Firmware with Esp32
+ Engineer ----------- Muhammad Usman
+ File --------------- Host Partition Source File
+ Company -----------  Machadev Pvt Limited
+ */
+
+// Import Libraries
+#include <esp_partition.h>
+#include <stdlib.h>
+#include <string.h>
+
+// Mirrors partitions.csv; buffers are allocated (erased) on first use.
+static esp_partition_t partitions[] = {
+    { ESP_PARTITION_TYPE_APP,  ESP_PARTITION_SUBTYPE_APP_OTA_0, 0x10000,  0x140000, "app0",     false, nullptr },
+    { ESP_PARTITION_TYPE_APP,  ESP_PARTITION_SUBTYPE_APP_OTA_1, 0x150000, 0x140000, "app1",     false, nullptr },
+    { ESP_PARTITION_TYPE_DATA, 0x40,                            0x3D0000, 0x2000,   "siterec",  false, nullptr },
+    { ESP_PARTITION_TYPE_DATA, 0x41,                            0x3D2000, 0xE000,   "journal",  false, nullptr },
+};
+
+const esp_partition_t* esp_partition_find_first(esp_partition_type_t type, uint8_t subtype, const char* label) {
+    for (auto& p : partitions) {
+        if (p.type != type) continue;
+        if (subtype != ESP_PARTITION_SUBTYPE_ANY && p.subtype != subtype) continue;
+        if (label != nullptr && strcmp(p.label, label) != 0) continue;
+        if (p.data == nullptr) {
+            p.data = (uint8_t*)malloc(p.size);
+            memset(p.data, 0xFF, p.size);
+        }
+        return &p;
+    }
+    return nullptr;
+}
+
+esp_err_t esp_partition_read(const esp_partition_t* partition, size_t offset, void* dst, size_t size) {
+    if (offset + size > partition->size) return ESP_ERR_INVALID_SIZE;
+    memcpy(dst, partition->data + offset, size);
+    return ESP_OK;
+}
+
+esp_err_t esp_partition_write(const esp_partition_t* partition, size_t offset, const void* src, size_t size) {
+    if (offset + size > partition->size) return ESP_ERR_INVALID_SIZE;
+    const uint8_t* bytes = (const uint8_t*)src;
+    for (size_t i = 0; i < size; i++) {
+        partition->data[offset + i] &= bytes[i];
+    }
+    return ESP_OK;
+}
+
+esp_err_t esp_partition_erase_range(const esp_partition_t* partition, size_t offset, size_t size) {
+    if (offset % 4096 != 0 || size % 4096 != 0 || offset + size > partition->size) return ESP_ERR_INVALID_ARG;
+    memset(partition->data + offset, 0xFF, size);
+    return ESP_OK;
+}
+
+esp_err_t esp_partition_mmap(const esp_partition_t* partition, size_t offset, size_t size,
+                             esp_partition_mmap_memory_t memory, const void** outPtr,
+                             spi_flash_mmap_handle_t* outHandle) {
+    (void)memory;
+    if (offset + size > partition->size) return ESP_ERR_INVALID_SIZE;
+    *outPtr = partition->data + offset;
+    *outHandle = 1;
+    return ESP_OK;
+}
+
+void spi_flash_munmap(spi_flash_mmap_handle_t handle) {
+    (void)handle;
+}
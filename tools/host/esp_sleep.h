@@ -0,0 +1,51 @@
+/*
+ Project Name ------  FRS
+ Task --------------  Escalator Node Firmware with Esp32
+ Engineer ----------- Muhammad Usman
+ File --------------- Host ESP Sleep Header File
+ Company -----------  Machadev Pvt Limited
+ */
+
+// esp_sleep.h (host build)
+#ifndef HOST_ESP_SLEEP_H
+#define HOST_ESP_SLEEP_H
+
+#include <stdint.h>
+#include "host_hooks.h"
+#include <esp_partition.h>
+
+// Light sleep ends in hostLightSleep(): the timer, or a frame arriving
+// for the node, which stands in for the E32 pulling AUX low.
+
+typedef enum {
+    ESP_SLEEP_WAKEUP_UNDEFINED = 0,
+    ESP_SLEEP_WAKEUP_TIMER = 4,
+    ESP_SLEEP_WAKEUP_GPIO = 7,
+} esp_sleep_source_t;
+
+inline uint64_t& hostSleepTimerUs() {
+    static uint64_t us = 0;
+    return us;
+}
+
+inline esp_sleep_source_t& hostSleepCause() {
+    static esp_sleep_source_t cause = ESP_SLEEP_WAKEUP_UNDEFINED;
+    return cause;
+}
+
+inline esp_err_t esp_sleep_enable_timer_wakeup(uint64_t us) {
+    hostSleepTimerUs() = us;
+    return ESP_OK;
+}
+
+inline esp_err_t esp_sleep_enable_gpio_wakeup() { return ESP_OK; }
+
+inline esp_err_t esp_light_sleep_start() {
+    uint32_t ms = (uint32_t)(hostSleepTimerUs() / 1000);
+    hostSleepCause() = hostLightSleep(ms) ? ESP_SLEEP_WAKEUP_GPIO : ESP_SLEEP_WAKEUP_TIMER;
+    return ESP_OK;
+}
+
+inline esp_sleep_source_t esp_sleep_get_wakeup_cause() { return hostSleepCause(); }
+
+#endif // HOST_ESP_SLEEP_H
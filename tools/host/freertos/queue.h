@@ -0,0 +1,19 @@
+/*
+ Project Name ------  FRS
+ Task --------------  Escalator Node Firmware with Esp32
+ Engineer ----------- Muhammad Usman
+ File --------------- Host FreeRTOS Queue Header File
+ Company -----------  Machadev Pvt Limited
+ */
+
+// freertos/queue.h (host build)
+#ifndef HOST_FREERTOS_QUEUE_H
+#define HOST_FREERTOS_QUEUE_H
+
+#include "FreeRTOS.h"
+
+// Nothing is ever posted on the host, so a receive finds the queue empty.
+inline BaseType_t xQueueReceive(QueueHandle_t, void*, TickType_t) { return pdFALSE; }
+inline BaseType_t xQueueReset(QueueHandle_t) { return pdPASS; }
+
+#endif // HOST_FREERTOS_QUEUE_H
@@ -0,0 +1,34 @@
+/*
+ Project Name ------  FRS
+ Task --------------  Escalator Node Firmware with Esp32
+ Engineer ----------- Muhammad Usman
+ File --------------- Host FreeRTOS Task Header File
+ Company -----------  Machadev Pvt Limited
+ */
+
+// freertos/task.h (host build)
+#ifndef HOST_FREERTOS_TASK_H
+#define HOST_FREERTOS_TASK_H
+
+#include "FreeRTOS.h"
+#include "../host_hooks.h"
+
+typedef void (*TaskFunction_t)(void*);
+
+inline TaskHandle_t xTaskGetCurrentTaskHandle() { return (TaskHandle_t)1; }
+inline const char* pcTaskGetTaskName(TaskHandle_t) { return "host"; }
+inline UBaseType_t uxTaskPriorityGet(TaskHandle_t) { return 1; }
+inline UBaseType_t uxTaskGetStackHighWaterMark(TaskHandle_t) { return 0; }
+inline UBaseType_t uxTaskGetNumberOfTasks() { return 1; }
+inline void vTaskSuspend(TaskHandle_t) {}
+inline void vTaskResume(TaskHandle_t) {}
+inline void vTaskDelay(TickType_t ticks) { hostDelay(ticks); }
+
+// Background tasks are not run on the host; the node's own loops are driven by the host program.
+inline BaseType_t xTaskCreatePinnedToCore(TaskFunction_t, const char*, uint32_t, void*, UBaseType_t,
+                                          TaskHandle_t* handle, BaseType_t) {
+    if (handle != nullptr) *handle = nullptr;
+    return pdPASS;
+}
+
+#endif // HOST_FREERTOS_TASK_H
@@ -0,0 +1,49 @@
+/*
+ Project Name ------  FRS
+ Task --------------  Escalator Node Firmware with Esp32
+ Engineer ----------- Muhammad Usman
+ File --------------- Host Hooks Header File
+ Company -----------  Machadev Pvt Limited
+ */
+
+// host_hooks.h
+#ifndef HOST_HOOKS_H
+#define HOST_HOOKS_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+/*
+ The headers in tools/host stand in for the Arduino core, FreeRTOS,
+ RadioHead and ESP-IDF so that the unmodified node sources in src/ compile
+ natively. Everything that touches time, pins, the console or the radio
+ ends in one of these hooks, which each host program (simulator,
+ benchmark, replay) implements to suit itself.
+*/
+
+// Virtual clock seen by millis() / micros().
+uint64_t hostMicros();
+
+// Blocks the node for ms of virtual time (delay(), vTaskDelay()).
+void hostDelay(uint32_t ms);
+
+// Light sleep for up to ms (esp_light_sleep_start()); true if a frame for
+// the node woke it, as the E32's AUX line does.
+bool hostLightSleep(uint32_t ms);
+
+// Pin writes (relay, E32 M0/M1).
+void hostDigitalWrite(uint8_t pin, uint8_t value);
+
+// Bytes written to Serial (the debug console).
+void hostSerialWrite(const uint8_t* data, size_t len);
+
+// Address RHMesh reports for this node.
+uint8_t hostRadioAddress();
+
+// RHMesh::sendtoWait(); returns an RH_ROUTER_ERROR_* code.
+uint8_t hostRadioSend(const uint8_t* buf, uint8_t len, uint8_t dest);
+
+// RHMesh::recvfromAckTimeout(); len is in/out like RadioHead's.
+bool hostRadioRecv(uint8_t* buf, uint8_t* len, uint16_t timeout, uint8_t* from);
+
+#endif // HOST_HOOKS_H
@@ -0,0 +1,60 @@
+/*
+ Project Name ------  FRS
+ Task --------------  Escalator Node Firmware with Esp32
+ Engineer ----------- Muhammad Usman
+ File --------------- Host Shims Source File
+ Company -----------  Machadev Pvt Limited
+ */
+
+// Import Libraries
+#include <Arduino.h>
+#include <EEPROM.h>
+#include <SPIFFS.h>
+#include <WebServer.h>
+#include <esp_ota_ops.h>
+#include <esp_partition.h>
+
+HardwareSerial Serial(true);
+HardwareSerial Serial2(false);
+EspClass ESP;
+EEPROMClass EEPROM;
+SPIFFSFS SPIFFS;
+
+// Defined by main.cpp on the device; host programs drive it with hostRequest().
+WebServer server(80);
+
+static const esp_partition_t* bootPartition = nullptr;
+
+const esp_partition_t* esp_ota_get_next_update_partition(const esp_partition_t* startFrom) {
+    (void)startFrom;
+    return esp_partition_find_first(ESP_PARTITION_TYPE_APP, ESP_PARTITION_SUBTYPE_APP_OTA_1, nullptr);
+}
+
+const esp_partition_t* esp_ota_get_running_partition(void) {
+    return esp_partition_find_first(ESP_PARTITION_TYPE_APP, ESP_PARTITION_SUBTYPE_APP_OTA_0, nullptr);
+}
+
+esp_err_t esp_ota_set_boot_partition(const esp_partition_t* partition) {
+    if (partition == nullptr || partition->type != ESP_PARTITION_TYPE_APP) return ESP_ERR_INVALID_ARG;
+    bootPartition = partition;
+    return ESP_OK;
+}
+
+const esp_partition_t* esp_ota_get_boot_partition(void) {
+    if (bootPartition == nullptr) {
+        bootPartition = esp_partition_find_first(ESP_PARTITION_TYPE_APP, ESP_PARTITION_SUBTYPE_APP_OTA_0, nullptr);
+    }
+    return bootPartition;
+}
+
+// Hardware RNG stand-in: differs per node, and repeats from run to run.
+uint32_t esp_random() {
+    static uint32_t state = 0;
+    if (state == 0) {
+        state = 0x9E3779B9UL * (hostRadioAddress() + 1UL);
+    }
+    state ^= state << 13;
+    state ^= state >> 17;
+    state ^= state << 5;
+    return state;
+}
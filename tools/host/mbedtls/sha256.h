@@ -0,0 +1,29 @@
+/*
+ Project Name ------  FRS
+ Task --------------  Escalator Node Firmware with Esp32
+ Engineer ----------- Muhammad Usman
+ File --------------- Host SHA-256 Header File
+ Company -----------  Machadev Pvt Limited
+ */
+
+// mbedtls/sha256.h (host build)
+#ifndef HOST_MBEDTLS_SHA256_H
+#define HOST_MBEDTLS_SHA256_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+// Same calls as the mbedtls bundled with the ESP32 Arduino core; is224 must be 0.
+typedef struct {
+    uint32_t state[8];
+    uint64_t total;
+    uint8_t buffer[64];
+} mbedtls_sha256_context;
+
+void mbedtls_sha256_init(mbedtls_sha256_context* ctx);
+void mbedtls_sha256_free(mbedtls_sha256_context* ctx);
+void mbedtls_sha256_starts(mbedtls_sha256_context* ctx, int is224);
+void mbedtls_sha256_update(mbedtls_sha256_context* ctx, const unsigned char* input, size_t ilen);
+void mbedtls_sha256_finish(mbedtls_sha256_context* ctx, unsigned char output[32]);
+
+#endif // HOST_MBEDTLS_SHA256_H
@@ -0,0 +1,16 @@
+/*
+ Project Name ------  FRS
+ Task --------------  Escalator Node Firmware with Esp32
+ Engineer ----------- Muhammad Usman
+ File --------------- Host GPIO Register Header File
+ Company -----------  Machadev Pvt Limited
+ */
+
+// soc/gpio_reg.h (host build)
+#ifndef HOST_GPIO_REG_H
+#define HOST_GPIO_REG_H
+
+#define GPIO_OUT_W1TS_REG 0x3FF44008u
+#define GPIO_OUT_W1TC_REG 0x3FF4400Cu
+
+#endif // HOST_GPIO_REG_H
@@ -0,0 +1,32 @@
+/*
+ Project Name ------  FRS
+ Task --------------  Escalator Node Firmware with Esp32
+ Engineer ----------- Muhammad Usman
+ File --------------- Host SoC Register Header File
+ Company -----------  Machadev Pvt Limited
+ */
+
+// soc/soc.h (host build)
+#ifndef HOST_SOC_H
+#define HOST_SOC_H
+
+#include <stdint.h>
+#include "host_hooks.h"
+#include "gpio_reg.h"
+
+// Only the GPIO set/clear registers are modelled; each set bit becomes a
+// pin write so host programs see the same events as with digitalWrite().
+inline void hostRegWrite(uint32_t reg, uint32_t value) {
+    if (reg != GPIO_OUT_W1TS_REG && reg != GPIO_OUT_W1TC_REG) {
+        return;
+    }
+    for (uint8_t pin = 0; pin < 32; pin++) {
+        if (value & (1u << pin)) {
+            hostDigitalWrite(pin, reg == GPIO_OUT_W1TS_REG ? 1 : 0);
+        }
+    }
+}
+
+#define REG_WRITE(reg, value) hostRegWrite((reg), (value))
+
+#endif // HOST_SOC_H
@@ -0,0 +1,901 @@
+/*
+ Project Name ------  FRS
+ Task --------------  Escalator Node Firmware with Esp32
+ Engineer ----------- Muhammad Usman
+ File --------------- Mesh Simulator Source File
+ Company -----------  Machadev Pvt Limited
+
+Discrete-event mesh simulator:
+
+- Every escalator node is a forked process that runs the unmodified node
+  code from src/ (initializeSiteStore, initializeMESH, LoRatask) against the
+  host shims in tools/host.
+- The coordinator owns virtual time. A node runs only while the coordinator
+  waits for it, and stops at the next blocking radio call or delay.
+- The channel model covers E32 airtime (UART transfer + preamble + payload
+  at the air data rate, and the UART readout at the receiver), per-link loss, and collisions at each receiver.
+  Radios are half duplex.
+- Node 1 is the FyreBox controller: it only injects the "Active" alarm.
+  Like an escalator's report, the alarm waits for the next contention
+  slot of the lowest tree the controller hears, with the largest guard a
+  synced node still sends with, so no beacon or transfer is on the air.
+  Escalator nodes are 2..N+1. The mesh work duplicated in main.cpp loop()
+  is not modelled; only LoRatask runs.
+- Escalators are modelled as backup-powered nodes. On a wake-on-radio
+  build (src/power.h) every frame carries the wake-up preamble, and a
+  node in light sleep is woken by the first frame that reaches it.
+- Mean current per node is estimated from the time each node spends
+  awake, asleep and transmitting, with nominal datasheet currents
+  (--currents), not measured ones.
+- With --config-at the highest-numbered escalator writes the company
+  record as the portal would. The run reports when each node has merged
+  it, i.e. reports the same config digest, and how the fragment
+  transfers that carried it went.
+- Every beacon carries the sender's network time. The coordinator
+  compares it with the time in the root's own beacons at the same
+  virtual instant, and checks it against the error bound the beacon
+  claims. At the end it counts the roots the nodes follow against the
+  islands of escalators that can reach each other; each island should be
+  down to one root.
+
+Build and run:
+
+  pio run -e meshsim
+  .pio/build/meshsim/program --nodes 50 --topology random --degree 6 --loss 0.05
+  .pio/build/meshsim/program --sweep 4,16,50,100,200 --duration 1200 --csv
+
+The activation latency budget is a build parameter, so power against
+latency takes one build per budget:
+
+  PLATFORMIO_BUILD_FLAGS="-D FRS_WAKE_LATENCY_MS=1000" pio run -e meshsim
+
+Options (times in seconds):
+
+  --nodes N          escalator nodes (default 4, max 250)
+  --sweep a,b,c      run once per node count and print one row each
+  --topology T       full | line | grid | random (default random)
+  --degree D         mean neighbours for random (default 6)
+  --loss P           per-link frame loss probability (default 0)
+  --distance-loss    loss grows towards the edge of radio range
+  --air-rate BPS     E32 air data rate (default 2400)
+  --preamble MS      preamble + header airtime per frame (default 50)
+  --duration S       simulated time (default 900)
+  --alarm-at S       controller sends "Active" (default 300)
+  --kill K           nodes powered off at --kill-at (default 1)
+  --kill-at S        (default 400)
+  --boot-spread S    random boot offset per node (default 30)
+  --config-at S      a node writes the company record (default: never)
+  --seed N           random seed (default 1)
+  --currents a,s,r,t ESP32 awake, ESP32 light sleep, E32 receive, E32 transmit
+                     in mA (default 40,0.8,15,110)
+  --sniff MS         E32 receive time per wake-up period in power saving mode (default 5)
+  --csv              machine-readable output
+  --verbose          print every node's console output
+ */
+
+// Import Libraries
+#include <Arduino.h>
+#include <algorithm>
+#include <cmath>
+#include <deque>
+#include <queue>
+#include <random>
+#include <set>
+#include <map>
+#include <vector>
+#include <signal.h>
+#include <sys/socket.h>
+#include <sys/wait.h>
+#include <unistd.h>
+#include <RHMesh.h>
+#include "constants.h"
+#include "power.h"
+#include "protocol.h"
+#include "time_sync.h"
+#include "sim_protocol.h"
+#include "sim_node.h"
+
+struct SimOptions {
+    int nodes = 4;
+    std::vector<int> sweep;
+    std::string topology = "random";
+    double degree = 6;
+    double loss = 0;
+    bool distanceLoss = false;
+    double airRate = 2400;
+    double preambleMs = 50;
+    double uartBaud = 9600;
+    double durationS = 900;
+    double alarmAtS = 300;
+    int kill = 1;
+    double killAtS = 400;
+    double bootSpreadS = 30;
+    double configAtS = -1;
+    size_t inboxFrames = 4;   // frames the E32 + UART buffer can hold while the node is busy
+    uint32_t seed = 1;
+    double awakeMa = 40;      // ESP32 at 240 MHz, Wi-Fi off
+    double sleepMa = 0.8;     // ESP32 light sleep
+    double rxMa = 15;         // E32 receiving, normal or wake-up mode
+    double txMa = 110;        // E32 at 20 dBm
+    double sniffMs = 5;
+    bool csv = false;
+    bool verbose = false;
+};
+
+struct SimResult {
+    int nodes;
+    uint64_t frames;
+    uint64_t deliveries;
+    uint64_t collisions;
+    uint64_t lost;
+    uint64_t inboxDrops;
+    double utilisation;        // total airtime / duration
+    double neighbourhoodMean;  // offered load heard per node (Erlang)
+    double neighbourhoodMax;
+    int alarmTargets;
+    int alarmReached;
+    std::vector<double> alarmLatencyS;
+    int deadExpected;
+    std::vector<double> deadDetectS;
+    uint64_t falseDead;
+    int configTargets;
+    int configReached;
+    std::vector<double> configLatencyS;
+    uint64_t transfersOk;
+    uint64_t transfersFailed;
+    uint64_t transportFrames;  // fragments and ACKs on the air
+    std::vector<double> syncErrorMs;  // |network time - root's|, per synced beacon
+    uint64_t boundViolations;  // beacons whose error exceeded the bound they claimed
+    int rootsAtEnd;
+    int islandsAtEnd;          // groups of live escalators with no radio path between them; one root each at best
+    double awakeFraction;      // mean over the nodes that stayed up
+    double currentMeanMa;
+    double currentMaxMa;
+};
+
+class Simulation {
+public:
+    Simulation(const SimOptions& options, int nodes) : opt(options), nodeCount(nodes), rng(options.seed) {}
+    SimResult run();
+
+private:
+    enum Wait : uint8_t { WAIT_NONE, WAIT_START, WAIT_SEND, WAIT_RECV, WAIT_DELAY, WAIT_SLEEP };
+    enum EventType : uint8_t { EV_WAKE, EV_DELIVER, EV_ALARM, EV_KILL };
+
+    struct Frame {
+        uint8_t from;
+        std::vector<uint8_t> bytes;
+    };
+
+    struct Node {
+        uint8_t id;
+        pid_t pid = -1;
+        int fd = -1;
+        bool alive = true;
+        double x = 0, y = 0;
+        Wait wait = WAIT_NONE;
+        uint32_t token = 0;
+        uint8_t sendStatus = 0;
+        std::deque<Frame> inbox;
+        int64_t relayOnUs = -1;
+        uint64_t heardAirUs = 0;
+        uint64_t bootUs = 0;
+        uint64_t sleepStartUs = 0;
+        uint64_t sleptUs = 0;
+        uint64_t sentAirUs = 0;
+        uint64_t heardAsleepUs = 0;    // the E32 in power saving mode wakes for every preamble it hears
+        int64_t configUs = -1;         // when the node first reported the written config's digest
+        int lastRoot = -1;             // root named in the node's last beacon
+    };
+
+    struct Transmission {
+        int node;
+        uint64_t start;
+        uint64_t end;
+        std::vector<uint8_t> bytes;
+    };
+
+    struct Event {
+        uint64_t time;
+        uint64_t seq;
+        EventType type;
+        int node;
+        uint32_t token;
+        size_t tx;
+        bool operator>(const Event& o) const { return time != o.time ? time > o.time : seq > o.seq; }
+    };
+
+    void buildTopology();
+    void spawnNodes();
+    void stopNodes();
+    void schedule(uint64_t time, EventType type, int node, uint32_t token = 0, size_t tx = 0);
+    void scheduleWake(int node, uint64_t time);
+    uint64_t airtimeUs(size_t appLen) const;
+    size_t transmit(int node, const uint8_t* frame, size_t len, int onlyTo);
+    void deliver(size_t tx, int receiver);
+    void resume(int node, const uint8_t* result, uint16_t len);
+    bool readMessage(int node, SimHeader& header, uint8_t* payload);
+    void grant(int node, const uint8_t* result, uint16_t len);
+    void onDead(int observer, uint8_t deadId);
+    void onConfig(int node, uint32_t digest);
+    void onBeacon(int node, const uint8_t* frame, size_t len);
+    uint64_t untilAlarmSlotUs() const;
+    void estimatePower(uint64_t end);
+    bool linkLost(int a, int b);
+
+    const SimOptions& opt;
+    int nodeCount;
+    std::mt19937 rng;
+    uint64_t now = 0;
+    uint64_t seq = 0;
+    double range = 1.0;
+    std::vector<Node> nodes;                  // index 0 is the controller
+    std::vector<std::vector<char>> hears;     // hears[r][s]: r is in range of s
+    std::deque<Transmission> txs;
+    size_t txBase = 0;                        // index of txs.front()
+    uint64_t maxAirUs = 0;
+    std::priority_queue<Event, std::vector<Event>, std::greater<Event>> events;
+    std::set<uint8_t> killed;
+    std::map<std::pair<uint8_t, uint8_t>, double> detections;  // (dead, observer) -> seconds
+    uint64_t killTimeUs = 0;
+    int configWriter = 0;
+    bool configWritten = false;
+    uint32_t configDigest = 0;
+    uint64_t configWriteUs = 0;
+    std::map<uint8_t, double> rootOffsetMs;  // root ID -> its network time minus virtual time
+    SimResult result = {};
+};
+
+// Places nodes and computes who hears whom.
+void Simulation::buildTopology() {
+    int total = nodeCount + 1;
+    nodes.resize(total);
+    for (int i = 0; i < total; i++) {
+        nodes[i].id = (uint8_t)(i + 1);
+    }
+
+    if (opt.topology == "line") {
+        for (int i = 0; i < total; i++) nodes[i].x = i;
+        range = 1.0;
+    }
+    else if (opt.topology == "grid") {
+        int width = (int)std::ceil(std::sqrt((double)total));
+        for (int i = 0; i < total; i++) {
+            nodes[i].x = i % width;
+            nodes[i].y = i / width;
+        }
+        range = 1.0;
+    }
+    else if (opt.topology == "random") {
+        // Square sized so a node has opt.degree neighbours on average.
+        range = 1.0;
+        double side = std::sqrt(total * M_PI * range * range / std::max(opt.degree, 1.0));
+        std::uniform_real_distribution<double> pos(0, side);
+        nodes[0].x = nodes[0].y = side / 2;
+        for (int i = 1; i < total; i++) {
+            nodes[i].x = pos(rng);
+            nodes[i].y = pos(rng);
+        }
+    }
+    else {
+        range = INFINITY;  // full: everyone hears everyone
+    }
+
+    hears.assign(total, std::vector<char>(total, 0));
+    for (int a = 0; a < total; a++) {
+        for (int b = 0; b < total; b++) {
+            double d = std::hypot(nodes[a].x - nodes[b].x, nodes[a].y - nodes[b].y);
+            hears[a][b] = a != b && d <= range + 1e-9;
+        }
+    }
+}
+
+// Link loss: fixed probability, optionally rising towards the edge of range.
+bool Simulation::linkLost(int a, int b) {
+    double p = opt.loss;
+    if (opt.distanceLoss && std::isfinite(range)) {
+        double d = std::hypot(nodes[a].x - nodes[b].x, nodes[a].y - nodes[b].y) / range;
+        p = opt.loss + (1 - opt.loss) * std::pow(d, 4) * 0.5;
+    }
+    return std::uniform_real_distribution<double>(0, 1)(rng) < p;
+}
+
+// Forks one process per escalator node.
+void Simulation::spawnNodes() {
+    std::uniform_real_distribution<double> boot(0, opt.bootSpreadS * 1e6);
+    configWriter = opt.configAtS >= 0 ? nodeCount : 0;
+    uint64_t configAtUs = (uint64_t)(std::max(opt.configAtS, 0.0) * 1e6) + 1;  // 0 tells the node never
+    for (int i = 1; i <= nodeCount; i++) {
+        int fds[2];
+        if (socketpair(AF_UNIX, SOCK_STREAM, 0, fds) != 0) {
+            perror("socketpair");
+            exit(1);
+        }
+        nodes[i].bootUs = (uint64_t)boot(rng);
+        pid_t pid = fork();
+        if (pid == 0) {
+            close(fds[0]);
+            for (int j = 1; j < i; j++) close(nodes[j].fd);
+            simNodeMain(fds[1], nodes[i].id, opt.verbose, i == configWriter ? configAtUs : 0);
+        }
+        close(fds[1]);
+        nodes[i].pid = pid;
+        nodes[i].fd = fds[0];
+        nodes[i].wait = WAIT_START;
+        scheduleWake(i, nodes[i].bootUs);
+    }
+}
+
+void Simulation::stopNodes() {
+    for (auto& node : nodes) {
+        if (node.pid > 0) {
+            kill(node.pid, SIGKILL);
+            waitpid(node.pid, nullptr, 0);
+            close(node.fd);
+            node.pid = -1;
+        }
+    }
+}
+
+void Simulation::schedule(uint64_t time, EventType type, int node, uint32_t token, size_t tx) {
+    events.push({ time, seq++, type, node, token, tx });
+}
+
+// Any earlier wake-up of the node becomes stale.
+void Simulation::scheduleWake(int node, uint64_t time) {
+    schedule(time, EV_WAKE, node, ++nodes[node].token);
+}
+
+// UART transfer into the E32 plus preamble plus payload at the air data rate.
+uint64_t Simulation::airtimeUs(size_t appLen) const {
+    size_t onAir = appLen + 6 + 5;  // RHRouter + RHMesh headers, RH_E32 length + header
+    double uartUs = onAir * 10.0 * 1e6 / opt.uartBaud;
+    double airUs = (opt.preambleMs + WAKE_PERIOD_MS) * 1000 + onAir * 8.0 * 1e6 / opt.airRate;
+    return (uint64_t)(uartUs + airUs);
+}
+
+// Puts a frame on the air and schedules its end at every receiver in range.
+size_t Simulation::transmit(int node, const uint8_t* frame, size_t len, int onlyTo) {
+    uint64_t duration = airtimeUs(len);
+    uint64_t uartUs = (uint64_t)((len + 11) * 10.0 * 1e6 / opt.uartBaud);
+    Transmission tx = { node, now + uartUs, now + duration, std::vector<uint8_t>(frame, frame + len) };
+    txs.push_back(tx);
+    size_t index = txBase + txs.size() - 1;
+
+    result.frames++;
+    if (frame[0] == MSG_XFER_DATA || frame[0] == MSG_XFER_ACK) {
+        result.transportFrames++;
+    }
+    else if (frame[0] == MSG_PRESENCE && node != 0) {
+        onBeacon(node, frame, len);
+    }
+    double air = (double)(tx.end - tx.start);
+    result.utilisation += air;
+    nodes[node].sentAirUs += (uint64_t)air;
+    for (int r = 0; r <= nodeCount; r++) {
+        if (r == node || hears[r][node]) nodes[r].heardAirUs += (uint64_t)air;
+        if (hears[r][node] && nodes[r].wait == WAIT_SLEEP) nodes[r].heardAsleepUs += (uint64_t)air;
+        if (hears[r][node] && (onlyTo < 0 || r == onlyTo)) {
+            schedule(tx.end + uartUs, EV_DELIVER, r, 0, index);  // the receiving E32 hands it over the UART
+        }
+    }
+    return index;
+}
+
+// Decides at the end of a frame whether the receiver got it.
+void Simulation::deliver(size_t index, int receiver) {
+    const Transmission& tx = txs[index - txBase];
+    Node& r = nodes[receiver];
+    if (!r.alive || r.pid < 0) {
+        return;
+    }
+    for (size_t i = 0; i < txs.size(); i++) {
+        const Transmission& other = txs[i];
+        if (txBase + i == index || other.end <= tx.start || other.start >= tx.end) continue;
+        if (other.node == receiver || hears[receiver][other.node]) {
+            result.collisions++;  // half duplex, or two frames overlapping at this receiver
+            return;
+        }
+    }
+    if (linkLost(tx.node, receiver)) {
+        result.lost++;
+        return;
+    }
+    result.deliveries++;
+
+    Frame frame = { nodes[tx.node].id, tx.bytes };
+    if (r.wait == WAIT_RECV) {
+        uint8_t out[2 + 255];
+        out[0] = 1;
+        out[1] = frame.from;
+        memcpy(out + 2, frame.bytes.data(), frame.bytes.size());
+        resume(receiver, out, (uint16_t)(2 + frame.bytes.size()));
+    }
+    else if (r.wait == WAIT_SLEEP) {
+        r.inbox.push_back(frame);   // AUX goes low: the node wakes and reads it from the UART
+        r.sleptUs += now - r.sleepStartUs;
+        uint8_t byRadio = 1;
+        resume(receiver, &byRadio, 1);
+    }
+    else if (r.inbox.size() < opt.inboxFrames) {
+        r.inbox.push_back(frame);
+    }
+    else {
+        result.inboxDrops++;
+    }
+}
+
+bool Simulation::readMessage(int node, SimHeader& header, uint8_t* payload) {
+    int fd = nodes[node].fd;
+    size_t got = 0;
+    while (got < sizeof(header)) {
+        ssize_t n = read(fd, (uint8_t*)&header + got, sizeof(header) - got);
+        if (n <= 0) return false;
+        got += (size_t)n;
+    }
+    got = 0;
+    while (got < header.len) {
+        ssize_t n = read(fd, payload + got, header.len - got);
+        if (n <= 0) return false;
+        got += (size_t)n;
+    }
+    return true;
+}
+
+void Simulation::grant(int node, const uint8_t* data, uint16_t len) {
+    uint8_t buf[sizeof(SimHeader) + SIM_MAX_PAYLOAD];
+    SimHeader header = { SIM_GRANT, (uint16_t)(sizeof(uint64_t) + len) };
+    memcpy(buf, &header, sizeof(header));
+    memcpy(buf + sizeof(header), &now, sizeof(now));
+    if (len > 0) memcpy(buf + sizeof(header) + sizeof(now), data, len);
+    size_t total = sizeof(header) + header.len;
+    size_t sent = 0;
+    while (sent < total) {
+        ssize_t n = write(nodes[node].fd, buf + sent, total - sent);
+        if (n <= 0) return;
+        sent += (size_t)n;
+    }
+}
+
+// Records a node's "is now considered dead" report.
+void Simulation::onDead(int observer, uint8_t deadId) {
+    if (killed.count(deadId) == 0) {
+        result.falseDead++;  // a live node missed enough beacons to be declared dead
+        return;
+    }
+    auto key = std::make_pair(deadId, nodes[observer].id);
+    if (detections.count(key) == 0) {
+        detections[key] = (now - killTimeUs) / 1e6;
+    }
+}
+
+// The writer's report sets the digest every other node has to reach.
+void Simulation::onConfig(int node, uint32_t digest) {
+    if (node == configWriter && !configWritten) {
+        configWritten = true;
+        configDigest = digest;
+        configWriteUs = now;
+    }
+    if (configWritten && digest == configDigest && nodes[node].configUs < 0) {
+        nodes[node].configUs = (int64_t)now;
+    }
+}
+
+// Compares the network time in a beacon with the root's at this virtual instant.
+// The node stamps the beacon as it hands it to the radio, which is now.
+void Simulation::onBeacon(int node, const uint8_t* frame, size_t len) {
+    if (len < 1 + TIME_SYNC_LEN) return;
+    const uint8_t* sync = frame + 1;
+    uint32_t netMs = (uint32_t)sync[0] | ((uint32_t)sync[1] << 8) | ((uint32_t)sync[2] << 16) |
+                     ((uint32_t)sync[3] << 24);
+    uint16_t bound = (uint16_t)(sync[4] | (sync[5] << 8));
+    uint8_t root = sync[6];
+    double offset = netMs - now / 1000.0;
+    nodes[node].lastRoot = root;
+    if (root == nodes[node].id) {
+        rootOffsetMs[root] = offset;
+        return;
+    }
+    auto ref = rootOffsetMs.find(root);
+    if (bound == TIME_SYNC_UNBOUNDED || ref == rootOffsetMs.end()) return;
+    double error = std::fabs(offset - ref->second);
+    result.syncErrorMs.push_back(error);
+    if (error > bound + 1) result.boundViolations++;   // 1 ms for millis() rounding
+}
+
+// Time to the controller's next contention slot, in the lowest tree among the nodes it hears.
+uint64_t Simulation::untilAlarmSlotUs() const {
+    int root = -1;
+    for (int i = 1; i <= nodeCount; i++) {
+        int r = nodes[i].lastRoot;
+        if (hears[0][i] && nodes[i].alive && r >= 0 && rootOffsetMs.count((uint8_t)r) != 0 && (root < 0 || r < root)) {
+            root = r;
+        }
+    }
+    if (root < 0) return 0;   // no tree yet, send straight away
+    double netMs = std::fmod(now / 1000.0 + rootOffsetMs.at((uint8_t)root), (double)TIME_SYNC_EPOCH_MS);
+    if (netMs < 0) netMs += TIME_SYNC_EPOCH_MS;
+    return (uint64_t)TdmaSchedule::untilContention((uint32_t)netMs, TDMA_MAX_GUARD_MS) * 1000;
+}
+
+// Lets a node run until its next blocking call.
+void Simulation::resume(int node, const uint8_t* data, uint16_t len) {
+    Node& n = nodes[node];
+    n.wait = WAIT_NONE;
+    n.token++;
+    grant(node, data, len);
+
+    SimHeader header;
+    uint8_t payload[SIM_MAX_PAYLOAD];
+    for (;;) {
+        if (!readMessage(node, header, payload)) {
+            fprintf(stderr, "node %u exited unexpectedly\n", n.id);
+            n.alive = false;
+            return;
+        }
+        switch (header.op) {
+          case SIM_SEND: {
+            uint8_t dest = payload[0];
+            int onlyTo = -1;
+            n.sendStatus = RH_ROUTER_ERROR_NONE;
+            if (dest != RH_BROADCAST_ADDRESS) {
+                onlyTo = dest - 1;
+                if (onlyTo < 0 || onlyTo > nodeCount || !hears[onlyTo][node]) {
+                    n.sendStatus = RH_ROUTER_ERROR_NO_ROUTE;  // route discovery is not modelled
+                    grant(node, &n.sendStatus, 1);
+                    break;
+                }
+            }
+            size_t index = transmit(node, payload + 1, header.len - 1, onlyTo);
+            n.wait = WAIT_SEND;
+            scheduleWake(node, txs[index - txBase].end);
+            return;
+          }
+          case SIM_RECV: {
+            if (!n.inbox.empty()) {
+                Frame frame = n.inbox.front();
+                n.inbox.pop_front();
+                uint8_t out[2 + 255];
+                out[0] = 1;
+                out[1] = frame.from;
+                memcpy(out + 2, frame.bytes.data(), frame.bytes.size());
+                grant(node, out, (uint16_t)(2 + frame.bytes.size()));
+                break;
+            }
+            uint16_t timeout;
+            memcpy(&timeout, payload, sizeof(timeout));
+            n.wait = WAIT_RECV;
+            scheduleWake(node, now + (uint64_t)timeout * 1000);
+            return;
+          }
+          case SIM_DELAY: {
+            uint32_t ms;
+            memcpy(&ms, payload, sizeof(ms));
+            n.wait = WAIT_DELAY;
+            scheduleWake(node, now + (uint64_t)ms * 1000);
+            return;
+          }
+          case SIM_SLEEP: {
+            if (!n.inbox.empty()) {
+                uint8_t byRadio = 1;   // a frame is already waiting, AUX is low
+                grant(node, &byRadio, 1);
+                break;
+            }
+            uint32_t ms;
+            memcpy(&ms, payload, sizeof(ms));
+            n.wait = WAIT_SLEEP;
+            n.sleepStartUs = now;
+            scheduleWake(node, now + (uint64_t)ms * 1000);
+            return;
+          }
+          case SIM_EVENT_PIN:
+            if (payload[0] == RLYPIN && payload[1] == HIGH && n.relayOnUs < 0) {
+                n.relayOnUs = (int64_t)now;
+            }
+            break;
+          case SIM_EVENT_DEAD:
+            onDead(node, payload[0]);
+            break;
+          case SIM_EVENT_CONFIG: {
+            uint32_t digest;
+            memcpy(&digest, payload, sizeof(digest));
+            onConfig(node, digest);
+            break;
+          }
+          case SIM_EVENT_XFER:
+            if (payload[0]) result.transfersOk++;
+            else result.transfersFailed++;
+            break;
+          case SIM_LOG:
+            printf("%10.3f  node %3u  %.*s\n", now / 1e6, n.id, (int)header.len, (const char*)payload);
+            break;
+          default:
+            break;
+        }
+    }
+}
+
+static double percentile(std::vector<double> values, double p) {
+    if (values.empty()) return NAN;
+    std::sort(values.begin(), values.end());
+    size_t index = (size_t)std::ceil(p / 100.0 * values.size());
+    if (index > 0) index--;
+    return values[std::min(index, values.size() - 1)];
+}
+
+SimResult Simulation::run() {
+    result.nodes = nodeCount;
+    maxAirUs = airtimeUs(RH_MESH_MAX_MESSAGE_LEN);
+    buildTopology();
+    spawnNodes();
+
+    uint64_t end = (uint64_t)(opt.durationS * 1e6);
+    schedule((uint64_t)(opt.alarmAtS * 1e6), EV_ALARM, 0);
+    if (opt.kill > 0) schedule((uint64_t)(opt.killAtS * 1e6), EV_KILL, 0);
+
+    while (!events.empty() && events.top().time <= end) {
+        Event ev = events.top();
+        events.pop();
+        now = ev.time;
+
+        switch (ev.type) {
+          case EV_WAKE: {
+            Node& n = nodes[ev.node];
+            if (ev.token != n.token || !n.alive) break;
+            if (n.wait == WAIT_SEND) {
+                uint8_t status = n.sendStatus;
+                resume(ev.node, &status, 1);
+            }
+            else if (n.wait == WAIT_RECV) {
+                uint8_t timedOut = 0;
+                resume(ev.node, &timedOut, 1);
+            }
+            else if (n.wait == WAIT_SLEEP) {
+                n.sleptUs += now - n.sleepStartUs;
+                uint8_t byTimer = 0;
+                resume(ev.node, &byTimer, 1);
+            }
+            else {
+                resume(ev.node, nullptr, 0);
+            }
+            break;
+          }
+          case EV_DELIVER:
+            deliver(ev.tx, ev.node);
+            break;
+          case EV_ALARM: {
+            uint64_t wait = ev.token == 0 ? untilAlarmSlotUs() : 0;
+            if (wait > 0) {
+                schedule(now + wait, EV_ALARM, 0, 1);
+                break;
+            }
+            // The FyreBox controller's activation command (text, NUL included, as the nodes send theirs).
+            static const char alarm[] = "Active";
+            transmit(0, (const uint8_t*)alarm, sizeof(alarm), -1);
+            for (int i = 1; i <= nodeCount; i++) {
+                if (nodes[i].alive) result.alarmTargets++;
+            }
+            break;
+          }
+          case EV_KILL: {
+            std::vector<int> candidates;
+            for (int i = 1; i <= nodeCount; i++) if (nodes[i].alive) candidates.push_back(i);
+            std::shuffle(candidates.begin(), candidates.end(), rng);
+            killTimeUs = now;
+            for (int k = 0; k < opt.kill && k < (int)candidates.size(); k++) {
+                Node& n = nodes[candidates[k]];
+                n.alive = false;
+                killed.insert(n.id);
+                kill(n.pid, SIGKILL);
+                for (int o = 1; o <= nodeCount; o++) {
+                    // Neighbours that hear the node's beacons are expected to notice.
+                    if (o != candidates[k] && hears[o][candidates[k]]) result.deadExpected++;
+                }
+            }
+            break;
+          }
+        }
+
+        // Frames that ended more than one maximum airtime ago can no longer overlap anything pending.
+        while (!txs.empty() && txs.front().end + maxAirUs < now) {
+            txs.pop_front();
+            txBase++;
+        }
+    }
+    stopNodes();
+
+    double duration = opt.durationS * 1e6;
+    result.utilisation /= duration;
+    double sum = 0;
+    for (int i = 0; i <= nodeCount; i++) {
+        double load = nodes[i].heardAirUs / duration;
+        sum += load;
+        result.neighbourhoodMax = std::max(result.neighbourhoodMax, load);
+    }
+    result.neighbourhoodMean = sum / (nodeCount + 1);
+
+    uint64_t alarmUs = (uint64_t)(opt.alarmAtS * 1e6);
+    for (int i = 1; i <= nodeCount; i++) {
+        if (nodes[i].relayOnUs >= (int64_t)alarmUs) {
+            result.alarmReached++;
+            result.alarmLatencyS.push_back((nodes[i].relayOnUs - (int64_t)alarmUs) / 1e6);
+        }
+    }
+    for (auto& d : detections) {
+        result.deadDetectS.push_back(d.second);
+    }
+    std::set<int> roots;
+    for (int i = 1; i <= nodeCount; i++) {
+        if (!nodes[i].alive || killed.count(nodes[i].id) != 0) continue;
+        if (nodes[i].lastRoot >= 0) roots.insert(nodes[i].lastRoot);
+        if (!configWritten || i == configWriter) continue;
+        result.configTargets++;
+        if (nodes[i].configUs >= 0) {
+            result.configReached++;
+            result.configLatencyS.push_back((nodes[i].configUs - (int64_t)configWriteUs) / 1e6);
+        }
+    }
+    result.rootsAtEnd = (int)roots.size();
+
+    // The controller does not pass on time, so only escalator links join islands.
+    std::vector<int> island(nodeCount + 1, -1);
+    for (int i = 1; i <= nodeCount; i++) {
+        if (!nodes[i].alive || killed.count(nodes[i].id) != 0 || island[i] >= 0) continue;
+        std::vector<int> stack = { i };
+        island[i] = result.islandsAtEnd++;
+        while (!stack.empty()) {
+            int a = stack.back();
+            stack.pop_back();
+            for (int b = 1; b <= nodeCount; b++) {
+                if (island[b] < 0 && hears[a][b] && nodes[b].alive && killed.count(nodes[b].id) == 0) {
+                    island[b] = island[i];
+                    stack.push_back(b);
+                }
+            }
+        }
+    }
+    estimatePower(end);
+    return result;
+}
+
+// Charges every node that stayed up for its time awake, asleep and on the air.
+void Simulation::estimatePower(uint64_t end) {
+    double awakeSum = 0, currentSum = 0;
+    int counted = 0;
+    for (int i = 1; i <= nodeCount; i++) {
+        Node& n = nodes[i];
+        if (killed.count(n.id) != 0 || end <= n.bootUs) continue;
+        if (n.wait == WAIT_SLEEP) n.sleptUs += end - n.sleepStartUs;
+        double up = (double)(end - n.bootUs);
+        double asleep = std::min((double)n.sleptUs, up);
+        double awake = up - asleep;
+        double sent = std::min((double)n.sentAirUs, awake);
+        double sniff = WAKE_PERIOD_MS > 0 ? opt.sniffMs / WAKE_PERIOD_MS : 0;
+        double charge = awake * opt.awakeMa + asleep * opt.sleepMa              // ESP32
+                      + (awake - sent) * opt.rxMa + sent * opt.txMa              // E32 awake
+                      + asleep * sniff * opt.rxMa + std::min((double)n.heardAsleepUs, asleep) * opt.rxMa;
+        double meanMa = charge / up;
+        awakeSum += awake / up;
+        currentSum += meanMa;
+        result.currentMaxMa = std::max(result.currentMaxMa, meanMa);
+        counted++;
+    }
+    if (counted > 0) {
+        result.awakeFraction = awakeSum / counted;
+        result.currentMeanMa = currentSum / counted;
+    }
+}
+
+static void printResult(const SimOptions& opt, const SimResult& r, bool header) {
+    if (opt.csv) {
+        if (header) {
+            printf("nodes,frames,deliveries,collisions,lost,inbox_drops,utilisation,"
+                   "load_mean,load_max,alarm_reached,alarm_targets,alarm_p50_s,alarm_p90_s,alarm_p99_s,alarm_max_s,"
+                   "dead_detected,dead_expected,dead_p50_s,dead_p90_s,dead_max_s,false_dead,"
+                   "wake_period_ms,awake_frac,current_mean_ma,current_max_ma,"
+                   "config_reached,config_targets,config_p50_s,config_max_s,xfer_ok,xfer_failed,xfer_frames,"
+                   "sync_err_p50_ms,sync_err_p99_ms,sync_err_max_ms,bound_violations,roots,islands\n");
+        }
+        printf("%d,%llu,%llu,%llu,%llu,%llu,%.4f,%.4f,%.4f,%d,%d,%.3f,%.3f,%.3f,%.3f,%zu,%d,%.3f,%.3f,%.3f,%llu,"
+               "%u,%.4f,%.3f,%.3f,%d,%d,%.3f,%.3f,%llu,%llu,%llu,%.1f,%.1f,%.1f,%llu,%d,%d\n",
+               r.nodes, (unsigned long long)r.frames, (unsigned long long)r.deliveries,
+               (unsigned long long)r.collisions, (unsigned long long)r.lost, (unsigned long long)r.inboxDrops,
+               r.utilisation, r.neighbourhoodMean, r.neighbourhoodMax, r.alarmReached, r.alarmTargets,
+               percentile(r.alarmLatencyS, 50), percentile(r.alarmLatencyS, 90),
+               percentile(r.alarmLatencyS, 99), percentile(r.alarmLatencyS, 100),
+               r.deadDetectS.size(), r.deadExpected, percentile(r.deadDetectS, 50),
+               percentile(r.deadDetectS, 90), percentile(r.deadDetectS, 100), (unsigned long long)r.falseDead,
+               (unsigned)WAKE_PERIOD_MS, r.awakeFraction, r.currentMeanMa, r.currentMaxMa,
+               r.configReached, r.configTargets, percentile(r.configLatencyS, 50), percentile(r.configLatencyS, 100),
+               (unsigned long long)r.transfersOk, (unsigned long long)r.transfersFailed,
+               (unsigned long long)r.transportFrames, percentile(r.syncErrorMs, 50), percentile(r.syncErrorMs, 99),
+               percentile(r.syncErrorMs, 100), (unsigned long long)r.boundViolations, r.rootsAtEnd, r.islandsAtEnd);
+        return;
+    }
+    printf("Nodes: %d (%s topology)\n", r.nodes, opt.topology.c_str());
+    printf("  Frames sent: %llu, delivered: %llu, collided: %llu, lost: %llu, inbox drops: %llu\n",
+           (unsigned long long)r.frames, (unsigned long long)r.deliveries, (unsigned long long)r.collisions,
+           (unsigned long long)r.lost, (unsigned long long)r.inboxDrops);
+    printf("  Channel utilisation: %.2f%% of airtime, load heard per node mean %.3f max %.3f Erlang\n",
+           r.utilisation * 100, r.neighbourhoodMean, r.neighbourhoodMax);
+    printf("  Alarm reached %d/%d nodes, latency p50 %.2fs p90 %.2fs p99 %.2fs max %.2fs\n",
+           r.alarmReached, r.alarmTargets, percentile(r.alarmLatencyS, 50), percentile(r.alarmLatencyS, 90),
+           percentile(r.alarmLatencyS, 99), percentile(r.alarmLatencyS, 100));
+    printf("  Dead node detected by %zu/%d neighbours, after p50 %.1fs p90 %.1fs max %.1fs; false deaths: %llu\n",
+           r.deadDetectS.size(), r.deadExpected, percentile(r.deadDetectS, 50), percentile(r.deadDetectS, 90),
+           percentile(r.deadDetectS, 100), (unsigned long long)r.falseDead);
+    printf("  Config reached %d/%d nodes after p50 %.1fs max %.1fs; transfers %llu ok, %llu failed, %llu frames\n",
+           r.configReached, r.configTargets, percentile(r.configLatencyS, 50), percentile(r.configLatencyS, 100),
+           (unsigned long long)r.transfersOk, (unsigned long long)r.transfersFailed,
+           (unsigned long long)r.transportFrames);
+    printf("  Time sync error p50 %.1f ms p99 %.1f ms max %.1f ms, %llu beyond the claimed bound; %d root(s) "
+           "in %d island(s) at the end\n",
+           percentile(r.syncErrorMs, 50), percentile(r.syncErrorMs, 99), percentile(r.syncErrorMs, 100),
+           (unsigned long long)r.boundViolations, r.rootsAtEnd, r.islandsAtEnd);
+    printf("  Power: wake-up period %u ms, awake %.1f%% of the time, current mean %.2f mA max %.2f mA (nominal)\n",
+           (unsigned)WAKE_PERIOD_MS, r.awakeFraction * 100, r.currentMeanMa, r.currentMaxMa);
+}
+
+static std::vector<int> parseList(const char* s) {
+    std::vector<int> out;
+    while (*s) {
+        out.push_back(atoi(s));
+        const char* comma = strchr(s, ',');
+        if (!comma) break;
+        s = comma + 1;
+    }
+    return out;
+}
+
+int main(int argc, char** argv) {
+    SimOptions opt;
+    for (int i = 1; i < argc; i++) {
+        std::string a = argv[i];
+        const char* v = i + 1 < argc ? argv[i + 1] : "";
+        if (a == "--nodes") { opt.nodes = atoi(v); i++; }
+        else if (a == "--sweep") { opt.sweep = parseList(v); i++; }
+        else if (a == "--topology") { opt.topology = v; i++; }
+        else if (a == "--degree") { opt.degree = atof(v); i++; }
+        else if (a == "--loss") { opt.loss = atof(v); i++; }
+        else if (a == "--distance-loss") { opt.distanceLoss = true; }
+        else if (a == "--air-rate") { opt.airRate = atof(v); i++; }
+        else if (a == "--preamble") { opt.preambleMs = atof(v); i++; }
+        else if (a == "--duration") { opt.durationS = atof(v); i++; }
+        else if (a == "--alarm-at") { opt.alarmAtS = atof(v); i++; }
+        else if (a == "--kill") { opt.kill = atoi(v); i++; }
+        else if (a == "--kill-at") { opt.killAtS = atof(v); i++; }
+        else if (a == "--boot-spread") { opt.bootSpreadS = atof(v); i++; }
+        else if (a == "--config-at") { opt.configAtS = atof(v); i++; }
+        else if (a == "--seed") { opt.seed = (uint32_t)atoi(v); i++; }
+        else if (a == "--currents") {
+            if (sscanf(v, "%lf,%lf,%lf,%lf", &opt.awakeMa, &opt.sleepMa, &opt.rxMa, &opt.txMa) != 4) {
+                fprintf(stderr, "--currents takes four values in mA\n");
+                return 2;
+            }
+            i++;
+        }
+        else if (a == "--sniff") { opt.sniffMs = atof(v); i++; }
+        else if (a == "--csv") { opt.csv = true; }
+        else if (a == "--verbose") { opt.verbose = true; }
+        else {
+            fprintf(stderr, "unknown option %s (see the header of tools/meshsim/meshsim.cpp)\n", a.c_str());
+            return 2;
+        }
+    }
+    if (opt.sweep.empty()) opt.sweep.push_back(opt.nodes);
+
+    signal(SIGPIPE, SIG_IGN);
+    bool header = true;
+    for (int n : opt.sweep) {
+        if (n < 1 || n > 250) {
+            fprintf(stderr, "node count must be 1..250\n");
+            return 2;
+        }
+        Simulation sim(opt, n);
+        SimResult r = sim.run();
+        printResult(opt, r, header);
+        header = false;
+        fflush(stdout);
+    }
+    return 0;
+}
@@ -0,0 +1,198 @@
+/*
+ Project Name ------  FRS
+ Task --------------  Escalator Node Firmware with Esp32
+ Engineer ----------- Muhammad Usman
+ File --------------- Mesh Simulator Node Source File
+ Company -----------  Machadev Pvt Limited
+ */
+
+// Import Libraries
+#include <Arduino.h>
+#include <unistd.h>
+#include "functions.h"
+#include "sim_protocol.h"
+#include "sim_node.h"
+
+// Node side of the simulator: runs in a forked process, one per node, and
+// turns every host hook into a message to the coordinator.
+
+static int simFd = -1;
+static uint8_t simNodeId = 0;
+static bool simVerbose = false;
+static uint64_t simNowUs = 0;
+static uint64_t simBootUs = 0;   // millis() counts from the node's own power-up
+static uint64_t simSiteWriteUs = 0;
+static std::string lineBuffer;
+
+extern ConfigStore siteConfig;  // functions.cpp
+
+// Writes a whole buffer; the coordinator going away ends the node.
+static void writeAll(const void* data, size_t len) {
+    const uint8_t* p = (const uint8_t*)data;
+    while (len > 0) {
+        ssize_t n = write(simFd, p, len);
+        if (n <= 0) _exit(0);
+        p += n;
+        len -= (size_t)n;
+    }
+}
+
+static void readAll(void* data, size_t len) {
+    uint8_t* p = (uint8_t*)data;
+    while (len > 0) {
+        ssize_t n = read(simFd, p, len);
+        if (n <= 0) _exit(0);
+        p += n;
+        len -= (size_t)n;
+    }
+}
+
+static void sendMessage(uint8_t op, const void* payload, uint16_t len) {
+    SimHeader header = { op, len };
+    writeAll(&header, sizeof(header));
+    if (len > 0) writeAll(payload, len);
+}
+
+// Blocks until the coordinator resumes this node; returns the result length.
+static uint16_t waitGrant(uint8_t* result, uint16_t cap) {
+    SimHeader header;
+    readAll(&header, sizeof(header));
+    uint8_t payload[SIM_MAX_PAYLOAD];
+    readAll(payload, header.len);
+    memcpy(&simNowUs, payload, sizeof(simNowUs));
+    uint16_t resultLen = header.len - sizeof(simNowUs);
+    if (resultLen > cap) resultLen = cap;
+    if (result != nullptr) memcpy(result, payload + sizeof(simNowUs), resultLen);
+    return resultLen;
+}
+
+static void sendConfigDigest() {
+    uint32_t digest = siteConfig.digest();
+    sendMessage(SIM_EVENT_CONFIG, &digest, sizeof(digest));
+}
+
+// Writes the company record the way the portal wizard does, once its time
+// has come; the values are long enough to take several transport windows.
+static void pollSiteWrite() {
+    if (simSiteWriteUs == 0 || simNowUs < simSiteWriteUs) {
+        return;
+    }
+    simSiteWriteUs = 0;
+    for (uint8_t field = CFG_COMPANY_NAME; field <= CFG_FIRE_DEPARTMENT_CONTACT; field++) {
+        char value[CONFIG_VALUE_MAX];
+        snprintf(value, sizeof(value), "Field %u written on node %u at %.1f s, padded to a realistic length",
+                 field, simNodeId, simNowUs / 1e6);
+        updateConfigField((ConfigField)field, value);
+    }
+    persistSiteConfig();
+    sendConfigDigest();
+}
+
+uint64_t hostMicros() {
+    return simNowUs - simBootUs;
+}
+
+void hostDelay(uint32_t ms) {
+    sendMessage(SIM_DELAY, &ms, sizeof(ms));
+    waitGrant(nullptr, 0);
+}
+
+bool hostLightSleep(uint32_t ms) {
+    pollSiteWrite();
+    sendMessage(SIM_SLEEP, &ms, sizeof(ms));
+    uint8_t byRadio = 0;
+    waitGrant(&byRadio, 1);
+    return byRadio != 0;
+}
+
+void hostDigitalWrite(uint8_t pin, uint8_t value) {
+    uint8_t payload[2] = { pin, value };
+    sendMessage(SIM_EVENT_PIN, payload, sizeof(payload));
+}
+
+// Console output is cut into lines; dead-node reports from checkNodeActivity(),
+// merged config deltas and finished transfers become events, everything else
+// is forwarded only in verbose mode.
+void hostSerialWrite(const uint8_t* data, size_t len) {
+    for (size_t i = 0; i < len; i++) {
+        char c = (char)data[i];
+        if (c == '\r') continue;
+        if (c != '\n') {
+            lineBuffer += c;
+            continue;
+        }
+        unsigned dead = 0;
+        int merged = 0;
+        unsigned peer = 0;
+        char outcome[16] = "";
+        if (sscanf(lineBuffer.c_str(), "Node %u is now considered dead", &dead) == 1) {
+            uint8_t id = (uint8_t)dead;
+            sendMessage(SIM_EVENT_DEAD, &id, 1);
+        }
+        else if (sscanf(lineBuffer.c_str(), "Merged %d config fields", &merged) == 1 && merged > 0) {
+            sendConfigDigest();
+        }
+        else if (sscanf(lineBuffer.c_str(), "Payload to node %u %15s", &peer, outcome) == 2) {
+            uint8_t ok = strcmp(outcome, "delivered") == 0;
+            sendMessage(SIM_EVENT_XFER, &ok, 1);
+        }
+        if (simVerbose) {
+            sendMessage(SIM_LOG, lineBuffer.data(), (uint16_t)lineBuffer.size());
+        }
+        lineBuffer.clear();
+    }
+}
+
+uint8_t hostRadioAddress() {
+    return simNodeId;
+}
+
+uint8_t hostRadioSend(const uint8_t* buf, uint8_t len, uint8_t dest) {
+    uint8_t payload[1 + 255];
+    payload[0] = dest;
+    memcpy(payload + 1, buf, len);
+    sendMessage(SIM_SEND, payload, (uint16_t)(1 + len));
+    uint8_t status = RH_ROUTER_ERROR_UNABLE_TO_DELIVER;
+    waitGrant(&status, 1);
+    return status;
+}
+
+bool hostRadioRecv(uint8_t* buf, uint8_t* len, uint16_t timeout, uint8_t* from) {
+    pollSiteWrite();
+    sendMessage(SIM_RECV, &timeout, sizeof(timeout));
+    uint8_t result[2 + 255];
+    uint16_t n = waitGrant(result, sizeof(result));
+    if (n < 2 || result[0] == 0) {
+        return false;
+    }
+    uint8_t frameLen = (uint8_t)(n - 2);
+    if (frameLen > *len) frameLen = *len;
+    memcpy(buf, result + 2, frameLen);
+    *len = frameLen;
+    *from = result[1];
+    return true;
+}
+
+// Entry point of a forked node process: boots like setup() does, without
+// the portal, and then runs the unmodified LoRatask() loop until the
+// coordinator goes away.
+void simNodeMain(int fd, uint8_t nodeId, bool verbose, uint64_t siteWriteUs) {
+    simFd = fd;
+    simNodeId = nodeId;
+    simVerbose = verbose;
+    simSiteWriteUs = siteWriteUs;
+
+    waitGrant(nullptr, 0);  // the node's boot time
+    simBootUs = simNowUs;
+    initializeSiteStore();
+    initializeJournal();
+    initializeRelays();
+    initializeLoRaLink();
+    while (!initializeMESH()) {
+        delay(3000);
+    }
+    initializeLowPower();
+    startLowPowerSleep();   // simulated escalators are on backup power; a no-op without FRS_WAKE_LATENCY_MS
+    LoRatask(nullptr);
+    _exit(0);
+}
@@ -0,0 +1,26 @@
+/*
+ Project Name ------  FRS
+ Task --------------  Escalator Node Firmware with Esp32
+ Engineer ----------- Muhammad Usman
+ File --------------- Mesh Simulator Node Header File
+ Company -----------  Machadev Pvt Limited
+ */
+
+// sim_node.h
+#ifndef SIM_NODE_H
+#define SIM_NODE_H
+
+#include <stdint.h>
+
+/**
+ * @brief Runs one simulated node in the current (forked) process.
+ *
+ * @param fd The node's end of the socketpair to the coordinator.
+ * @param nodeId The mesh address of the node.
+ * @param verbose Forward every console line to the coordinator.
+ * @param siteWriteUs Virtual time at which the node writes the company
+ *        record as the portal would, or 0 for never.
+ */
+[[noreturn]] void simNodeMain(int fd, uint8_t nodeId, bool verbose, uint64_t siteWriteUs);
+
+#endif // SIM_NODE_H
@@ -0,0 +1,45 @@
+/*
+ Project Name ------  FRS
+ Task --------------  Escalator Node Firmware with Esp32
+ Engineer ----------- Muhammad Usman
+ File --------------- Mesh Simulator Protocol Header File
+ Company -----------  Machadev Pvt Limited
+ */
+
+// sim_protocol.h
+#ifndef SIM_PROTOCOL_H
+#define SIM_PROTOCOL_H
+
+#include <stdint.h>
+
+/*
+ Messages between the coordinator and one node process over a socketpair.
+ Every message is a SimHeader followed by len payload bytes.
+
+ A node only runs while the coordinator waits for it. It runs until it
+ makes a blocking request (SEND, RECV, DELAY, SLEEP), and then waits
+ for the GRANT that resumes it at a later virtual time. EVENT and LOG
+ messages do not block.
+*/
+
+enum SimOp : uint8_t {
+    SIM_GRANT,        // coord -> node: [now_us u64][result...]
+    SIM_SEND,         // node -> coord: [dest][frame...]            grant: [status]
+    SIM_RECV,         // node -> coord: [timeout_ms u16]            grant: [ok][from][frame...]
+    SIM_DELAY,        // node -> coord: [ms u32]                    grant: -
+    SIM_SLEEP,        // node -> coord: [ms u32]                    grant: [woken by a frame]
+    SIM_EVENT_PIN,    // node -> coord: [pin][value]
+    SIM_EVENT_DEAD,   // node -> coord: [dead node id]
+    SIM_EVENT_CONFIG, // node -> coord: [config digest u32], after a local write or a merged delta
+    SIM_EVENT_XFER,   // node -> coord: [ok], an outbound transfer finished
+    SIM_LOG,          // node -> coord: [text...]
+};
+
+struct __attribute__((packed)) SimHeader {
+    uint8_t op;
+    uint16_t len;
+};
+
+constexpr uint16_t SIM_MAX_PAYLOAD = 512;
+
+#endif // SIM_PROTOCOL_H
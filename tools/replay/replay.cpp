@@ -0,0 +1,365 @@
+/*
+ Project Name ------  FRS
+ Task --------------  Escalator Node Firmware with Esp32
+ Engineer ----------- Muhammad Usman
+ File --------------- Trace Replay Source File
+ Company -----------  Machadev Pvt Limited
+
+Deterministic replay of a radio trace (src/radio_trace.h) through the
+node code:
+
+- The unmodified node sources in src/ boot as in setup() and run
+  LoRatask() against the host shims, as in the mesh simulator. The
+  address is the node ID from the trace header.
+- Time is virtual and starts at the first record, so millis() reads the
+  same values the node saw in the field.
+- Each received frame in the trace is handed to the node by the first
+  recvfromAckTimeout() whose timeout reaches its timestamp. It is
+  delivered late if the node was busy sending at that moment.
+- Each frame the node sends is matched against the sent frames of the
+  trace, in order. A match answers with the recorded RHRouter status and
+  takes the recorded send time. A frame with no match succeeds at once.
+  Frames match on destination, length and message type. Those with
+  identical bytes are counted separately, because beacons carry
+  timestamps that move with any timing change.
+- The replay ends --tail seconds after the last record. It reports how
+  far the node's sends diverged from the trace and the CPU time spent in
+  the node code.
+
+The same trace always gives the same result, so two builds can be
+compared on real site traffic, and a field incident can be stepped
+through with --verbose.
+
+Capture and run:
+
+  curl -o trace.bin http://<node>/trace
+  pio run -e replay
+  .pio/build/replay/program --trace trace.bin
+
+Options:
+
+  --trace FILE       trace dump from GET /trace (required)
+  --node N           replay as node N instead of the node in the header
+  --tail S           seconds to run after the last record (default 5)
+  --out FILE         write the trace the replayed node recorded itself
+  --csv              machine-readable output
+  --verbose          print the node's console output
+ */
+
+// Import Libraries
+#include <Arduino.h>
+#include <chrono>
+#include <string>
+#include <vector>
+#include <RHMesh.h>
+#include "functions.h"
+#include "dispatch.h"
+#include "radio_trace.h"
+
+extern WebServer server;
+extern MessageDispatcher dispatcher;
+
+struct ReplayOptions {
+    std::string tracePath;
+    std::string outPath;
+    int node = -1;
+    double tailS = 5;
+    bool csv = false;
+    bool verbose = false;
+};
+
+struct TraceFrame {
+    TraceRecord record;
+    std::vector<uint8_t> data;
+};
+
+// Sends are matched against at most this many recorded sends ahead of the expected one.
+static constexpr size_t TX_LOOKAHEAD = 8;
+
+static ReplayOptions opt;
+static TraceFileHeader traceHeader;
+static std::vector<TraceFrame> rxFrames;
+static std::vector<TraceFrame> txFrames;
+static size_t nextRx = 0;
+static size_t nextTx = 0;
+static uint64_t nowUs = 0;
+static uint64_t startUs = 0;
+static uint64_t endUs = 0;
+
+struct ReplayStats {
+    uint64_t rxDelayUs = 0;     // how late frames were handed over, summed
+    uint64_t rxDelayMaxUs = 0;
+    uint32_t txSent = 0;
+    uint32_t txIdentical = 0;
+    uint32_t txMatched = 0;     // same destination, length and type, bytes differ
+    uint32_t txMissing = 0;     // recorded, never sent by the replay
+    uint32_t txExtra = 0;       // sent by the replay, not in the trace
+    uint64_t txSkewUs = 0;      // |replay send time - recorded send time|, summed over matches
+    uint64_t txSkewMaxUs = 0;
+};
+static ReplayStats stats;
+
+// Node CPU time: the wall time between a hook returning and the next one being entered.
+typedef std::chrono::steady_clock Clock;
+static Clock::time_point nodeResumed;
+static Clock::duration nodeCpu(0);
+
+static void enterHook() { nodeCpu += Clock::now() - nodeResumed; }
+static void leaveHook() { nodeResumed = Clock::now(); }
+
+static bool loadTrace(const std::string& path) {
+    FILE* f = fopen(path.c_str(), "rb");
+    if (f == nullptr) {
+        fprintf(stderr, "cannot open %s\n", path.c_str());
+        return false;
+    }
+    if (fread(&traceHeader, sizeof(traceHeader), 1, f) != 1 || traceHeader.magic != TRACE_MAGIC) {
+        fprintf(stderr, "%s is not a radio trace\n", path.c_str());
+        fclose(f);
+        return false;
+    }
+    if (traceHeader.version != TRACE_VERSION) {
+        fprintf(stderr, "%s has trace version %u, this build reads %u\n", path.c_str(), traceHeader.version,
+                TRACE_VERSION);
+        fclose(f);
+        return false;
+    }
+    TraceFrame frame;
+    while (fread(&frame.record, sizeof(frame.record), 1, f) == 1) {
+        frame.data.resize(frame.record.len);
+        if (frame.record.len > 0 && fread(frame.data.data(), frame.record.len, 1, f) != 1) {
+            fprintf(stderr, "warning: %s ends inside a record\n", path.c_str());
+            break;
+        }
+        if (frame.record.kind == TRACE_RX) {
+            rxFrames.push_back(frame);
+        } else if (frame.record.kind == TRACE_TX) {
+            txFrames.push_back(frame);
+        }
+    }
+    fclose(f);
+    if (rxFrames.empty() && txFrames.empty()) {
+        fprintf(stderr, "%s holds no records\n", path.c_str());
+        return false;
+    }
+    return true;
+}
+
+static uint64_t recordUs(const TraceFrame& frame) {
+    return (uint64_t)frame.record.time * 1000;
+}
+
+static double ms(uint64_t us) {
+    return us / 1000.0;
+}
+
+static void printReport() {
+    double cpuUs = std::chrono::duration<double, std::micro>(nodeCpu).count();
+    size_t rxDelivered = nextRx;
+    double meanDelayMs = rxDelivered ? ms(stats.rxDelayUs) / rxDelivered : 0;
+    uint32_t txMatches = stats.txIdentical + stats.txMatched;
+    double meanSkewMs = txMatches ? ms(stats.txSkewUs) / txMatches : 0;
+    const DispatchStats& d = dispatcher.stats();
+
+    if (opt.csv) {
+        printf("node,rx_recorded,tx_recorded,dropped,rx_delivered,rx_delay_mean_ms,rx_delay_max_ms,"
+               "tx_sent,tx_identical,tx_matched,tx_missing,tx_extra,tx_skew_mean_ms,tx_skew_max_ms,"
+               "dispatched,unhandled,bad_length,nodes,cpu_us,cpu_us_per_rx\n");
+        printf("%u,%zu,%zu,%u,%zu,%.1f,%.1f,%u,%u,%u,%u,%u,%.1f,%.1f,%u,%u,%u,%zu,%.0f,%.2f\n",
+               hostRadioAddress(), rxFrames.size(), txFrames.size(), traceHeader.dropped, rxDelivered,
+               meanDelayMs, ms(stats.rxDelayMaxUs), stats.txSent, stats.txIdentical, stats.txMatched,
+               stats.txMissing, stats.txExtra, meanSkewMs, ms(stats.txSkewMaxUs), d.dispatched, d.unhandled,
+               d.badLength, getTotalNodes(), cpuUs, rxDelivered ? cpuUs / rxDelivered : 0.0);
+        return;
+    }
+    printf("Trace: node %u, %zu received and %zu sent frames over %.1f s, %u dropped before the dump\n",
+           traceHeader.node, rxFrames.size(), txFrames.size(), (endUs - startUs) / 1e6 - opt.tailS,
+           traceHeader.dropped);
+    printf("  Received: %zu delivered, late by %.1f ms mean, %.1f ms max\n", rxDelivered, meanDelayMs,
+           ms(stats.rxDelayMaxUs));
+    printf("  Sent: %u by the replay; %u identical, %u same type with other bytes, %u missing, %u extra\n",
+           stats.txSent, stats.txIdentical, stats.txMatched, stats.txMissing, stats.txExtra);
+    printf("  Send time off the trace by %.1f ms mean, %.1f ms max\n", meanSkewMs, ms(stats.txSkewMaxUs));
+    printf("  Dispatched %u, unhandled %u, bad length %u; %zu nodes in the table\n", d.dispatched, d.unhandled,
+           d.badLength, getTotalNodes());
+    printf("  Node CPU: %.0f us, %.2f us per received frame\n", cpuUs, rxDelivered ? cpuUs / rxDelivered : 0.0);
+}
+
+// The trace the node recorded during the replay, in the same format as GET /trace.
+static void writeOwnTrace() {
+    handleTraceGet();
+    FILE* f = fopen(opt.outPath.c_str(), "wb");
+    if (f == nullptr) {
+        fprintf(stderr, "cannot write %s\n", opt.outPath.c_str());
+        return;
+    }
+    fwrite(server.responseBody.data(), 1, server.responseBody.size(), f);
+    fclose(f);
+}
+
+[[noreturn]] static void finish() {
+    stats.txMissing += (uint32_t)(txFrames.size() - nextTx);
+    printReport();
+    if (!opt.outPath.empty()) {
+        writeOwnTrace();
+    }
+    fflush(stdout);
+    exit(0);
+}
+
+// Moves virtual time forward; the replay ends once it passes the tail.
+static void advance(uint64_t us) {
+    nowUs += us;
+    if (nowUs > endUs) {
+        finish();
+    }
+}
+
+uint64_t hostMicros() {
+    return nowUs;
+}
+
+void hostDelay(uint32_t ms) {
+    enterHook();
+    advance((uint64_t)ms * 1000);
+    leaveHook();
+}
+
+// Sleeps until the next recorded frame or the timer, whichever comes first.
+bool hostLightSleep(uint32_t ms) {
+    enterHook();
+    uint64_t until = nowUs + (uint64_t)ms * 1000;
+    bool byRadio = nextRx < rxFrames.size() && recordUs(rxFrames[nextRx]) <= until;
+    if (byRadio) {
+        uint64_t at = recordUs(rxFrames[nextRx]);
+        if (at > nowUs) advance(at - nowUs);
+    } else {
+        advance((uint64_t)ms * 1000);
+    }
+    leaveHook();
+    return byRadio;
+}
+
+void hostDigitalWrite(uint8_t, uint8_t) {}
+
+void hostSerialWrite(const uint8_t* data, size_t len) {
+    if (opt.verbose) {
+        fwrite(data, 1, len, stderr);
+    }
+}
+
+uint8_t hostRadioAddress() {
+    return opt.node >= 0 ? (uint8_t)opt.node : traceHeader.node;
+}
+
+static bool sameShape(const TraceFrame& expected, const uint8_t* buf, uint8_t len, uint8_t dest) {
+    return expected.record.peer == dest && expected.record.len == len && (len == 0 || expected.data[0] == buf[0]);
+}
+
+// Matches a send against the recorded ones and answers as the radio did in the field.
+uint8_t hostRadioSend(const uint8_t* buf, uint8_t len, uint8_t dest) {
+    enterHook();
+    stats.txSent++;
+    size_t found = txFrames.size();
+    for (size_t i = nextTx; i < txFrames.size() && i < nextTx + TX_LOOKAHEAD; i++) {
+        if (sameShape(txFrames[i], buf, len, dest)) {
+            found = i;
+            break;
+        }
+    }
+    uint8_t status = RH_ROUTER_ERROR_NONE;
+    if (found == txFrames.size()) {
+        stats.txExtra++;
+    } else {
+        const TraceFrame& expected = txFrames[found];
+        stats.txMissing += (uint32_t)(found - nextTx);
+        nextTx = found + 1;
+        if (memcmp(expected.data.data(), buf, len) == 0) {
+            stats.txIdentical++;
+        } else {
+            stats.txMatched++;
+        }
+        uint64_t at = recordUs(expected);
+        uint64_t skew = at > nowUs ? at - nowUs : nowUs - at;
+        stats.txSkewUs += skew;
+        if (skew > stats.txSkewMaxUs) stats.txSkewMaxUs = skew;
+        status = expected.record.status;
+        advance((uint64_t)expected.record.duration * 1000);
+    }
+    leaveHook();
+    return status;
+}
+
+// Hands over the next recorded frame if it arrives within the timeout.
+bool hostRadioRecv(uint8_t* buf, uint8_t* len, uint16_t timeout, uint8_t* from) {
+    enterHook();
+    uint64_t until = nowUs + (uint64_t)timeout * 1000;
+    if (nextRx == rxFrames.size() || recordUs(rxFrames[nextRx]) > until) {
+        advance((uint64_t)timeout * 1000);
+        leaveHook();
+        return false;
+    }
+    const TraceFrame& frame = rxFrames[nextRx++];
+    uint64_t at = recordUs(frame);
+    if (at > nowUs) {
+        advance(at - nowUs);
+    } else {
+        stats.rxDelayUs += nowUs - at;
+        if (nowUs - at > stats.rxDelayMaxUs) stats.rxDelayMaxUs = nowUs - at;
+    }
+    uint8_t n = frame.record.len < *len ? frame.record.len : *len;
+    memcpy(buf, frame.data.data(), n);
+    *len = n;
+    *from = frame.record.peer;
+    leaveHook();
+    return true;
+}
+
+int main(int argc, char** argv) {
+    for (int i = 1; i < argc; i++) {
+        std::string a = argv[i];
+        const char* v = i + 1 < argc ? argv[i + 1] : "";
+        if (a == "--trace") { opt.tracePath = v; i++; }
+        else if (a == "--node") { opt.node = atoi(v); i++; }
+        else if (a == "--tail") { opt.tailS = atof(v); i++; }
+        else if (a == "--out") { opt.outPath = v; i++; }
+        else if (a == "--csv") { opt.csv = true; }
+        else if (a == "--verbose") { opt.verbose = true; }
+        else {
+            fprintf(stderr, "unknown option %s (see the header of tools/replay/replay.cpp)\n", a.c_str());
+            return 2;
+        }
+    }
+    if (opt.tracePath.empty()) {
+        fprintf(stderr, "--trace FILE is required\n");
+        return 2;
+    }
+    if (!loadTrace(opt.tracePath)) {
+        return 1;
+    }
+    if (traceHeader.role != NODE_ROLE) {
+        fprintf(stderr, "warning: the trace is from a role %u node, this build is role %u\n", traceHeader.role,
+                NODE_ROLE);
+    }
+
+    uint32_t first = 0xFFFFFFFF;
+    uint32_t last = 0;
+    for (const std::vector<TraceFrame>* frames : { &rxFrames, &txFrames }) {
+        if (!frames->empty()) {
+            if (frames->front().record.time < first) first = frames->front().record.time;
+            if (frames->back().record.time > last) last = frames->back().record.time;
+        }
+    }
+    startUs = nowUs = (uint64_t)first * 1000;
+    endUs = (uint64_t)last * 1000 + (uint64_t)(opt.tailS * 1e6);
+
+    // Boots like setup() and runs LoRatask() until the trace is used up.
+    leaveHook();
+    initializeSiteStore();
+    initializeJournal();
+    initializeRelays();
+    initializeLoRaLink();
+    initializeMESH();
+    LoRatask(nullptr);
+    finish();
+}